@@ -0,0 +1,311 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup eventloop
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "diagnosis.h"
+#include "posix_internal_serialhandling.h"
+#include "systemutils.h"
+
+/* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
+#include "eventloop.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+/** every session waits for the responses of the CAPTURino on its own
+    event loop, the reader of a capturing session on another one */
+#define EVLP_MAX_INSTANCES  (24)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+#ifdef SYSU_VIRTUAL_CLOCK
+/** a wait on the virtual clock does not block, its timeout advances the clock
+    instead, see SYSU_SetVirtualMillis() */
+#define POLL_TIMEOUT_OF(timeoutMS)  (0)
+#else
+#define POLL_TIMEOUT_OF(timeoutMS)  (((timeoutMS) > INT_MAX) ? INT_MAX : (int)(timeoutMS))
+#endif
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+typedef struct
+{
+    bool isUsed;
+    int  wakeupReadFildes;  /**< read end of the self-pipe, polled together
+                                 with the serial port */
+    int  wakeupWriteFildes; /**< write end of the self-pipe, written to by
+                                 EVLP_Wakeup() */
+} EventLoopInstanceType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
+const EventLoopHandleType INVALID_EVENTLOOP_HANDLE = 0;
+
+/* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
+static const char* MODULE_NAME = "EVLP";
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+/* a static table is used instead of a linked list, as EVLP_Wakeup() must not
+   allocate or walk dynamic memory to stay async-signal-safe */
+static EventLoopInstanceType mEventLoops[EVLP_MAX_INSTANCES];
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * * */
+
+/* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static EventLoopInstanceType* getInstance(EventLoopHandleType eventLoopHandleVal)
+{
+    if (   (eventLoopHandleVal == INVALID_EVENTLOOP_HANDLE)
+        || (eventLoopHandleVal > EVLP_MAX_INSTANCES))
+    {
+        return NULL;
+    }
+    EventLoopInstanceType* instance = &mEventLoops[eventLoopHandleVal - 1];
+    return (instance->isUsed == true) ? instance : NULL;
+}
+
+static void drainWakeupPipe(const EventLoopInstanceType* instance)
+{
+    char drainBuf[16];
+    while (read(instance->wakeupReadFildes, drainBuf, sizeof(drainBuf)) > 0)
+    {
+        /* discard all pending wakeups, they are reported only once */
+    }
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int EVLP_Open(EventLoopHandleType* eventLoopHandleVal)
+{
+    DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
+
+    *eventLoopHandleVal = INVALID_EVENTLOOP_HANDLE;
+    size_t i;
+    for (i=0; i<EVLP_MAX_INSTANCES; i++)
+    {
+        if (mEventLoops[i].isUsed == false)
+        {
+            break;
+        }
+    }
+    if (i >= EVLP_MAX_INSTANCES)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "no free event loop instance available!");
+        return -1;
+    }
+
+    int pipeFildes[2];
+    if (pipe(pipeFildes) != 0)
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "unable to create the wakeup pipe, strerror() is \'%s\'", strerror(errno));
+        return -1;
+    }
+    /* both ends must be non-blocking: the reader drains it without blocking
+       and a wakeup from a signal handler must never block */
+    for (size_t j=0; j<2; j++)
+    {
+        int flags = fcntl(pipeFildes[j], F_GETFL);
+        fcntl(pipeFildes[j], F_SETFL, flags | O_NONBLOCK);
+        fcntl(pipeFildes[j], F_SETFD, FD_CLOEXEC);
+    }
+
+    mEventLoops[i].wakeupReadFildes = pipeFildes[0];
+    mEventLoops[i].wakeupWriteFildes = pipeFildes[1];
+    mEventLoops[i].isUsed = true;
+    *eventLoopHandleVal = (EventLoopHandleType)(i + 1);
+    return 0;
+}
+
+int EVLP_Close(EventLoopHandleType eventLoopHandleVal)
+{
+    DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
+
+    EventLoopInstanceType* instance = getInstance(eventLoopHandleVal);
+    if (instance == NULL)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid event loop handle");
+        return -1;
+    }
+    instance->isUsed = false;
+    close(instance->wakeupReadFildes);
+    close(instance->wakeupWriteFildes);
+    instance->wakeupReadFildes = -1;
+    instance->wakeupWriteFildes = -1;
+    return 0;
+}
+
+int EVLP_WaitSerial(EventLoopHandleType  eventLoopHandleVal,
+                    SerialHandleType     serialHandleVal,
+                    unsigned long        timeoutMS,
+                    EVLP_WaitResultType* result)
+{
+    EventLoopInstanceType* instance = getInstance(eventLoopHandleVal);
+    if (instance == NULL)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid event loop handle");
+        return -1;
+    }
+
+    int serialFildes;
+    if (SERH_GetFildes(serialHandleVal, &serialFildes) != 0)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid serial port handle");
+        return -1;
+    }
+
+    struct pollfd pollFildes[2] = {
+        { .fd = instance->wakeupReadFildes, .events = POLLIN, .revents = 0 },
+        { .fd = serialFildes,               .events = POLLIN, .revents = 0 }
+    };
+    int rvPoll = poll(pollFildes, 2, POLL_TIMEOUT_OF(timeoutMS));
+    if (rvPoll < 0)
+    {
+        if (errno == EINTR)
+        {
+            /* a signal handler has been executed, which is the usual way to
+               request the termination of the capture process */
+            *result = EVLP_WAKEUP;
+            return 0;
+        }
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "poll() failed, strerror() is \'%s\'", strerror(errno));
+        return -1;
+    }
+
+    if (pollFildes[0].revents & POLLIN)
+    {
+        drainWakeupPipe(instance);
+        *result = EVLP_WAKEUP;
+    }
+    else if (pollFildes[1].revents & (POLLIN | POLLERR | POLLHUP))
+    {
+        /* errors and hangups are reported as readable, so that the following
+           call to SERH_Read() reports the error to the caller */
+        *result = EVLP_READABLE;
+    }
+    else
+    {
+#ifdef SYSU_VIRTUAL_CLOCK
+        SYSU_AdvanceVirtualMillis(timeoutMS);
+#endif
+        *result = EVLP_TIMEOUT;
+    }
+    return 0;
+}
+
+int EVLP_Wait(EventLoopHandleType  eventLoopHandleVal,
+              unsigned long        timeoutMS,
+              EVLP_WaitResultType* result)
+{
+    EventLoopInstanceType* instance = getInstance(eventLoopHandleVal);
+    if (instance == NULL)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid event loop handle");
+        return -1;
+    }
+
+    struct pollfd pollFildes = {
+        .fd = instance->wakeupReadFildes, .events = POLLIN, .revents = 0
+    };
+    int rvPoll = poll(&pollFildes, 1, POLL_TIMEOUT_OF(timeoutMS));
+    if (rvPoll < 0)
+    {
+        if (errno == EINTR)
+        {
+            *result = EVLP_WAKEUP;
+            return 0;
+        }
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "poll() failed, strerror() is \'%s\'", strerror(errno));
+        return -1;
+    }
+
+    if (pollFildes.revents & POLLIN)
+    {
+        drainWakeupPipe(instance);
+        *result = EVLP_WAKEUP;
+    }
+    else
+    {
+#ifdef SYSU_VIRTUAL_CLOCK
+        SYSU_AdvanceVirtualMillis(timeoutMS);
+#endif
+        *result = EVLP_TIMEOUT;
+    }
+    return 0;
+}
+
+int EVLP_Wakeup(EventLoopHandleType eventLoopHandleVal)
+{
+    /* NOTE: no logging in here, as this function may be called from within a
+             signal handler */
+    EventLoopInstanceType* instance = getInstance(eventLoopHandleVal);
+    if (instance == NULL)
+    {
+        return -1;
+    }
+    const char wakeupChar = 'w';
+    ssize_t rvWrite = write(instance->wakeupWriteFildes, &wakeupChar, 1);
+    /* a full pipe already guarantees a pending wakeup */
+    return ((rvWrite == 1) || (errno == EAGAIN)) ? 0 : -1;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
@@ -0,0 +1,87 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef POSIX_INTERNAL_SERIALHANDLING_H_INCLUDED
+#define POSIX_INTERNAL_SERIALHANDLING_H_INCLUDED
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "serialhandling.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+
+/* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E C L A R A T I O N S * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * */
+
+/** Retrieves the POSIX file descriptor behind a serial port handle.
+ *
+ * \details this function is only intended to be used by other modules of the
+ *          POSIX compatibility layer, e.g. to wait for the file descriptor to
+ *          become readable.
+ *
+ * \param serialHandleVal [in] handle to an opened serial port.
+ * \param fildes [out] file descriptor of the serial port.
+ *
+ * \returns 0: if the file descriptor was retrieved successfully.
+ * \returns -1: if the handle is invalid.
+ */
+int SERH_GetFildes(SerialHandleType serialHandleVal,
+                   int*             fildes);
+
+/* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#endif /* POSIX_INTERNAL_SERIALHANDLING_H_INCLUDED */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
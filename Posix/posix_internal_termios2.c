@@ -0,0 +1,113 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#ifdef __linux__
+/* must not be combined with <termios.h> */
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+#endif
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+
+/* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
+#include "posix_internal_termios2.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
+
+/* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * * */
+
+/* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+#ifdef __linux__
+int TIO2_SetBaudrate(int fildes,
+                     unsigned int baudrate,
+                     unsigned int* actualBaudrate)
+{
+    struct termios2 commAttr;
+    if (ioctl(fildes, TCGETS2, &commAttr) != 0)
+    {
+        return -1;
+    }
+    commAttr.c_cflag &= ~CBAUD;
+    commAttr.c_cflag |= BOTHER;
+    commAttr.c_ospeed = baudrate;
+    /* the input speed follows the output speed */
+    commAttr.c_cflag &= ~(CBAUD << IBSHIFT);
+    commAttr.c_ispeed = 0;
+    if (ioctl(fildes, TCSETS2, &commAttr) != 0)
+    {
+        return -1;
+    }
+
+    /* the driver writes back the rate it actually generates */
+    if (ioctl(fildes, TCGETS2, &commAttr) != 0)
+    {
+        return -1;
+    }
+    *actualBaudrate = commAttr.c_ospeed;
+    return 0;
+}
+#endif
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
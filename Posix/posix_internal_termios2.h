@@ -0,0 +1,91 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef POSIX_INTERNAL_TERMIOS2_H_INCLUDED
+#define POSIX_INTERNAL_TERMIOS2_H_INCLUDED
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+
+/* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E C L A R A T I O N S * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * */
+
+#ifdef __linux__
+/** Sets an arbitrary baudrate through the termios2 interface of Linux.
+ *
+ * \details the struct termios of the C library only knows the baudrates of
+ *          the Bnnn constants. Its declarations conflict with the ones of the
+ *          termios2 interface, thus it is kept in a module of its own.
+ *
+ * \param fildes [in] file descriptor of an opened serial port.
+ * \param baudrate [in] the baudrate to be set.
+ * \param actualBaudrate [out] the baudrate the driver has set, which may be
+ *                             rounded to a rate the adapter can generate.
+ *
+ * \returns 0: if the baudrate was passed to the driver.
+ * \returns -1: if the driver rejected the baudrate, see errno.
+ */
+int TIO2_SetBaudrate(int           fildes,
+                     unsigned int  baudrate,
+                     unsigned int* actualBaudrate);
+#endif
+
+/* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#endif /* POSIX_INTERNAL_TERMIOS2_H_INCLUDED */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
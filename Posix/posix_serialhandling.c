@@ -41,15 +41,25 @@
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stdarg.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <termios.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <linux/serial.h>
+#endif
 
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
 #include "diagnosis.h"
 #include "linkedlist.h"
+#include "posix_internal_serialhandling.h"
+#include "posix_internal_termios2.h"
 
 /* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
 #include "serialhandling.h"
@@ -60,6 +70,10 @@
 
 /* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
 #define TEMP_BUF_SIZE   (512)
+/** maximum deviation of the baudrate generated by the adapter from the
+    requested one. The receiver of the device tolerates a few percent in
+    total, which is shared with its own clock error */
+#define MAX_BAUDRATE_DEVIATION_PERCENT  (2)
 
 /* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
 
@@ -73,6 +87,18 @@ typedef struct
     unsigned int baudrate;
     speed_t CFG_VAL;
 } BaudrateLutType;
+
+/** An opened serial port, the data of the elements in serialHandlesList */
+typedef struct
+{
+    int  fildes;
+    char ttyName[NAME_MAX + 1];     /**< name of the device node, e.g. ttyUSB0 */
+    /* settings found when the port was opened, restored on closing it */
+    bool latencyTimerChanged;
+    int  originalLatencyTimerMS;
+    bool lowLatencyChanged;
+    bool originalLowLatency;
+} SerialPortType;
 /* ***************************************************************************
  * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
  *************************************************************************** */
@@ -85,8 +111,8 @@ static const char* MODULE_NAME = "SERH";
 static const BaudrateLutType BAUDRATE_LUT[] =
 {
     { .baudrate =     50, .CFG_VAL =     B50 },
-    { .baudrate =     75, .CFG_VAL =     B50 },
-    { .baudrate =    110, .CFG_VAL =     B50 },
+    { .baudrate =     75, .CFG_VAL =     B75 },
+    { .baudrate =    110, .CFG_VAL =    B110 },
     { .baudrate =    150, .CFG_VAL =    B150 },
     { .baudrate =    200, .CFG_VAL =    B200 },
     { .baudrate =    300, .CFG_VAL =    B300 },
@@ -103,7 +129,8 @@ static const BaudrateLutType BAUDRATE_LUT[] =
 
 
 /* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
-static int mSerialFildes = -1;
+static unsigned int serialHandlesIndexCounter = 1;
+static LLST_ListEntryType* serialHandlesList = NULL;
 
 /* ***************************************************************************
  * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
@@ -114,6 +141,405 @@ static int mSerialFildes = -1;
 /* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
 
 /* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+#ifdef __linux__
+/** Reads a sysfs attribute, i.e. a file holding a single line. */
+static int readSysfsAttribute(const char* dirPath,
+                              const char* name,
+                              char* value,
+                              size_t valueSize)
+{
+    char attributePath[PATH_MAX];
+    int written = snprintf(attributePath, sizeof(attributePath), "%s/%s", dirPath, name);
+    if ((written < 0) || ((size_t)written >= sizeof(attributePath)))
+    {
+        return -1;
+    }
+    FILE* attributeFile = fopen(attributePath, "r");
+    if (attributeFile == NULL)
+    {
+        return -1;
+    }
+    int rv = -1;
+    if (fgets(value, (int)valueSize, attributeFile) != NULL)
+    {
+        value[strcspn(value, "\r\n")] = '\0';
+        rv = 0;
+    }
+    fclose(attributeFile);
+    return rv;
+}
+
+/** Finds the sysfs directory of the USB device a tty belongs to. The device
+ * is a parent of the tty's device, e.g. of the interface of a CDC ACM or of
+ * the port of a USB serial converter.
+ *
+ * \returns 0: if the directory was found.
+ * \returns -1: if the tty is no USB device.
+ */
+static int findUsbDeviceDir(const char* ttyName,
+                            char* usbDevicePath)
+{
+    char sysfsPath[PATH_MAX];
+    int written = snprintf(sysfsPath, sizeof(sysfsPath), "/sys/class/tty/%s/device", ttyName);
+    if ((written < 0) || ((size_t)written >= sizeof(sysfsPath)))
+    {
+        return -1;
+    }
+    if (realpath(sysfsPath, usbDevicePath) == NULL)
+    {
+        /* virtual terminals and ptys have no device */
+        return -1;
+    }
+    for (int level=0; level<4; level++)
+    {
+        written = snprintf(sysfsPath, sizeof(sysfsPath), "%s/idVendor", usbDevicePath);
+        if ((written >= 0) && ((size_t)written < sizeof(sysfsPath)) && (access(sysfsPath, R_OK) == 0))
+        {
+            return 0;
+        }
+        char* lastSlash = strrchr(usbDevicePath, '/');
+        if ((lastSlash == NULL) || (lastSlash == usbDevicePath))
+        {
+            break;
+        }
+        *lastSlash = '\0';
+    }
+    return -1;
+}
+
+/** Writes a sysfs attribute. */
+static int writeSysfsAttribute(const char* dirPath,
+                               const char* name,
+                               const char* value)
+{
+    char attributePath[PATH_MAX];
+    int written = snprintf(attributePath, sizeof(attributePath), "%s/%s", dirPath, name);
+    if ((written < 0) || ((size_t)written >= sizeof(attributePath)))
+    {
+        return -1;
+    }
+    FILE* attributeFile = fopen(attributePath, "w");
+    if (attributeFile == NULL)
+    {
+        return -1;
+    }
+    int rv = (fputs(value, attributeFile) >= 0) ? 0 : -1;
+    /* the value is passed to the driver when the file is flushed */
+    if (fclose(attributeFile) != 0)
+    {
+        rv = -1;
+    }
+    return rv;
+}
+
+/** Reads the name of the driver of a tty, e.g. ftdi_sio.
+ *
+ * \returns 0: if the driver was read.
+ * \returns -1: if the tty has no driver, e.g. a pty, or its name does not
+ *              fit into driver.
+ */
+static int readTtyDriver(const char* ttyName,
+                         char* driver,
+                         size_t driverSize)
+{
+    char driverLink[PATH_MAX];
+    char driverPath[PATH_MAX];
+    int written = snprintf(driverLink, sizeof(driverLink), "/sys/class/tty/%s/device/driver", ttyName);
+    if ((written < 0) || ((size_t)written >= sizeof(driverLink)))
+    {
+        return -1;
+    }
+    ssize_t driverPathLen = readlink(driverLink, driverPath, sizeof(driverPath) - 1);
+    if (driverPathLen <= 0)
+    {
+        return -1;
+    }
+    driverPath[driverPathLen] = '\0';
+    const char* driverName = strrchr(driverPath, '/');
+    written = snprintf(driver, driverSize, "%s", (driverName != NULL) ? driverName + 1 : driverPath);
+    if ((written < 0) || ((size_t)written >= driverSize))
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/** Reads the USB identity and the driver of a tty.
+ *
+ * \returns 0: if the tty is a USB device.
+ * \returns -1: if the tty is no USB device.
+ */
+static int readTtyInfo(const char* ttyName,
+                       SERH_PortInfoType* info)
+{
+    char usbDevicePath[PATH_MAX];
+    if (findUsbDeviceDir(ttyName, usbDevicePath) != 0)
+    {
+        return -1;
+    }
+
+    char value[SERH_MAX_SERIAL_NUMBER_LENGTH];
+    if (readSysfsAttribute(usbDevicePath, "idVendor", value, sizeof(value)) == 0)
+    {
+        info->vendorId = (unsigned short)strtoul(value, NULL, 16);
+    }
+    if (readSysfsAttribute(usbDevicePath, "idProduct", value, sizeof(value)) == 0)
+    {
+        info->productId = (unsigned short)strtoul(value, NULL, 16);
+    }
+    if (readSysfsAttribute(usbDevicePath, "serial", info->serialNumber, sizeof(info->serialNumber)) != 0)
+    {
+        info->serialNumber[0] = '\0';
+    }
+
+    if (readTtyDriver(ttyName, info->driver, sizeof(info->driver)) != 0)
+    {
+        info->driver[0] = '\0';
+    }
+    return 0;
+}
+
+/** Replaces the device node of the ports by their stable name in
+ * /dev/serial/by-id, which stays the same if the device is connected to
+ * another USB port or the devices are enumerated in another order. */
+static void resolveStableNames(SERH_PortInfoType* ports,
+                               size_t portCount)
+{
+    DIR* dirp = opendir("/dev/serial/by-id");
+    if (dirp == NULL)
+    {
+        return;
+    }
+    struct dirent* dp;
+    while ((dp = readdir(dirp)) != NULL)
+    {
+        char linkPath[PATH_MAX];
+        char targetPath[PATH_MAX];
+        if (dp->d_name[0] == '.')
+        {
+            continue;
+        }
+        int linkLength = snprintf(linkPath, sizeof(linkPath), "/dev/serial/by-id/%s", dp->d_name);
+        /* a port whose stable name is too long keeps its device node */
+        if ((linkLength < 0) || ((size_t)linkLength >= SERH_MAX_PORT_PATH_LENGTH)
+         || (realpath(linkPath, targetPath) == NULL))
+        {
+            continue;
+        }
+        for (size_t i=0; i<portCount; i++)
+        {
+            if (strcmp(targetPath, ports[i].nodePath) == 0)
+            {
+                memcpy(ports[i].path, linkPath, (size_t)linkLength + 1);
+            }
+        }
+    }
+    closedir(dirp);
+}
+
+/** Sets the latency timer of an FTDI converter. The converter holds back
+ * received data until a USB packet is full or the timer expires.
+ *
+ * \returns 0: if the timer is set.
+ * \returns -1: if the converter has no latency timer.
+ * \returns -2: if the timer could not be changed, e.g. due to missing
+ *              permissions.
+ */
+static int setLatencyTimer(SerialPortType* port,
+                           int timerMS)
+{
+    char devicePath[PATH_MAX];
+    char value[16];
+    snprintf(devicePath, sizeof(devicePath), "/sys/class/tty/%s/device", port->ttyName);
+    if ((port->ttyName[0] == '\0')
+     || (readSysfsAttribute(devicePath, "latency_timer", value, sizeof(value)) != 0))
+    {
+        return -1;
+    }
+    int currentMS = atoi(value);
+    if (currentMS == timerMS)
+    {
+        return 0;
+    }
+    snprintf(value, sizeof(value), "%d", timerMS);
+    if (writeSysfsAttribute(devicePath, "latency_timer", value) != 0)
+    {
+        DIAG_LogMsgArg(DIAG_WARNING, MODULE_NAME, __func__, "unable to set the latency timer of %s to %d ms, strerror() is \'%s\'. Write access to %s/latency_timer is required, e.g. by a udev rule",
+                       port->ttyName, timerMS, strerror(errno), devicePath);
+        return -2;
+    }
+    if (port->latencyTimerChanged == false)
+    {
+        port->originalLatencyTimerMS = currentMS;
+        port->latencyTimerChanged = true;
+    }
+    return 0;
+}
+
+/** Sets or clears the low_latency flag of the serial driver. If set, received
+ * data is passed on immediately instead of being deferred to a worker.
+ *
+ * \returns 0: if the flag is set as requested.
+ * \returns -1: if the driver does not support the flag, e.g. a pty.
+ * \returns -2: if the flag could not be changed.
+ */
+static int setLowLatency(SerialPortType* port,
+                         bool lowLatency)
+{
+    struct serial_struct serialInfo;
+    if (ioctl(port->fildes, TIOCGSERIAL, &serialInfo) != 0)
+    {
+        return -1;
+    }
+    bool currentLowLatency = ((serialInfo.flags & ASYNC_LOW_LATENCY) != 0);
+    if (currentLowLatency == lowLatency)
+    {
+        return 0;
+    }
+    if (lowLatency == true)
+    {
+        serialInfo.flags |= ASYNC_LOW_LATENCY;
+    }
+    else
+    {
+        serialInfo.flags &= ~ASYNC_LOW_LATENCY;
+    }
+    if (ioctl(port->fildes, TIOCSSERIAL, &serialInfo) != 0)
+    {
+        DIAG_LogMsgArg(DIAG_WARNING, MODULE_NAME, __func__, "unable to change the low_latency flag of %s, strerror() is \'%s\'",
+                       port->ttyName, strerror(errno));
+        return -2;
+    }
+    if (port->lowLatencyChanged == false)
+    {
+        port->originalLowLatency = currentLowLatency;
+        port->lowLatencyChanged = true;
+    }
+    return 0;
+}
+#endif
+
+static SerialPortType* getSerialPort(SerialHandleType serialHandleVal)
+{
+    LLST_ListEntryType* elem;
+    if (LLST_get_elem_with_id(serialHandlesList, &elem, (unsigned int)serialHandleVal) != 0)
+    {
+        return NULL;
+    }
+    return (SerialPortType*)(elem->data);
+}
+
+/** Restores the settings changed by SERH_SetLinkProfile(). */
+static void restoreLinkSettings(SerialPortType* port)
+{
+#ifdef __linux__
+    if (port->latencyTimerChanged == true)
+    {
+        setLatencyTimer(port, port->originalLatencyTimerMS);
+        port->latencyTimerChanged = false;
+    }
+    if (port->lowLatencyChanged == true)
+    {
+        setLowLatency(port, port->originalLowLatency);
+        port->lowLatencyChanged = false;
+    }
+#else
+    (void)port;
+#endif
+}
+
+static int comparePortInfos(const void* a,
+                            const void* b)
+{
+    return strcmp(((const SERH_PortInfoType*)a)->nodePath,
+                  ((const SERH_PortInfoType*)b)->nodePath);
+}
+
+/** Reads the serial number of the USB device a tty belongs to from sysfs.
+ *
+ * \returns 0: if the serial number was read.
+ * \returns -1: if the tty is no USB device or has no serial number.
+ */
+static int readUsbSerialNumber(const char* path,
+                               char* serialNumber,
+                               size_t serialNumberSize)
+{
+#ifdef __linux__
+    char nodePath[PATH_MAX];
+    if (realpath(path, nodePath) == NULL)
+    {
+        return -1;
+    }
+    const char* ttyName = strrchr(nodePath, '/');
+    ttyName = (ttyName != NULL) ? ttyName + 1 : nodePath;
+
+    char usbDevicePath[PATH_MAX];
+    if (findUsbDeviceDir(ttyName, usbDevicePath) != 0)
+    {
+        return -1;
+    }
+    return readSysfsAttribute(usbDevicePath, "serial", serialNumber, serialNumberSize);
+#else
+    (void)path;
+    (void)serialNumber;
+    (void)serialNumberSize;
+    return -1;
+#endif
+}
+
+/** Sets the baudrate of an opened port. The standard baudrates are set by
+ * their Bnnn constant, any other is passed to the driver as is on Linux.
+ *
+ * \returns 0: if the baudrate was set.
+ * \returns -1: if the baudrate is not supported.
+ */
+static int setBaudrate(int fildes,
+                       unsigned int baudrate)
+{
+    speed_t baudrateConstant = 0;
+    for (size_t i=0; i<sizeof(BAUDRATE_LUT)/sizeof(BaudrateLutType); i++)
+    {
+        if (baudrate == BAUDRATE_LUT[i].baudrate)
+        {
+            baudrateConstant = BAUDRATE_LUT[i].CFG_VAL;
+        }
+    }
+
+    if (baudrateConstant != 0)
+    {
+        struct termios commAttr;
+        if ((tcgetattr(fildes, &commAttr) != 0)
+         || (cfsetispeed(&commAttr, baudrateConstant) != 0)
+         || (cfsetospeed(&commAttr, baudrateConstant) != 0)
+         || (tcsetattr(fildes, TCSANOW, &commAttr) != 0))
+        {
+            DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to set the baudrate %u, strerror() is \'%s\'", baudrate, strerror(errno));
+            return -1;
+        }
+        return 0;
+    }
+
+#ifdef __linux__
+    unsigned int actualBaudrate = 0;
+    if (TIO2_SetBaudrate(fildes, baudrate, &actualBaudrate) != 0)
+    {
+        DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "the serial port does not support the baudrate %u, strerror() is \'%s\'", baudrate, strerror(errno));
+        return -1;
+    }
+    unsigned int deviation = (actualBaudrate > baudrate) ? (actualBaudrate - baudrate) : (baudrate - actualBaudrate);
+    if ((unsigned long long)deviation * 100ULL > (unsigned long long)baudrate * MAX_BAUDRATE_DEVIATION_PERCENT)
+    {
+        DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "the serial port does not support the baudrate %u, the adapter would run at %u baud", baudrate, actualBaudrate);
+        return -1;
+    }
+    DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "baudrate set to %u, the adapter runs at %u baud", baudrate, actualBaudrate);
+    return 0;
+#else
+    DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "the baudrate %u is not supported on this OS, only the standard baudrates up to 115200 are", baudrate);
+    return -1;
+#endif
+}
+
 static int write2fildes(int         fildes,
                         const char* buf,
                         size_t      chars2write)
@@ -131,67 +557,55 @@ int SERH_Open(const char* path, unsigned int baudrate, SerialHandleType* serialH
 {
     DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
 
-    if (mSerialFildes >= 0)
+    *serialHandleVal = INVALID_SERIAL_HANDLE;
+    if (baudrate == 0)
     {
-        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "There is already one serial port open. This module can only handle one serial port at a time!");
+        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "invalid baudrate specified!");
         return -1;
     }
-    int baudrateConstant = 0;
-    for (size_t i=0; i<sizeof(BAUDRATE_LUT); i++)
-    {
-        if (baudrate == BAUDRATE_LUT[i].baudrate)
-        {
-            baudrateConstant = BAUDRATE_LUT[i].CFG_VAL;
-        }
-    }
-    if (baudrateConstant == 0)
+
+    SerialPortType* newPort = (SerialPortType*)calloc(1, sizeof(SerialPortType));
+    if (newPort == NULL)
     {
-        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "invalid baudrate specified!");
-        DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "baudrate was %d", baudrate);
+        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to allocate memory for serial handle");
         return -1;
     }
 
-    mSerialFildes = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    int fildes = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
 
-    if (mSerialFildes < 0)
+    if (fildes < 0)
     {
         DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to open file!");
         DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "fopen() return value was < 0, strerror() is \'%s\'", strerror(errno));
-        
-        *serialHandleVal = INVALID_SERIAL_HANDLE;
+        free(newPort);
         return -1;
     }
-    *serialHandleVal = 1;
+
+    /* the name of the device node locates the settings of its driver in
+       sysfs, even if the port is opened by a symbolic link */
+    char nodePath[PATH_MAX];
+    if (realpath(path, nodePath) != NULL)
+    {
+        const char* ttyName = strrchr(nodePath, '/');
+        ttyName = (ttyName != NULL) ? ttyName + 1 : nodePath;
+        if (strlen(ttyName) < sizeof(newPort->ttyName))
+        {
+            strcpy(newPort->ttyName, ttyName);
+        }
+    }
 
     /* set the communication parameters */
     int rv;
     struct termios commAttr;
-    rv = tcgetattr(mSerialFildes, &commAttr);
+    rv = tcgetattr(fildes, &commAttr);
     if (rv == -1)
     {
-        close(mSerialFildes);
-        mSerialFildes = -1;
+        close(fildes);
+        free(newPort);
         DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to get TTY attributes! Are you sure you specified an existing serial port?");
         return -1;
     }
 
-    rv = cfsetispeed(&commAttr, baudrateConstant);
-    if (rv == -1)
-    {
-        close(mSerialFildes);
-        mSerialFildes = -1;
-        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "Failed to set baudrate. The baudrate is probably not supported!");
-        return -1;
-    }
-    rv = cfsetospeed(&commAttr, baudrateConstant);
-    if (rv == -1)
-    {
-        close(mSerialFildes);
-        mSerialFildes = -1;
-        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "Failed to set baudrate. The baudrate is probably not supported!");
-        return -1;
-    }
-
     commAttr.c_cflag &= ~CSTOPB;
     commAttr.c_cflag &= ~PARENB;
     commAttr.c_cflag &= ~CSIZE;
@@ -210,15 +624,52 @@ int SERH_Open(const char* path, unsigned int baudrate, SerialHandleType* serialH
 
     commAttr.c_oflag &= ~OPOST;
 
-    tcsetattr(mSerialFildes, TCSAFLUSH, &commAttr);
+    /* read() returns immediately with the data available, the port is
+       waited for by poll() of the event loop */
+    commAttr.c_cc[VMIN] = 0;
+    commAttr.c_cc[VTIME] = 0;
+
+    rv = tcsetattr(fildes, TCSAFLUSH, &commAttr);
     if (rv == -1)
     {
-        close(mSerialFildes);
-        mSerialFildes = -1;
+        close(fildes);
+        free(newPort);
         DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to set TTY attributes!");
         return -1;
     }
 
+    if (setBaudrate(fildes, baudrate) != 0)
+    {
+        close(fildes);
+        free(newPort);
+        return -1;
+    }
+
+    /* register the configured port, the handle is its id within the list */
+    LLST_ListEntryType* newListElement = NULL;
+    if (LLST_create_elem(&newListElement, (void*)newPort, serialHandlesIndexCounter) != 0)
+    {
+        close(fildes);
+        free(newPort);
+        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to allocate memory for list element");
+        return -1;
+    }
+    if (serialHandlesList == NULL)
+    {
+        serialHandlesList = newListElement;
+    }
+    else if (LLST_add_elem(serialHandlesList, newListElement) != 0)
+    {
+        close(fildes);
+        free(newPort);
+        LLST_delete_elem(newListElement);
+        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to add list element to the existing list");
+        return -1;
+    }
+
+    newPort->fildes = fildes;
+    *serialHandleVal = (SerialHandleType)serialHandlesIndexCounter;
+    serialHandlesIndexCounter++;
     return 0;
 }
 
@@ -226,87 +677,262 @@ int SERH_Close(SerialHandleType serialHandleVal)
 {
     DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
 
-    if (serialHandleVal != 1)
+    LLST_ListEntryType* elem;
+    int rvGetElem = LLST_get_elem_with_id(serialHandlesList, &elem, (unsigned int)serialHandleVal);
+    if (rvGetElem != 0)
     {
         DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid serial port handle");
         return -1;
     }
 
-    if (mSerialFildes == -1)
+    SerialPortType* port = (SerialPortType*)(elem->data);
+    restoreLinkSettings(port);
+    close(port->fildes);
+    free(port);
+    LLST_ListEntryType* newStart;
+    int rvRemoveElem = LLST_remove_elem_with_id(serialHandlesList, &newStart, (unsigned int)serialHandleVal);
+    if (rvRemoveElem == 0)
     {
-        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "no serial port open");
-        return -1;
+        serialHandlesList = newStart;
     }
-    close(mSerialFildes);
-    mSerialFildes = -1;
+    LLST_delete_elem(elem);
     return 0;
 }
 
-int SERH_GetPortList(char* buffer, size_t bufSize, char** portNames, size_t portNamesSize, size_t* portCount)
+int SERH_GetPortInfoList(SERH_PortInfoType* ports,
+                         size_t maxPortCount,
+                         size_t* portCount)
 {
-#if 0
-    /* TODO: this code only adds a single string to the list. It is a temporary workaround for the plugin
-             running on POSIX complying OSes.
-             Two solutions are possible:
-               1. implement the gathering of all available serial ports here
-               2. fix issue #11 so that any port can be specified by the user
-    */
-    if ((bufSize < 26) || (portNamesSize < 2))
+    *portCount = 0;
+#ifdef __linux__
+    /* only the ttys of USB devices are listed, sysfs has an entry for every
+       tty including the virtual terminals and the legacy serial ports */
+    const char* dirPath = "/sys/class/tty";
+#else
+    const char* dirPath = "/dev";
+#endif
+    DIR* dirp = opendir(dirPath);
+    if (dirp == NULL)
     {
-        *portCount = 0;
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "unable to open directory %s", dirPath);
         return -1;
     }
-    strncpy(buffer,    "/dev/ttyUSB0", 13);
-    strncpy(buffer+13, "/dev/ttyUSB1", 13);
-    portNames[0] = &buffer[0];
-    portNames[1] = &buffer[13];
-    *portCount = 2;
-    return 0;
+
+    struct dirent* dp;
+    while ((dp = readdir(dirp)) != NULL)
+    {
+        SERH_PortInfoType info;
+        memset(&info, 0, sizeof(info));
+#ifdef __linux__
+        if ((dp->d_name[0] == '.') || (readTtyInfo(dp->d_name, &info) != 0))
+        {
+            continue;
+        }
 #else
-    DIR* dirp = opendir("/dev");
-    if (dirp == NULL)
+        if ((strncmp(dp->d_name, "ttyUSB", 6) != 0) && (strncmp(dp->d_name, "ttyACM", 6) != 0))
+        {
+            continue;
+        }
+#endif
+        int written = snprintf(info.nodePath, sizeof(info.nodePath), "/dev/%s", dp->d_name);
+        if ((written < 0) || ((size_t)written >= sizeof(info.nodePath)))
+        {
+            continue;
+        }
+        if (*portCount >= maxPortCount)
+        {
+            DIAG_LogMsg(DIAG_WARNING, MODULE_NAME, __func__, "provided buffer is too small. Not all available serial ports have been written!");
+            break;
+        }
+        memcpy(info.path, info.nodePath, sizeof(info.nodePath));
+        ports[*portCount] = info;
+        *portCount += 1;
+    }
+    closedir(dirp);
+
+    qsort(ports, *portCount, sizeof(SERH_PortInfoType), comparePortInfos);
+#ifdef __linux__
+    resolveStableNames(ports, *portCount);
+#endif
+    return 0;
+}
+
+int SERH_GetPortList(char* buffer, size_t bufSize, char** portNames, size_t portNamesSize, size_t* portCount)
+{
+    SERH_PortInfoType ports[SERH_MAX_PORTS];
+    size_t portsFound = 0;
+    *portCount = 0;
+    if (SERH_GetPortInfoList(ports, (portNamesSize < SERH_MAX_PORTS) ? portNamesSize : SERH_MAX_PORTS, &portsFound) != 0)
     {
-        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "unable to open directory /dev");
         return -1;
     }
 
-    struct dirent* dp;
     size_t bufIndex = 0;
-    while ((dp = readdir(dirp)))
+    for (size_t i=0; i<portsFound; i++)
     {
-        if (strncmp(dp->d_name, "ttyUSB", 6) == 0)
+        size_t pathLen = strlen(ports[i].path);
+        if ((bufIndex + pathLen + 1) > bufSize)
         {
-            size_t fileNameLen = strnlen(dp->d_name, 128);
-            if (   (*portCount < portNamesSize)
-                && ((bufIndex+fileNameLen+5) < bufSize))
-            {
-                strncpy(&buffer[bufIndex], "/dev/", 5);
-                strncpy(&buffer[bufIndex+5], dp->d_name, fileNameLen);
-                buffer[bufIndex+5+fileNameLen] = '\0';
-                portNames[*portCount] = &buffer[bufIndex];
-                *portCount += 1;
-                bufIndex += fileNameLen + 5 + 1;
-            }
-            else
-            {
-                DIAG_LogMsg(DIAG_WARNING, MODULE_NAME, __func__, "provided buffer is too small. Not all available serial ports have been written!");
-                break;
-            }
+            DIAG_LogMsg(DIAG_WARNING, MODULE_NAME, __func__, "provided buffer is too small. Not all available serial ports have been written!");
+            break;
         }
+        memcpy(&buffer[bufIndex], ports[i].path, pathLen + 1);
+        portNames[*portCount] = &buffer[bufIndex];
+        *portCount += 1;
+        bufIndex += pathLen + 1;
     }
+    return 0;
+}
 
+int SERH_GetPortIdentity(const char* path,
+                         SERH_PortIdentityType* identity)
+{
+    memset(identity, 0, sizeof(SERH_PortIdentityType));
+    struct stat nodeStat;
+    if (stat(path, &nodeStat) != 0)
+    {
+        DIAG_LogMsgArg(DIAG_WARNING, MODULE_NAME, __func__, "unable to get the status of \'%s\', strerror() is \'%s\'", path, strerror(errno));
+        return -1;
+    }
+    /* the node is created again if the device is reconnected */
+    identity->deviceId = (unsigned long long)nodeStat.st_rdev;
+    identity->nodeId = (unsigned long long)nodeStat.st_ino;
+    identity->changeTime = (unsigned long long)nodeStat.st_ctime;
+    if (readUsbSerialNumber(path, identity->serialNumber, sizeof(identity->serialNumber)) != 0)
+    {
+        identity->serialNumber[0] = '\0';
+    }
     return 0;
+}
+
+int SERH_SetBaudrate(SerialHandleType serialHandleVal,
+                     unsigned int baudrate)
+{
+    int fildes;
+    if (SERH_GetFildes(serialHandleVal, &fildes) != 0)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid serial port handle");
+        return -1;
+    }
+    /* data sent at the former baudrate is garbage at the new one */
+    if ((tcdrain(fildes) != 0) || (setBaudrate(fildes, baudrate) != 0))
+    {
+        return -1;
+    }
+    return tcflush(fildes, TCIFLUSH);
+}
+
+int SERH_SetHardwareFlowControl(SerialHandleType serialHandleVal,
+                                bool enable)
+{
+    int fildes;
+    if (SERH_GetFildes(serialHandleVal, &fildes) != 0)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid serial port handle");
+        return -1;
+    }
+    /* the baudrate set by the termios2 interface is kept by tcsetattr() */
+    struct termios commAttr;
+    if (tcgetattr(fildes, &commAttr) != 0)
+    {
+        return -1;
+    }
+    if (enable == true)
+    {
+        commAttr.c_cflag |= CRTSCTS;
+    }
+    else
+    {
+        commAttr.c_cflag &= ~CRTSCTS;
+    }
+    if (tcsetattr(fildes, TCSANOW, &commAttr) != 0)
+    {
+        DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to change the hardware flow control, strerror() is \'%s\'", strerror(errno));
+        return -1;
+    }
+    DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "RTS/CTS flow control %s", enable ? "enabled" : "disabled");
+    return 0;
+}
+
+int SERH_SetLinkProfile(SerialHandleType serialHandleVal,
+                        SERH_LinkProfileType profile)
+{
+    SerialPortType* port = getSerialPort(serialHandleVal);
+    if (port == NULL)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid serial port handle");
+        return -1;
+    }
+    if (profile == SERH_LINK_PROFILE_DEFAULT)
+    {
+        restoreLinkSettings(port);
+        return 0;
+    }
+
+#ifdef __linux__
+    bool lowLatency = (profile == SERH_LINK_PROFILE_LATENCY);
+    char driver[SERH_MAX_DRIVER_NAME_LENGTH];
+    if ((port->ttyName[0] == '\0') || (readTtyDriver(port->ttyName, driver, sizeof(driver)) != 0))
+    {
+        snprintf(driver, sizeof(driver), "unknown");
+    }
+
+    int timerMS = lowLatency ? SERH_LOW_LATENCY_TIMER_MS : SERH_HIGH_LATENCY_TIMER_MS;
+    char timerResult[32];
+    switch (setLatencyTimer(port, timerMS))
+    {
+        case 0:
+            snprintf(timerResult, sizeof(timerResult), "%d ms", timerMS);
+            break;
+        case -1:
+            snprintf(timerResult, sizeof(timerResult), "not supported");
+            break;
+        default:
+            snprintf(timerResult, sizeof(timerResult), "unchanged");
+            break;
+    }
+    const char* flagResult;
+    switch (setLowLatency(port, lowLatency))
+    {
+        case 0:
+            flagResult = lowLatency ? "on" : "off";
+            break;
+        case -1:
+            flagResult = "not supported";
+            break;
+        default:
+            flagResult = "unchanged";
+            break;
+    }
+    DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "%s profile applied to %s (driver %s): latency timer %s, low_latency %s",
+                   lowLatency ? "latency" : "throughput", port->ttyName, driver, timerResult, flagResult);
+#else
+    DIAG_LogMsg(DIAG_INFO, MODULE_NAME, __func__, "link profiles are not supported on this OS, the settings of the driver are kept");
 #endif
+    return 0;
 }
 
 int SERH_FlushInput(SerialHandleType serialHandleVal)
 {
-    if (serialHandleVal != 1)
+    int fildes;
+    if (SERH_GetFildes(serialHandleVal, &fildes) != 0)
     {
         DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid serial port handle");
         return -1;
     }
-    return tcflush(mSerialFildes, TCIOFLUSH);
+    return tcflush(fildes, TCIOFLUSH);
+}
+
+int SERH_GetFildes(SerialHandleType serialHandleVal,
+                   int*             fildes)
+{
+    const SerialPortType* port = getSerialPort(serialHandleVal);
+    if (port == NULL)
+    {
+        return -1;
+    }
+    *fildes = port->fildes;
+    return 0;
 }
 
 /** \todo check if the return value is compliant to the requirement stated in the function documentation (see header file) */
@@ -315,7 +941,8 @@ int SERH_Read(SerialHandleType serialHandleVal,
               size_t maxChars2read,
               size_t* charsRead)
 {
-    if (serialHandleVal != 1)
+    int fildes;
+    if (SERH_GetFildes(serialHandleVal, &fildes) != 0)
     {
         DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid serial port handle");
         return -1;
@@ -323,7 +950,7 @@ int SERH_Read(SerialHandleType serialHandleVal,
 
     /* read() returns 0 toindicate end-of-file on an empty pipe */
     /* not implemented yet */
-    int rv = read(mSerialFildes, buf, maxChars2read);
+    int rv = read(fildes, buf, maxChars2read);
     
     if (rv >= 0)
     {
@@ -345,36 +972,39 @@ int SERH_Write(SerialHandleType serialHandleVal,
                const char*    buf,
                size_t         chars2write)
 {
-    if (serialHandleVal != 1)
+    int fildes;
+    if (SERH_GetFildes(serialHandleVal, &fildes) != 0)
     {
         DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid serial port handle");
         return -1;
     }
-    return write2fildes(mSerialFildes, buf, chars2write);
+    return write2fildes(fildes, buf, chars2write);
 }
 
 int SERH_WriteLn(SerialHandleType serialHandleVal,
                  const char*    buf,
                  size_t         chars2write)
 {
-    if (serialHandleVal != 1)
+    int fildes;
+    if (SERH_GetFildes(serialHandleVal, &fildes) != 0)
     {
         DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid serial port handle");
         return -1;
     }
-    int rv = write2fildes(mSerialFildes, buf, chars2write);
+    int rv = write2fildes(fildes, buf, chars2write);
     if (rv != 0)
     {
         return rv;
     }
-    return write2fildes(mSerialFildes, "\n", 1);
+    return write2fildes(fildes, "\n", 1);
 }
 
 int SERH_WriteArg(SerialHandleType serialHandleVal,
                   const char*    fmtMsg,
                                  ...)
 {
-    if (serialHandleVal != 1)
+    int fildes;
+    if (SERH_GetFildes(serialHandleVal, &fildes) != 0)
     {
         DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid serial port handle");
         return -1;
@@ -388,7 +1018,7 @@ int SERH_WriteArg(SerialHandleType serialHandleVal,
     int rv = -1;
     if (rvVsnprintf >= 0)
     {
-        rv = write2fildes(mSerialFildes, tempBufMsg, bytesWritten);
+        rv = write2fildes(fildes, tempBufMsg, bytesWritten);
     }
     va_end(args);
     return rv;
@@ -398,7 +1028,8 @@ int SERH_WriteArgLn(SerialHandleType serialHandleVal,
                     const char*    fmtMsg,
                                    ...)
 {
-    if (serialHandleVal != 1)
+    int fildes;
+    if (SERH_GetFildes(serialHandleVal, &fildes) != 0)
     {
         DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid serial port handle");
         return -1;
@@ -412,7 +1043,7 @@ int SERH_WriteArgLn(SerialHandleType serialHandleVal,
     int rv = -1;
     if (rvVsnprintf >= 0)
     {
-        rv = write2fildes(mSerialFildes, tempBufMsg, bytesWritten);
+        rv = write2fildes(fildes, tempBufMsg, bytesWritten);
     }
     va_end(args);
 
@@ -420,7 +1051,7 @@ int SERH_WriteArgLn(SerialHandleType serialHandleVal,
     {
         return rv;
     }
-    return write2fildes(mSerialFildes, "\n", 1);
+    return write2fildes(fildes, "\n", 1);
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
@@ -38,13 +38,23 @@
  *************************************************************************** */
 
 /* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#ifdef __linux__
+/* required for memfd_create() */
+#define _GNU_SOURCE
+#endif
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <time.h>
+#include <unistd.h>
 
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "diagnosis.h"
 
 /* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
 #include "systemutils.h"
@@ -73,6 +83,10 @@
 static const char* MODULE_NAME = "SYSU";
 
 /* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+#ifdef SYSU_VIRTUAL_CLOCK
+/** advanced by the thread of the test, possibly read by other threads */
+static volatile unsigned long mVirtualMillis = 0;
+#endif
 
 /* ***************************************************************************
  * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
@@ -83,19 +97,53 @@ static const char* MODULE_NAME = "SYSU";
 /* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
 
 /* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+/** Creates an anonymous file descriptor referring to shared memory. */
+static int createAnonymousSharedMemory(size_t size)
+{
+#ifdef __linux__
+    int fildes = memfd_create("capturino-ring", MFD_CLOEXEC);
+#else
+    /* the name is removed right after creation, it only has to be unique for
+       this short period of time */
+    char name[64];
+    snprintf(name, sizeof(name), "/capturino-ring-%ld", (long)getpid());
+    int fildes = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fildes >= 0)
+    {
+        shm_unlink(name);
+    }
+#endif
+    if (fildes < 0)
+    {
+        return -1;
+    }
+    if (ftruncate(fildes, (off_t)size) != 0)
+    {
+        close(fildes);
+        return -1;
+    }
+    return fildes;
+}
 
 /* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
 int SYSU_Sleep(unsigned int milliseconds)
 {
+#ifdef SYSU_VIRTUAL_CLOCK
+    SYSU_AdvanceVirtualMillis(milliseconds);
+#else
     struct timespec ts;
     ts.tv_sec = milliseconds / 1000;
     ts.tv_nsec = (milliseconds - (ts.tv_sec * 1000)) * 1000000;
     nanosleep(&ts, NULL);
+#endif
     return 0;
 }
 
 int SYSU_GetCurrentMillis(unsigned long* currentTime)
 {
+#ifdef SYSU_VIRTUAL_CLOCK
+    *currentTime = mVirtualMillis;
+#else
     struct timespec ts;
     unsigned long long milliseconds;
 
@@ -105,9 +153,24 @@ int SYSU_GetCurrentMillis(unsigned long* currentTime)
     milliseconds += ts.tv_nsec / 1000000LL;
     
     *currentTime = (unsigned long)milliseconds;
+#endif
+    return 0;
+}
+
+#ifdef SYSU_VIRTUAL_CLOCK
+int SYSU_SetVirtualMillis(unsigned long currentTime)
+{
+    mVirtualMillis = currentTime;
     return 0;
 }
 
+int SYSU_AdvanceVirtualMillis(unsigned long milliseconds)
+{
+    mVirtualMillis += milliseconds;
+    return 0;
+}
+#endif
+
 int SYSU_GetCurrentTime(unsigned long long* unixTime, unsigned long* micros)
 {
     struct timespec currentUnixTimeAndNanos;
@@ -117,6 +180,12 @@ int SYSU_GetCurrentTime(unsigned long long* unixTime, unsigned long* micros)
     return 0;
 }
 
+int SYSU_GetProcessId(unsigned long* processId)
+{
+    *processId = (unsigned long)getpid();
+    return 0;
+}
+
 int SYSU_StrNCpy_S(char* dest,
                    size_t destSize,
                    const char* src,
@@ -133,6 +202,77 @@ int SYSU_StrNCpy_S(char* dest,
     }
 }
 
+int SYSU_GetCacheFilePath(const char* fileName,
+                          char* path,
+                          size_t pathSize)
+{
+    int written;
+    const char* cacheHome = getenv("XDG_CACHE_HOME");
+    if ((cacheHome != NULL) && (cacheHome[0] != '\0'))
+    {
+        written = snprintf(path, pathSize, "%s/%s", cacheHome, fileName);
+    }
+    else
+    {
+        const char* home = getenv("HOME");
+        if ((home == NULL) || (home[0] == '\0'))
+        {
+            return -1;
+        }
+        written = snprintf(path, pathSize, "%s/.cache/%s", home, fileName);
+    }
+    return ((written < 0) || ((size_t)written >= pathSize)) ? -1 : 0;
+}
+
+size_t SYSU_GetMirrorGranularity(void)
+{
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+int SYSU_AllocMirrored(size_t size, void** memory)
+{
+    if ((size == 0) || ((size % SYSU_GetMirrorGranularity()) != 0))
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "invalid size %lu for a mirrored mapping", (unsigned long)size);
+        return -1;
+    }
+
+    int fildes = createAnonymousSharedMemory(size);
+    if (fildes < 0)
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "unable to create shared memory, errno=%d", errno);
+        return -1;
+    }
+
+    /* reserve the address range of both mappings first, then replace both
+       halves with the same shared memory */
+    uint8_t* base = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "unable to reserve address range, errno=%d", errno);
+        close(fildes);
+        return -1;
+    }
+    if (   (mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fildes, 0) == MAP_FAILED)
+        || (mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fildes, 0) == MAP_FAILED))
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "unable to map shared memory, errno=%d", errno);
+        munmap(base, 2 * size);
+        close(fildes);
+        return -1;
+    }
+    /* the mappings keep the shared memory alive */
+    close(fildes);
+
+    *memory = base;
+    return 0;
+}
+
+int SYSU_FreeMirrored(void* memory, size_t size)
+{
+    return (munmap(memory, 2 * size) == 0) ? 0 : -1;
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 /* ***************************************************************************
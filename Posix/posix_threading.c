@@ -0,0 +1,182 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup threading
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "diagnosis.h"
+
+/* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
+#include "threading.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+#define THRD_MAX_INSTANCES  (8)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+typedef struct
+{
+    bool                isUsed;
+    pthread_t           thread;
+    THRD_ThreadFuncType threadFunc;
+    void*               arg;
+    int                 threadRv;
+} ThreadInstanceType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
+const ThreadHandleType INVALID_THREAD_HANDLE = 0;
+
+/* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
+static const char* MODULE_NAME = "THRD";
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+static pthread_mutex_t mThreadsMutex = PTHREAD_MUTEX_INITIALIZER;
+static ThreadInstanceType mThreads[THRD_MAX_INSTANCES];
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * * */
+
+/* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static void* threadEntry(void* instanceArg)
+{
+    ThreadInstanceType* instance = (ThreadInstanceType*)instanceArg;
+    instance->threadRv = instance->threadFunc(instance->arg);
+    return NULL;
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int THRD_Create(ThreadHandleType*   threadHandleVal,
+                THRD_ThreadFuncType threadFunc,
+                void*               arg)
+{
+    DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
+
+    *threadHandleVal = INVALID_THREAD_HANDLE;
+    pthread_mutex_lock(&mThreadsMutex);
+    size_t i;
+    for (i=0; i<THRD_MAX_INSTANCES; i++)
+    {
+        if (mThreads[i].isUsed == false)
+        {
+            break;
+        }
+    }
+    if (i >= THRD_MAX_INSTANCES)
+    {
+        pthread_mutex_unlock(&mThreadsMutex);
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "no free thread instance available!");
+        return -1;
+    }
+
+    mThreads[i].isUsed = true;
+    mThreads[i].threadFunc = threadFunc;
+    mThreads[i].arg = arg;
+    mThreads[i].threadRv = 0;
+    int rvCreate = pthread_create(&mThreads[i].thread, NULL, threadEntry, &mThreads[i]);
+    if (rvCreate != 0)
+    {
+        mThreads[i].isUsed = false;
+        pthread_mutex_unlock(&mThreadsMutex);
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "pthread_create() failed, strerror() is \'%s\'", strerror(rvCreate));
+        return -1;
+    }
+    pthread_mutex_unlock(&mThreadsMutex);
+
+    *threadHandleVal = (ThreadHandleType)(i + 1);
+    return 0;
+}
+
+int THRD_Join(ThreadHandleType threadHandleVal,
+              int*             threadRv)
+{
+    DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
+
+    if (   (threadHandleVal == INVALID_THREAD_HANDLE)
+        || (threadHandleVal > THRD_MAX_INSTANCES)
+        || (mThreads[threadHandleVal - 1].isUsed == false))
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid thread handle");
+        return -1;
+    }
+
+    ThreadInstanceType* instance = &mThreads[threadHandleVal - 1];
+    int rvJoin = pthread_join(instance->thread, NULL);
+    if (rvJoin != 0)
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "pthread_join() failed, strerror() is \'%s\'", strerror(rvJoin));
+        return -1;
+    }
+    if (threadRv != NULL)
+    {
+        *threadRv = instance->threadRv;
+    }
+
+    pthread_mutex_lock(&mThreadsMutex);
+    instance->isUsed = false;
+    pthread_mutex_unlock(&mThreadsMutex);
+    return 0;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
@@ -0,0 +1,282 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup eventloop
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <windows.h>
+#include <stdbool.h>
+#include <synchapi.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "diagnosis.h"
+#include "win_internal_serialhandling.h"
+#include "systemutils.h"
+
+/* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
+#include "eventloop.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+/** every session waits for the responses of the CAPTURino on its own
+    event loop, the reader of a capturing session on another one */
+#define EVLP_MAX_INSTANCES      (24)
+/** The serial port is opened without FILE_FLAG_OVERLAPPED, so its receive
+    queue is checked periodically while waiting for the wakeup event. */
+#define EVLP_SERIAL_CHECK_MS    (1)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+typedef struct
+{
+    bool   isUsed;
+    HANDLE wakeupEvent;
+} EventLoopInstanceType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
+const EventLoopHandleType INVALID_EVENTLOOP_HANDLE = 0;
+
+/* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
+static const char* MODULE_NAME = "EVLP";
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+static EventLoopInstanceType mEventLoops[EVLP_MAX_INSTANCES];
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * * */
+
+/* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static EventLoopInstanceType* getInstance(EventLoopHandleType eventLoopHandleVal)
+{
+    if (   (eventLoopHandleVal == INVALID_EVENTLOOP_HANDLE)
+        || (eventLoopHandleVal > EVLP_MAX_INSTANCES))
+    {
+        return NULL;
+    }
+    EventLoopInstanceType* instance = &mEventLoops[eventLoopHandleVal - 1];
+    return (instance->isUsed == true) ? instance : NULL;
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int EVLP_Open(EventLoopHandleType* eventLoopHandleVal)
+{
+    DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
+
+    *eventLoopHandleVal = INVALID_EVENTLOOP_HANDLE;
+    size_t i;
+    for (i=0; i<EVLP_MAX_INSTANCES; i++)
+    {
+        if (mEventLoops[i].isUsed == false)
+        {
+            break;
+        }
+    }
+    if (i >= EVLP_MAX_INSTANCES)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "no free event loop instance available!");
+        return -1;
+    }
+
+    /* auto-reset event, a single wait consumes a pending wakeup */
+    HANDLE wakeupEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (wakeupEvent == NULL)
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "CreateEvent() failed, GetLastError() is %ld", GetLastError());
+        return -1;
+    }
+
+    mEventLoops[i].wakeupEvent = wakeupEvent;
+    mEventLoops[i].isUsed = true;
+    *eventLoopHandleVal = (EventLoopHandleType)(i + 1);
+    return 0;
+}
+
+int EVLP_Close(EventLoopHandleType eventLoopHandleVal)
+{
+    DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
+
+    EventLoopInstanceType* instance = getInstance(eventLoopHandleVal);
+    if (instance == NULL)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid event loop handle");
+        return -1;
+    }
+    instance->isUsed = false;
+    CloseHandle(instance->wakeupEvent);
+    instance->wakeupEvent = NULL;
+    return 0;
+}
+
+int EVLP_WaitSerial(EventLoopHandleType  eventLoopHandleVal,
+                    SerialHandleType     serialHandleVal,
+                    unsigned long        timeoutMS,
+                    EVLP_WaitResultType* result)
+{
+    EventLoopInstanceType* instance = getInstance(eventLoopHandleVal);
+    if (instance == NULL)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid event loop handle");
+        return -1;
+    }
+
+    HANDLE comHandle;
+    if (SERH_GetWinHandle(serialHandleVal, &comHandle) != 0)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid serial port handle");
+        return -1;
+    }
+
+#ifndef SYSU_VIRTUAL_CLOCK
+    ULONGLONG startTime = GetTickCount64();
+#endif
+    for (;;)
+    {
+        DWORD rvWait = WaitForSingleObject(instance->wakeupEvent, 0);
+        if (rvWait == WAIT_OBJECT_0)
+        {
+            *result = EVLP_WAKEUP;
+            return 0;
+        }
+
+        COMSTAT comStat;
+        DWORD commErrors;
+        if (ClearCommError(comHandle, &commErrors, &comStat) == FALSE)
+        {
+            /* let the following call to SERH_Read() report the error */
+            *result = EVLP_READABLE;
+            return 0;
+        }
+        if (comStat.cbInQue > 0)
+        {
+            *result = EVLP_READABLE;
+            return 0;
+        }
+
+#ifdef SYSU_VIRTUAL_CLOCK
+        /* a wait on the virtual clock does not block, its timeout advances
+           the clock instead, see SYSU_SetVirtualMillis() */
+        SYSU_AdvanceVirtualMillis(timeoutMS);
+        *result = EVLP_TIMEOUT;
+        return 0;
+#else
+        ULONGLONG elapsed = GetTickCount64() - startTime;
+        if (elapsed >= timeoutMS)
+        {
+            *result = EVLP_TIMEOUT;
+            return 0;
+        }
+        DWORD remaining = (DWORD)(timeoutMS - elapsed);
+        rvWait = WaitForSingleObject(instance->wakeupEvent,
+                                     (remaining < EVLP_SERIAL_CHECK_MS) ? remaining : EVLP_SERIAL_CHECK_MS);
+        if (rvWait == WAIT_OBJECT_0)
+        {
+            *result = EVLP_WAKEUP;
+            return 0;
+        }
+#endif
+    }
+}
+
+int EVLP_Wait(EventLoopHandleType  eventLoopHandleVal,
+              unsigned long        timeoutMS,
+              EVLP_WaitResultType* result)
+{
+    EventLoopInstanceType* instance = getInstance(eventLoopHandleVal);
+    if (instance == NULL)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid event loop handle");
+        return -1;
+    }
+
+#ifdef SYSU_VIRTUAL_CLOCK
+    DWORD rvWait = WaitForSingleObject(instance->wakeupEvent, 0);
+#else
+    DWORD rvWait = WaitForSingleObject(instance->wakeupEvent, (DWORD)timeoutMS);
+#endif
+    if (rvWait == WAIT_OBJECT_0)
+    {
+        *result = EVLP_WAKEUP;
+    }
+    else if (rvWait == WAIT_TIMEOUT)
+    {
+#ifdef SYSU_VIRTUAL_CLOCK
+        SYSU_AdvanceVirtualMillis(timeoutMS);
+#endif
+        *result = EVLP_TIMEOUT;
+    }
+    else
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "WaitForSingleObject() failed, GetLastError() is %ld", GetLastError());
+        return -1;
+    }
+    return 0;
+}
+
+int EVLP_Wakeup(EventLoopHandleType eventLoopHandleVal)
+{
+    /* NOTE: no logging in here, as this function may be called from within a
+             console control handler */
+    EventLoopInstanceType* instance = getInstance(eventLoopHandleVal);
+    if (instance == NULL)
+    {
+        return -1;
+    }
+    return SetEvent(instance->wakeupEvent) ? 0 : -1;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
@@ -50,7 +50,6 @@
 
 /* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
 #define TEMP_BUF_SIZE (1024)
-#define MAX_FRAME_SIZE_TO_WRITE (4096)
 
 /* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
 
@@ -76,7 +75,7 @@ static HANDLE mWriteTaskHandle;
 static HANDLE mStopEvent;
 
 static size_t m_framesizememory[8192];
-static char m_buffermemory[65536];
+static uint8_t m_buffermemory[65536];
 
 static volatile RingBufType mFrameSizeRingBuffer = 
 {
@@ -86,13 +85,12 @@ static volatile RingBufType mFrameSizeRingBuffer =
     .bufferSize = 8192,
     .elementSize = sizeof(size_t)
 };
-static volatile RingBufType mDataRingBuffer =
+static volatile RingBufP2Type mDataRingBuffer =
 {
     .head = 0,
     .tail = 0,
     .buffer = m_buffermemory,
-    .bufferSize = 65536,
-    .elementSize = 1
+    .mask = 65536 - 1
 };
 
 /* ***************************************************************************
@@ -123,30 +121,29 @@ static int write2handle(const char*  buf,
 /* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
 static DWORD WINAPI WriteTask(LPVOID lpParam)
 {
-    while (WaitForSingleObject(mStopEvent, 0) != WAIT_OBJECT_0)
+    /* the frames written before the pipe is closed are still passed on */
+    while ((WaitForSingleObject(mStopEvent, 0) != WAIT_OBJECT_0)
+           || (RingBuf_isEmpty(&mFrameSizeRingBuffer) == FALSE))
     {
         if (RingBuf_isEmpty(&mFrameSizeRingBuffer) == FALSE)
         {
             DWORD bytesWritten;
             size_t frameSize = *((size_t*)RingBuf_getTail(&mFrameSizeRingBuffer));
-            if (RingBuf_getElementsCount(&mDataRingBuffer) < frameSize)
+            if (RingBufP2_getCount(&mDataRingBuffer) < frameSize)
             {
                 continue;
             }
-            size_t bytes2end = RingBuf_getFullElementsTail2End(&mDataRingBuffer);
-            if (bytes2end >= frameSize)
+            /* a frame wrapping over the end of the ring buffer is written
+               in two parts */
+            size_t remaining = frameSize;
+            while (remaining > 0)
             {
-                WriteFile(mPipeHandle, RingBuf_getTail(&mDataRingBuffer), frameSize, &bytesWritten, NULL);
-                RingBuf_increaseTailMore(&mDataRingBuffer, (size_t)frameSize);
-            }
-            else /* this means the frame wraps over the end of the ring buffer */
-            {
-                char tempBuf[MAX_FRAME_SIZE_TO_WRITE];
-                memcpy(tempBuf, RingBuf_getTail(&mDataRingBuffer), bytes2end);
-                RingBuf_increaseTailMore(&mDataRingBuffer, bytes2end);
-                memcpy(tempBuf + bytes2end, RingBuf_getTail(&mDataRingBuffer), frameSize - bytes2end);
-                RingBuf_increaseTailMore(&mDataRingBuffer, frameSize - bytes2end);
-                WriteFile(mPipeHandle, tempBuf, frameSize, &bytesWritten, NULL);
+                const uint8_t* span;
+                size_t spanSize = RingBufP2_getReadSpan(&mDataRingBuffer, &span);
+                size_t partSize = (spanSize < remaining) ? spanSize : remaining;
+                WriteFile(mPipeHandle, span, (DWORD)partSize, &bytesWritten, NULL);
+                RingBufP2_increaseTailMore(&mDataRingBuffer, partSize);
+                remaining -= partSize;
             }
             RingBuf_increaseTail(&mFrameSizeRingBuffer);
         }
@@ -185,26 +182,16 @@ static int vaWriteArg(PipeHandleType pipeHandleVal, const char* fmtMsg, va_list
 static int write2handle(const char* buf,
                         size_t      chars2write)
 {
-    if (chars2write >= 65536)
+    /* a frame must fit into the data ring buffer */
+    if (chars2write > PIPH_MAX_WRITE_SIZE)
     {
         return -1;
     }
-    size_t freeBytesAtOnce = RingBuf_getFreeElementsHead2End(&mDataRingBuffer);
-    if (freeBytesAtOnce >= chars2write)
+    DIAG_LogMsgArg(DIAG_DEBUG, MODULE_NAME, __func__, "writing %d bytes to buffer, head: %d, tail: %d", chars2write, mDataRingBuffer.head, mDataRingBuffer.tail);
+    if (RingBufP2_write(&mDataRingBuffer, buf, chars2write) != 0)
     {
-        DIAG_LogMsgArg(DIAG_DEBUG, MODULE_NAME, __func__, "writing %d bytes buffer all at once", chars2write);
-        DIAG_LogMsgArg(DIAG_DEBUG, MODULE_NAME, __func__, "bufSize: %d, head: %d, tail: %d", mDataRingBuffer.bufferSize, mDataRingBuffer.head, mDataRingBuffer.tail);
-        memcpy(RingBuf_getHead(&mDataRingBuffer), buf, chars2write);
-        RingBuf_increaseHeadMore(&mDataRingBuffer, chars2write);
-    }
-    else
-    {
-        DIAG_LogMsgArg(DIAG_DEBUG, MODULE_NAME, __func__, "writing to buffer in two steps: %d at first, %d afterwards", freeBytesAtOnce, chars2write - freeBytesAtOnce);
-        DIAG_LogMsgArg(DIAG_DEBUG, MODULE_NAME, __func__, "bufSize: %d, head: %d, tail: %d", mDataRingBuffer.bufferSize, mDataRingBuffer.head, mDataRingBuffer.tail);
-        memcpy(RingBuf_getHead(&mDataRingBuffer), buf, freeBytesAtOnce);
-        RingBuf_increaseHeadMore(&mDataRingBuffer, freeBytesAtOnce);
-        memcpy(RingBuf_getHead(&mDataRingBuffer), buf +  freeBytesAtOnce, chars2write - freeBytesAtOnce);
-        RingBuf_increaseHeadMore(&mDataRingBuffer, chars2write - freeBytesAtOnce);
+        DIAG_LogMsg(DIAG_WARNING, MODULE_NAME, __func__, "buffer is full, dropping data!");
+        return -1;
     }
     *((size_t*)RingBuf_getHead(&mFrameSizeRingBuffer)) = chars2write;
     RingBuf_increaseHead(&mFrameSizeRingBuffer);
@@ -32,11 +32,13 @@
 #include <windows.h>
 #include <handleapi.h>
 #include <stdlib.h>
+#include <string.h>
 #include <strsafe.h>
 
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
 #include "diagnosis.h"
 #include "linkedlist.h"
+#include "win_internal_serialhandling.h"
 
 /* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
 #include "serialhandling.h"
@@ -358,6 +360,127 @@ int SERH_GetPortList(char* buffer,
     return -1;
 }
 
+int SERH_GetPortInfoList(SERH_PortInfoType* ports,
+                         size_t maxPortCount,
+                         size_t* portCount)
+{
+    /* the USB identity would require the SetupAPI, only the names of the
+       ports are listed for now */
+    char portNameBuf[SERH_MAX_PORTS * 8];
+    char* portNames[SERH_MAX_PORTS];
+    size_t portsFound = 0;
+    *portCount = 0;
+    if (SERH_GetPortList(portNameBuf, sizeof(portNameBuf), portNames,
+                         (maxPortCount < SERH_MAX_PORTS) ? maxPortCount : SERH_MAX_PORTS,
+                         &portsFound) != 0)
+    {
+        return -1;
+    }
+    for (size_t i=0; i<portsFound; i++)
+    {
+        memset(&ports[i], 0, sizeof(SERH_PortInfoType));
+        StringCbCopyA(ports[i].nodePath, sizeof(ports[i].nodePath), portNames[i]);
+        StringCbCopyA(ports[i].path, sizeof(ports[i].path), portNames[i]);
+    }
+    *portCount = portsFound;
+    return 0;
+}
+
+int SERH_GetPortIdentity(const char* path,
+                         SERH_PortIdentityType* identity)
+{
+    memset(identity, 0, sizeof(SERH_PortIdentityType));
+    /* the DOS device name maps to the device object created by the driver,
+       e.g. \\Device\\USBSER000, which changes if another device is
+       connected to the port */
+    char targetPath[TEMP_BUF_SIZE];
+    if (QueryDosDeviceA(path, targetPath, sizeof(targetPath)) == 0)
+    {
+        DIAG_LogMsgArg(DIAG_WARNING, MODULE_NAME, __func__, "unable to query the DOS device \'%s\', GetLastError() returned %lu", path, GetLastError());
+        return -1;
+    }
+    /* FNV-1a hash of the device object name */
+    unsigned long long hash = 14695981039346656037ULL;
+    for (const char* c = targetPath; *c != '\0'; c++)
+    {
+        hash = (hash ^ (unsigned char)*c) * 1099511628211ULL;
+    }
+    identity->deviceId = hash;
+    return 0;
+}
+
+int SERH_SetBaudrate(SerialHandleType serialHandleVal,
+                     unsigned int baudrate)
+{
+    HANDLE comHandle;
+    if (SERH_GetWinHandle(serialHandleVal, &comHandle) != 0)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid serial port handle");
+        return -1;
+    }
+    DCB serialConfig;
+    serialConfig.DCBlength = sizeof(DCB);
+    if (GetCommState(comHandle, &serialConfig) == 0)
+    {
+        return -1;
+    }
+    /* data sent at the former baudrate is garbage at the new one */
+    FlushFileBuffers(comHandle);
+    serialConfig.BaudRate = baudrate;
+    if (SetCommState(comHandle, &serialConfig) == 0)
+    {
+        DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "the serial port does not support the baudrate %u, GetLastError() is %ld", baudrate, GetLastError());
+        return -1;
+    }
+    PurgeComm(comHandle, PURGE_RXCLEAR);
+    return 0;
+}
+
+int SERH_SetHardwareFlowControl(SerialHandleType serialHandleVal,
+                                bool enable)
+{
+    HANDLE comHandle;
+    if (SERH_GetWinHandle(serialHandleVal, &comHandle) != 0)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid serial port handle");
+        return -1;
+    }
+    DCB serialConfig;
+    serialConfig.DCBlength = sizeof(DCB);
+    if (GetCommState(comHandle, &serialConfig) == 0)
+    {
+        return -1;
+    }
+    serialConfig.fOutxCtsFlow = enable ? TRUE : FALSE;
+    serialConfig.fRtsControl = enable ? RTS_CONTROL_HANDSHAKE : RTS_CONTROL_DISABLE;
+    if (SetCommState(comHandle, &serialConfig) == 0)
+    {
+        DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to change the hardware flow control, GetLastError() is %ld", GetLastError());
+        return -1;
+    }
+    DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "RTS/CTS flow control %s", enable ? "enabled" : "disabled");
+    return 0;
+}
+
+int SERH_SetLinkProfile(SerialHandleType serialHandleVal,
+                        SERH_LinkProfileType profile)
+{
+    LLST_ListEntryType* elem;
+    int rvGetElem = LLST_get_elem_with_id(serialHandlesList, &elem, (unsigned int)serialHandleVal);
+    if (rvGetElem != 0)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "invalid serial port handle");
+        return -1;
+    }
+    /* the latency timer of FTDI converters is a setting of the device in the
+       registry, which requires administrator rights to be changed */
+    if (profile != SERH_LINK_PROFILE_DEFAULT)
+    {
+        DIAG_LogMsg(DIAG_INFO, MODULE_NAME, __func__, "link profiles are not supported on Windows, the settings of the driver are kept");
+    }
+    return 0;
+}
+
 int SERH_FlushInput(SerialHandleType serialHandleVal)
 {
     LLST_ListEntryType* elem;
@@ -373,6 +496,19 @@ int SERH_FlushInput(SerialHandleType serialHandleVal)
     return rv ? 0 : -1;
 }
 
+int SERH_GetWinHandle(SerialHandleType serialHandleVal,
+                      HANDLE*          winHandle)
+{
+    LLST_ListEntryType* elem;
+    int rvGetElem = LLST_get_elem_with_id(serialHandlesList, &elem, (unsigned int)serialHandleVal);
+    if (rvGetElem != 0)
+    {
+        return -1;
+    }
+    *winHandle = *((HANDLE*)(elem->data));
+    return 0;
+}
+
 int SERH_Read(SerialHandleType serialHandleVal,
               char* buf,
               size_t maxChars2read,
@@ -38,7 +38,9 @@
  *************************************************************************** */
 
 /* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdint.h>
 #include <windows.h>
+#include <memoryapi.h>
 #include <shlwapi.h>
 #include <strsafe.h>
 #include <synchapi.h>
@@ -46,6 +48,7 @@
 #include <timeapi.h>
 
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "diagnosis.h"
 
 /* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
 #include "systemutils.h"
@@ -55,6 +58,9 @@
  *************************************************************************** */
 
 /* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+/** number of attempts to map both views into a free address range, which
+    might be taken by another thread in the meantime */
+#define MIRROR_MAPPING_ATTEMPTS     (16)
 
 /* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
 
@@ -74,6 +80,10 @@
 static const char* MODULE_NAME = "SYSU";
 
 /* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+#ifdef SYSU_VIRTUAL_CLOCK
+/** advanced by the thread of the test, possibly read by other threads */
+static volatile unsigned long mVirtualMillis = 0;
+#endif
 
 /* ***************************************************************************
  * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
@@ -88,16 +98,38 @@ static const char* MODULE_NAME = "SYSU";
 /* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
 int SYSU_Sleep(unsigned int milliseconds)
 {
+#ifdef SYSU_VIRTUAL_CLOCK
+    SYSU_AdvanceVirtualMillis(milliseconds);
+#else
     Sleep(milliseconds);
+#endif
     return 0;
 }
 
 int SYSU_GetCurrentMillis(unsigned long* currentTime)
 {
+#ifdef SYSU_VIRTUAL_CLOCK
+    *currentTime = mVirtualMillis;
+#else
     *currentTime = timeGetTime();
+#endif
     return 0;
 }
 
+#ifdef SYSU_VIRTUAL_CLOCK
+int SYSU_SetVirtualMillis(unsigned long currentTime)
+{
+    mVirtualMillis = currentTime;
+    return 0;
+}
+
+int SYSU_AdvanceVirtualMillis(unsigned long milliseconds)
+{
+    mVirtualMillis += milliseconds;
+    return 0;
+}
+#endif
+
 int SYSU_GetCurrentTime(unsigned long long* unixTime, unsigned long* micros)
 {
     SYSTEMTIME sysTime;
@@ -120,6 +152,12 @@ int SYSU_GetCurrentTime(unsigned long long* unixTime, unsigned long* micros)
     return 0;
 }
 
+int SYSU_GetProcessId(unsigned long* processId)
+{
+    *processId = GetCurrentProcessId();
+    return 0;
+}
+
 int SYSU_StrNCpy_S(char* dest,
                    size_t destSize,
                    const char* src,
@@ -129,6 +167,92 @@ int SYSU_StrNCpy_S(char* dest,
     return (rv == S_OK) ? 0 : -1;
 }
 
+int SYSU_GetCacheFilePath(const char* fileName,
+                          char* path,
+                          size_t pathSize)
+{
+    char dirBuf[MAX_PATH];
+    DWORD dirLen = GetEnvironmentVariableA("LOCALAPPDATA", dirBuf, sizeof(dirBuf));
+    if ((dirLen == 0) || (dirLen >= sizeof(dirBuf)))
+    {
+        dirLen = GetTempPathA(sizeof(dirBuf), dirBuf);
+        if ((dirLen == 0) || (dirLen >= sizeof(dirBuf)))
+        {
+            return -1;
+        }
+    }
+    HRESULT rvPrintf = StringCbPrintfA(path, pathSize, "%s\\%s", dirBuf, fileName);
+    return (rvPrintf == S_OK) ? 0 : -1;
+}
+
+size_t SYSU_GetMirrorGranularity(void)
+{
+    SYSTEM_INFO sysInfo;
+    GetSystemInfo(&sysInfo);
+    return (size_t)sysInfo.dwAllocationGranularity;
+}
+
+int SYSU_AllocMirrored(size_t size, void** memory)
+{
+    if ((size == 0) || ((size % SYSU_GetMirrorGranularity()) != 0))
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "invalid size %lu for a mirrored mapping", (unsigned long)size);
+        return -1;
+    }
+
+    HANDLE mapping = CreateFileMapping(INVALID_HANDLE_VALUE,
+                                       NULL,
+                                       PAGE_READWRITE,
+                                       (DWORD)((unsigned long long)size >> 32),
+                                       (DWORD)(size & 0xFFFFFFFF),
+                                       NULL);
+    if (mapping == NULL)
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "unable to create file mapping, error=%lu", GetLastError());
+        return -1;
+    }
+
+    for (int i=0; i<MIRROR_MAPPING_ATTEMPTS; i++)
+    {
+        /* find a free address range for both views ... */
+        uint8_t* base = VirtualAlloc(NULL, 2 * size, MEM_RESERVE, PAGE_NOACCESS);
+        if (base == NULL)
+        {
+            break;
+        }
+        VirtualFree(base, 0, MEM_RELEASE);
+
+        /* ... and try to map both views into it */
+        void* firstView = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, base);
+        if (firstView == NULL)
+        {
+            continue;
+        }
+        void* secondView = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, base + size);
+        if (secondView == NULL)
+        {
+            UnmapViewOfFile(firstView);
+            continue;
+        }
+
+        /* the views keep the mapping alive */
+        CloseHandle(mapping);
+        *memory = base;
+        return 0;
+    }
+
+    DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "unable to map views of file, error=%lu", GetLastError());
+    CloseHandle(mapping);
+    return -1;
+}
+
+int SYSU_FreeMirrored(void* memory, size_t size)
+{
+    BOOL rvFirst = UnmapViewOfFile(memory);
+    BOOL rvSecond = UnmapViewOfFile((uint8_t*)memory + size);
+    return ((rvFirst != FALSE) && (rvSecond != FALSE)) ? 0 : -1;
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 /* ***************************************************************************
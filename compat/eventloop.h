@@ -0,0 +1,171 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup eventloop
+ * \brief Provides blocking waits on a serial port that can be interrupted
+ *        asynchronously, e.g. from a signal handler.
+ *
+ * @{
+ */
+/* ************************************************************************* */
+
+#ifndef EVENTLOOP_H_INCLUDED
+#define EVENTLOOP_H_INCLUDED
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stddef.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "serialhandling.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+
+/* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * */
+typedef unsigned int EventLoopHandleType;
+
+/** Reasons for a wait operation of the event loop to return */
+typedef enum {
+    EVLP_TIMEOUT  = 0,  ///< the given timeout expired without any event
+    EVLP_READABLE = 1,  ///< data is available to be read from the serial port
+    EVLP_WAKEUP   = 2   ///< EVLP_Wakeup() has been called or a signal arrived
+} EVLP_WaitResultType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E C L A R A T I O N S * * * * * * * * * */
+extern const EventLoopHandleType INVALID_EVENTLOOP_HANDLE;
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * */
+/** Creates a new event loop instance.
+ *
+ * \param[out] eventLoopHandleVal The handle to the created event loop.
+ *
+ * \returns 0: if the event loop has been created successfully.
+ * \returns -1: if the function failed.
+ */
+int EVLP_Open      (      EventLoopHandleType* eventLoopHandleVal);
+
+/** Releases all resources of a previously created event loop.
+ *
+ * \param[in] eventLoopHandleVal The handle to the event loop.
+ *
+ * \returns 0: if the event loop has been closed successfully.
+ * \returns -1: if the function failed.
+ */
+int EVLP_Close     (      EventLoopHandleType  eventLoopHandleVal);
+
+/** Blocks the calling thread until data can be read from the given serial
+ * port, the event loop is woken up or the timeout expires, whatever happens
+ * first.
+ *
+ * \param[in] eventLoopHandleVal The handle to the event loop.
+ * \param[in] serialHandleVal The handle to the serial port to wait for.
+ * \param[in] timeoutMS The maximum time to wait in milliseconds.
+ * \param[out] result The reason for the function to return.
+ *
+ * \note If a wakeup is pending and data is readable at the same time, the
+ *       wakeup is reported.
+ *
+ * \returns 0: if the wait operation was successful.
+ * \returns -1: if the function failed.
+ */
+int EVLP_WaitSerial(      EventLoopHandleType  eventLoopHandleVal,
+                          SerialHandleType     serialHandleVal,
+                          unsigned long        timeoutMS,
+                          EVLP_WaitResultType* result);
+
+/** Blocks the calling thread until the event loop is woken up or the timeout
+ * expires, whatever happens first.
+ *
+ * \param[in] eventLoopHandleVal The handle to the event loop.
+ * \param[in] timeoutMS The maximum time to wait in milliseconds.
+ * \param[out] result The reason for the function to return. Never set to
+ *                    EVLP_READABLE.
+ *
+ * \returns 0: if the wait operation was successful.
+ * \returns -1: if the function failed.
+ */
+int EVLP_Wait      (      EventLoopHandleType  eventLoopHandleVal,
+                          unsigned long        timeoutMS,
+                          EVLP_WaitResultType* result);
+
+/** Wakes up a thread currently waiting on the given event loop. If no thread
+ * is waiting, the next wait operation returns immediately.
+ *
+ * \note This function is async-signal-safe and may therefore be called from
+ *       within a signal handler.
+ *
+ * \param[in] eventLoopHandleVal The handle to the event loop.
+ *
+ * \returns 0: if the wakeup has been signalled successfully.
+ * \returns -1: if the function failed.
+ */
+int EVLP_Wakeup    (      EventLoopHandleType  eventLoopHandleVal);
+
+/* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENTLOOP_H_INCLUDED */
+
+/**
+ * @}
+ */
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
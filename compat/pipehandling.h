@@ -57,6 +57,8 @@ extern "C"
 #endif
 
 /* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+/** largest number of bytes accepted by a single call of PIPH_Write() */
+#define PIPH_MAX_WRITE_SIZE (65535)
 
 /* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
 
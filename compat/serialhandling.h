@@ -44,6 +44,7 @@
  *************************************************************************** */
 
 /* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdbool.h>
 #include <stddef.h>
 
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
@@ -57,6 +58,19 @@ extern "C"
 #endif
 
 /* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+/** maximum length of a USB serial number including the terminating zero */
+#define SERH_MAX_SERIAL_NUMBER_LENGTH   (64)
+/** maximum length of a port path including the terminating zero */
+#define SERH_MAX_PORT_PATH_LENGTH       (128)
+/** maximum length of a driver name including the terminating zero */
+#define SERH_MAX_DRIVER_NAME_LENGTH     (32)
+/** maximum number of ports listed by SERH_GetPortList() */
+#define SERH_MAX_PORTS                  (32)
+/** latency timer of FTDI converters set by SERH_LINK_PROFILE_LATENCY */
+#define SERH_LOW_LATENCY_TIMER_MS       (1)
+/** latency timer of FTDI converters set by SERH_LINK_PROFILE_THROUGHPUT,
+    which is the default of the driver */
+#define SERH_HIGH_LATENCY_TIMER_MS      (16)
 
 /* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
 
@@ -67,6 +81,45 @@ extern "C"
 /* G L O B A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * */
 typedef unsigned int SerialHandleType;
 
+/** Tuning of the USB serial converter behind a port, see
+ * SERH_SetLinkProfile(). */
+typedef enum
+{
+    SERH_LINK_PROFILE_DEFAULT = 0,  /**< the settings of the driver are kept */
+    SERH_LINK_PROFILE_LATENCY,      /**< received data is passed on as soon as
+                                         possible */
+    SERH_LINK_PROFILE_THROUGHPUT    /**< received data is collected to larger
+                                         USB transfers */
+} SERH_LinkProfileType;
+
+/** Describes an available serial port. */
+typedef struct
+{
+    char           path[SERH_MAX_PORT_PATH_LENGTH];     /**< stable name of the
+                                               port if available, e.g. in
+                                               /dev/serial/by-id, otherwise
+                                               nodePath */
+    char           nodePath[SERH_MAX_PORT_PATH_LENGTH]; /**< e.g. /dev/ttyACM0
+                                               or COM3 */
+    unsigned short vendorId;        /**< USB vendor ID, 0 if unknown */
+    unsigned short productId;       /**< USB product ID, 0 if unknown */
+    char           serialNumber[SERH_MAX_SERIAL_NUMBER_LENGTH]; /**< USB serial
+                                               number, empty if none */
+    char           driver[SERH_MAX_DRIVER_NAME_LENGTH]; /**< e.g. cdc_acm or
+                                               ftdi_sio, empty if unknown */
+} SERH_PortInfoType;
+
+/** Identifies the device behind a serial port. Any field changes if another
+ * device is connected to the port or the device is reconnected. */
+typedef struct
+{
+    char               serialNumber[SERH_MAX_SERIAL_NUMBER_LENGTH];  /**< USB
+                                               serial number, empty if none */
+    unsigned long long deviceId;    /**< device number of the port's node */
+    unsigned long long nodeId;      /**< file serial number of the node */
+    unsigned long long changeTime;  /**< time the node was created or changed */
+} SERH_PortIdentityType;
+
 /* ***************************************************************************
  * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
  *************************************************************************** */
@@ -83,7 +136,8 @@ extern const SerialHandleType INVALID_SERIAL_HANDLE;
 /** Opens a serial port for reading and writing
  * 
  * \param[in] path The name of the serial port to be opened.
- * \param[in] baudrate The baudrate to be used for the serial port.
+ * \param[in] baudrate The baudrate to be used for the serial port, see
+ *                     SERH_SetBaudrate().
  * \param[out] serialHandleVal The handle to the opened serial port.
  *
  * \returns 0: if the initialization has been finished successfully
@@ -103,7 +157,8 @@ int SERH_Open       (const char*             path,
 int SERH_Close      (      SerialHandleType  serialHandleVal);
 
 /** Retrieves a list of available serial ports and writes it to the given
- * memory.
+ * memory. The stable name of a port is listed if available, see
+ * SERH_PortInfoType.
  * 
  * \param[out] buffer The buffer to store the names of the available serial
  *                    ports.
@@ -122,6 +177,82 @@ int SERH_GetPortList(      char*             buffer,
                            size_t            portNamesSize,
                            size_t*           portCount);
 
+/** Retrieves the available serial ports together with the USB identity of
+ * the connected devices. The ports are listed in the same order as by
+ * SERH_GetPortList().
+ *
+ * \param[out] ports The array to store the available serial ports.
+ * \param[in] maxPortCount The size of the ports array.
+ * \param[out] portCount The number of available serial ports.
+ *
+ * \returns 0: if the port list was successfully retrieved.
+ * \returns -1: if the function failed.
+ */
+int SERH_GetPortInfoList(  SERH_PortInfoType* ports,
+                           size_t             maxPortCount,
+                           size_t*            portCount);
+
+
+
+/** Retrieves the identity of the device behind a serial port without opening
+ * the port.
+ *
+ * \param[in] path The name of the serial port.
+ * \param[out] identity The identity of the device. Fields which are not
+ *                      available on the OS are set to zero.
+ *
+ * \returns 0: if the identity was retrieved.
+ * \returns -1: if the port does not exist or the function failed.
+ */
+int SERH_GetPortIdentity(const char*                 path,
+                               SERH_PortIdentityType* identity);
+
+/** Changes the baudrate of an opened serial port. Besides the standard
+ * baudrates, any baudrate the adapter can generate is supported, e.g. 1M or
+ * 3M for most USB serial converters.
+ *
+ * \param[in] serialHandleVal handle to the serial port.
+ * \param[in] baudrate the baudrate to be set.
+ *
+ * \returns 0: if the baudrate was set.
+ * \returns -1: if the adapter or the OS does not support the baudrate.
+ */
+int SERH_SetBaudrate(      SerialHandleType  serialHandleVal,
+                           unsigned int      baudrate);
+
+/** Enables or disables the hardware flow control by the RTS and CTS lines.
+ * Disabled after opening a port.
+ *
+ * \param[in] serialHandleVal handle to the serial port.
+ * \param[in] enable true to enable the flow control.
+ *
+ * \returns 0: if the flow control was changed.
+ * \returns -1: if the function failed.
+ */
+int SERH_SetHardwareFlowControl(SerialHandleType serialHandleVal,
+                                bool             enable);
+
+/** Tunes the USB serial converter behind an opened port for either low
+ * latency or high throughput. The converter is detected by the settings its
+ * driver offers:
+ * - the latency timer of FTDI converters, which holds back received data for
+ *   up to 16 ms by default.
+ * - the low_latency flag of the serial driver.
+ *
+ * Settings the driver does not offer or the user is not permitted to change
+ * are skipped. The applied settings are logged and restored when the port is
+ * closed.
+ *
+ * \param[in] serialHandleVal handle to the serial port to be tuned.
+ * \param[in] profile the profile to be applied. SERH_LINK_PROFILE_DEFAULT
+ *                    restores the settings found when the port was opened.
+ *
+ * \returns 0: if the profile was applied as far as supported.
+ * \returns -1: if the handle is invalid.
+ */
+int SERH_SetLinkProfile(   SerialHandleType     serialHandleVal,
+                           SERH_LinkProfileType profile);
+
 /** Clears the specified serial input.
  * 
  * \param[in] serialHandleVal handle to the serial port to be flushed.
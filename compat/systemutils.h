@@ -56,6 +56,9 @@ extern "C"
 #endif
 
 /* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+/* SYSU_VIRTUAL_CLOCK is defined by the build of the compatibility layer with
+   the virtual clock, see SYSU_SetVirtualMillis(). It is linked by tests only,
+   the plugin uses the real clock. */
 
 /* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
 
@@ -96,6 +99,29 @@ int SYSU_Sleep(unsigned int milliseconds);
  */
 int SYSU_GetCurrentMillis(unsigned long* currentTime);
 
+#ifdef SYSU_VIRTUAL_CLOCK
+/** Sets the virtual clock, which starts at 0.
+ *
+ * With the virtual clock SYSU_GetCurrentMillis() returns the virtual time,
+ * SYSU_Sleep() and the timeouts of the event loop advance it instead of
+ * blocking. Thus a test passes hours of timeouts in a fraction of a second.
+ * SYSU_GetCurrentTime() keeps returning the real time.
+ *
+ * \param[in] currentTime The new time in milliseconds.
+ *
+ * \returns 0: everytime
+ */
+int SYSU_SetVirtualMillis(unsigned long currentTime);
+
+/** Advances the virtual clock. It overflows like the real clock.
+ *
+ * \param[in] milliseconds The number of milliseconds to advance the clock.
+ *
+ * \returns 0: everytime
+ */
+int SYSU_AdvanceVirtualMillis(unsigned long milliseconds);
+#endif
+
 /** Gathers the current time in seconds since the Unix epoch and the
  * microseconds elapsed in the current second.
  * 
@@ -111,6 +137,15 @@ int SYSU_GetCurrentMillis(unsigned long* currentTime);
  */
 int SYSU_GetCurrentTime(unsigned long long* unixTime, unsigned long* micros);
 
+/** Returns the identifier of the calling process, e.g. to name files which
+ * several instances of the plugin write at the same time.
+ *
+ * \param[out] processId The identifier of the process.
+ *
+ * \returns 0: everytime
+ */
+int SYSU_GetProcessId(unsigned long* processId);
+
 /** Safer version of the standard library's strncpy function which also checks
  * the available memory of the destination.
  * 
@@ -127,6 +162,52 @@ int SYSU_StrNCpy_S(      char*  dest,
                    const char*  src,
                          size_t srcSize);
 
+/** Builds the path of a file in the per-user cache directory, e.g.
+ * $XDG_CACHE_HOME on Linux or %LOCALAPPDATA% on Windows. The directory is not
+ * created.
+ *
+ * \param[in] fileName The name of the file.
+ * \param[out] path The buffer receiving the path.
+ * \param[in] pathSize The size of the buffer.
+ *
+ * \returns 0: if the path was built.
+ * \returns -1: if no cache directory is known or the buffer is too small.
+ */
+int SYSU_GetCacheFilePath(const char*  fileName,
+                                char*  path,
+                                size_t pathSize);
+
+/** Retrieves the granularity of memory allocated by SYSU_AllocMirrored().
+ *
+ * \returns the granularity in bytes, which is a power of two.
+ */
+size_t SYSU_GetMirrorGranularity(void);
+
+/** Allocates memory of the given size which is mapped twice into consecutive
+ * virtual addresses, i.e. byte i and byte i+size refer to the same memory.
+ * A ring buffer placed in this memory can hand out every span up to its size
+ * as contiguous memory, regardless of the wrap around.
+ *
+ * \param[in] size The size of the memory. Must be a multiple of
+ *                 SYSU_GetMirrorGranularity().
+ * \param[out] memory The start of the first mapping. The address range
+ *                    memory .. memory+2*size-1 is valid.
+ *
+ * \returns 0: if the memory has been allocated.
+ * \returns -1: if the size is invalid or the mapping failed.
+ */
+int SYSU_AllocMirrored(size_t size, void** memory);
+
+/** Releases memory allocated by SYSU_AllocMirrored().
+ *
+ * \param[in] memory The address returned by SYSU_AllocMirrored().
+ * \param[in] size The size given to SYSU_AllocMirrored().
+ *
+ * \returns 0: if the memory has been released.
+ * \returns -1: if the function failed.
+ */
+int SYSU_FreeMirrored(void* memory, size_t size);
+
 /* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
@@ -0,0 +1,123 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup threading
+ * \brief Provides the creation of additional threads of execution.
+ *
+ * @{
+ */
+/* ************************************************************************* */
+
+#ifndef THREADING_H_INCLUDED
+#define THREADING_H_INCLUDED
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+
+/* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * */
+typedef unsigned int ThreadHandleType;
+
+/** Function executed by a thread created with THRD_Create(). The return value
+ * is passed to the caller of THRD_Join(). */
+typedef int (*THRD_ThreadFuncType)(void* arg);
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E C L A R A T I O N S * * * * * * * * * */
+extern const ThreadHandleType INVALID_THREAD_HANDLE;
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * */
+/** Creates a new thread executing the given function.
+ *
+ * \param[out] threadHandleVal The handle to the created thread.
+ * \param[in] threadFunc The function to be executed by the new thread.
+ * \param[in] arg The argument passed to threadFunc.
+ *
+ * \returns 0: if the thread has been created successfully.
+ * \returns -1: if the function failed.
+ */
+int THRD_Create(ThreadHandleType*   threadHandleVal,
+                THRD_ThreadFuncType threadFunc,
+                void*               arg);
+
+/** Blocks until the given thread has finished and releases its resources.
+ *
+ * \param[in] threadHandleVal The handle to the thread.
+ * \param[out] threadRv The return value of the thread function. May be NULL.
+ *
+ * \returns 0: if the thread has been joined successfully.
+ * \returns -1: if the function failed.
+ */
+int THRD_Join  (ThreadHandleType    threadHandleVal,
+                int*                threadRv);
+
+/* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* THREADING_H_INCLUDED */
+
+/**
+ * @}
+ */
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
@@ -33,9 +33,11 @@
 #include <string.h>
 
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
-#include "capturinocommonintfcfuncs.h"
+#include "capturinodecoder.h"
+#include "diagnosis.h"
 #include "pcap_writer.h"
-#include "ringbuf.h"
+#include "pcapng_writer.h"
+#include "systemutils.h"
 
 /* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
 #include "capturino2pcapadptr.h"
@@ -45,6 +47,8 @@
  *************************************************************************** */
 
 /* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+/** size of the packet record header preceding the frame in the pcap format */
+#define PCAP_RECORD_HEADER_LENGTH   (16)
 
 /* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
 
@@ -72,23 +76,48 @@ static const char* MODULE_NAME = "CAPT_ADPR";
 /* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
 
 /* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
-static int extract_148_data(PipeHandleType fifoPipe,
-                            PCAP_PacketRecordHeaderType packetRecordHeader,
+/** Writes the packet record built in buffer, which reserves
+    PCAP_RECORD_HEADER_LENGTH bytes for the pcap record header in front of
+    the packet. */
+static int writePacket(const CaptureOutputType* output,
+                       uint64_t timestampNanos,
+                       uint8_t* buffer,
+                       size_t packetLength)
+{
+    if (output->format == CAPT_FORMAT_PCAPNG)
+    {
+        return PCNG_WriteEnhancedPacket(output->fifoPipe,
+                                        output->interfaceId,
+                                        timestampNanos,
+                                        &buffer[PCAP_RECORD_HEADER_LENGTH],
+                                        (uint32_t)packetLength);
+    }
+
+    PCAP_PacketRecordHeaderType packetRecordHeader;
+    /* thanks to the PCAP standard, we must fall back to a 32 bit timestamp...
+       at least its unsigned so we don't have a problem in 2038 but in 2106 */
+    packetRecordHeader.timestampSeconds       = (uint32_t)(timestampNanos / 1000000000ULL);
+    packetRecordHeader.timestampMicrosOrNanos = (uint32_t)((timestampNanos % 1000000000ULL) / 1000ULL);
+    packetRecordHeader.protocolPayloadLength  = (uint32_t)packetLength;
+    PCAP_FillPacketRecordHeader(&packetRecordHeader,
+                                (void*)buffer);
+    return PCAP_WritePacketRecord(output->fifoPipe, buffer);
+}
+
+static int extract_148_data(const CaptureOutputType* output,
+                            uint64_t timestampNanos,
                             const uint8_t* data,
                             size_t dataLength)
 {
-    uint8_t buffer[16+8];
-    uint8_t* UARTFrameBuffer = &buffer[16];
+    uint8_t buffer[PCAP_RECORD_HEADER_LENGTH+CDEC_MAX_PAYLOAD_LENGTH];
+    uint8_t* UARTFrameBuffer = &buffer[PCAP_RECORD_HEADER_LENGTH];
     memcpy(UARTFrameBuffer, data, dataLength);
-    packetRecordHeader.protocolPayloadLength = (uint32_t)(dataLength);
 
-    PCAP_FillPacketRecordHeader(&packetRecordHeader,
-                                (void*)buffer);
-    return PCAP_WritePacketRecord(fifoPipe, buffer);
+    return writePacket(output, timestampNanos, buffer, dataLength);
 }
 
-static int extract_227_data(PipeHandleType fifoPipe,
-                            PCAP_PacketRecordHeaderType packetRecordHeader,
+static int extract_227_data(const CaptureOutputType* output,
+                            uint64_t timestampNanos,
                             const uint8_t* data,
                             size_t dataLength)
 {
@@ -100,8 +129,8 @@ static int extract_227_data(PipeHandleType fifoPipe,
 
     /* for now just assume that the given frame is a CAN2.0 frame */
     /** \todo there should be a check if the given frame is a CANFD or CANXL frame! */
-    uint8_t buffer[16+16];
-    uint8_t* CANFrameBuffer = &buffer[16];
+    uint8_t buffer[PCAP_RECORD_HEADER_LENGTH+8+CDEC_MAX_PAYLOAD_LENGTH];
+    uint8_t* CANFrameBuffer = &buffer[PCAP_RECORD_HEADER_LENGTH];
     size_t i=0;
     if (data[i] >= 0x80)
     {
@@ -123,57 +152,113 @@ static int extract_227_data(PipeHandleType fifoPipe,
     CANFrameBuffer[6] = 0; /* reserved */
     CANFrameBuffer[7] = 0; /* reserved */
     memcpy(CANFrameBuffer+8, data+i, dataLength-i);
-    packetRecordHeader.protocolPayloadLength = (uint32_t)(8+dataLength-i);
-    PCAP_FillPacketRecordHeader(&packetRecordHeader,
-                                (void*)buffer);
-    return PCAP_WritePacketRecord(fifoPipe, buffer);
+    return writePacket(output, timestampNanos, buffer, 8+dataLength-i);
 }
 
 /* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
-int captureDataFrame(PipeHandleType fifoPipe,
-                     unsigned long dltValue,
-                     uint32_t capturinoMicros,
-                     size_t frameLength,
-                     RingBufType* ringBuffer)
+int captureParseFormat(const char* formatArg,
+                       CaptureOutputFormatType* format)
 {
-    PCAP_PacketRecordHeaderType packetRecordHeader;
-    unsigned long long unixSeconds;
-    unsigned long unixMicros;
-    capturinoCommonGetTimestamp(capturinoMicros, &unixSeconds, &unixMicros);
-    /* thanks to the PCAP standard, we must fall back to a 32 bit timestamp...
-       at least its unsigned so we don't have a problem in 2038 but in 2106 */
-    packetRecordHeader.timestampSeconds       = (uint32_t)unixSeconds;
-    packetRecordHeader.timestampMicrosOrNanos = (uint32_t)unixMicros;
+    if (strcmp(formatArg, "pcap") == 0)
+    {
+        *format = CAPT_FORMAT_PCAP;
+        return 0;
+    }
+    if (strcmp(formatArg, "pcapng") == 0)
+    {
+        *format = CAPT_FORMAT_PCAPNG;
+        return 0;
+    }
+    DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "unknown output format \'%s\'", formatArg);
+    return -1;
+}
 
-    uint8_t concatedData[64];
-    size_t firstDataFractionLength = RingBuf_getFullElementsTail2End(ringBuffer);
-    if (firstDataFractionLength >= frameLength)
+int captureWriteHeader(CaptureOutputType* output,
+                       unsigned long dltValue,
+                       uint32_t snapLength,
+                       const char* interfaceName)
+{
+    if (output->format == CAPT_FORMAT_PCAPNG)
     {
-        memcpy(&concatedData[0], RingBuf_getTail(ringBuffer), frameLength);
-        RingBuf_increaseTailMore(ringBuffer, frameLength);
+        if (PCNG_WriteSectionHeader(output->fifoPipe) != 0)
+        {
+            return -1;
+        }
+        return PCNG_WriteInterfaceDescription(output->fifoPipe,
+                                              (PCAP_ValidLinkTypesType)dltValue,
+                                              snapLength,
+                                              PCNG_TSRESOL_NANOS,
+                                              interfaceName,
+                                              &output->interfaceId);
     }
-    else
+    output->interfaceId = 0;
+    return PCAP_WriteHeader(output->fifoPipe, false, snapLength, (PCAP_ValidLinkTypesType)dltValue, 0, 0, 0);
+}
+
+int captureAddInterface(CaptureOutputType* output,
+                        unsigned long dltValue,
+                        uint32_t snapLength,
+                        const char* interfaceName)
+{
+    if (output->format != CAPT_FORMAT_PCAPNG)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "the pcap format supports only a single interface");
+        return -1;
+    }
+    return PCNG_WriteInterfaceDescription(output->fifoPipe,
+                                          (PCAP_ValidLinkTypesType)dltValue,
+                                          snapLength,
+                                          PCNG_TSRESOL_NANOS,
+                                          interfaceName,
+                                          &output->interfaceId);
+}
+
+int captureDataFrameAt(const CaptureOutputType* output,
+                       unsigned long dltValue,
+                       uint64_t timestampNanos,
+                       const uint8_t* frame,
+                       size_t frameLength)
+{
+    if (frameLength > CDEC_MAX_PAYLOAD_LENGTH)
     {
-        memcpy(&concatedData[0], RingBuf_getTail(ringBuffer), firstDataFractionLength);
-        RingBuf_increaseTailMore(ringBuffer, firstDataFractionLength);
-        memcpy(&concatedData[firstDataFractionLength], RingBuf_getTail(ringBuffer), frameLength - firstDataFractionLength);
-        RingBuf_increaseTailMore(ringBuffer, frameLength - firstDataFractionLength);
+        return -1;
     }
-    concatedData[frameLength] = '\0';
 
     switch ((PCAP_ValidLinkTypesType)dltValue)
     {
         case PCAP_USER1UART:
             /** \todo must be implemented */
-            return extract_148_data(fifoPipe, packetRecordHeader, concatedData, frameLength);
+            return extract_148_data(output, timestampNanos, frame, frameLength);
         case PCAP_SOCKETCAN:
-            return extract_227_data(fifoPipe, packetRecordHeader, concatedData, frameLength);
+            return extract_227_data(output, timestampNanos, frame, frameLength);
 
         default:
             return -1;
     }
 }
 
+int captureWriteStatistics(const CaptureOutputType* output,
+                           uint64_t framesReceived,
+                           uint64_t framesDropped,
+                           const char* comment)
+{
+    if (output->format != CAPT_FORMAT_PCAPNG)
+    {
+        return 0;
+    }
+    unsigned long long unixTime;
+    unsigned long micros;
+    SYSU_GetCurrentTime(&unixTime, &micros);
+    uint64_t timestampNanos = (uint64_t)unixTime * 1000000000ULL
+                            + (uint64_t)micros * 1000ULL;
+    return PCNG_WriteInterfaceStatistics(output->fifoPipe,
+                                         output->interfaceId,
+                                         timestampNanos,
+                                         framesReceived,
+                                         framesDropped,
+                                         comment);
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 /* ***************************************************************************
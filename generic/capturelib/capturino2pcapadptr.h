@@ -34,10 +34,10 @@
 /* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
 #include "pipehandling.h"
-#include "ringbuf.h"
 
 /* ***************************************************************************
  * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
@@ -52,6 +52,22 @@
  *************************************************************************** */
 
 /* G L O B A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * */
+/** File formats the captured frames can be written in */
+typedef enum
+{
+    CAPT_FORMAT_PCAP   = 0,
+    CAPT_FORMAT_PCAPNG = 1
+} CaptureOutputFormatType;
+
+/** Destination of the captured frames */
+typedef struct
+{
+    PipeHandleType          fifoPipe;
+    CaptureOutputFormatType format;
+    uint32_t                interfaceId;    /**< pcapng interface of the
+                                                 frames, assigned by
+                                                 captureWriteHeader() */
+} CaptureOutputType;
 
 /* ***************************************************************************
  * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
@@ -68,11 +84,87 @@
 /* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
 
 /* G L O B A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * */
-int captureDataFrame(PipeHandleType fifoPipe,
-                     unsigned long dltValue,
-                     uint32_t capturinoMicros,
-                     size_t frameLength,
-                     RingBufType* ringBuffer);
+/** Parses the value of the --format argument.
+ *
+ * \param[in] formatArg the argument value, "pcap" or "pcapng".
+ * \param[out] format the corresponding file format.
+ *
+ * \returns 0: if the format is known.
+ * \returns -1: otherwise.
+ */
+int captureParseFormat(const char* formatArg,
+                       CaptureOutputFormatType* format);
+
+/** Writes the file header, i.e. the pcap header or the pcapng section header
+ * and interface description block.
+ *
+ * \param[in,out] output the destination, the interface id is assigned for
+ *                       the pcapng format.
+ * \param[in] dltValue the link type of the captured frames.
+ * \param[in] snapLength the maximum length of a captured frame.
+ * \param[in] interfaceName name of the interface within a pcapng file.
+ *
+ * \returns 0: if the header has been written successfully.
+ * \returns -1: if the function failed.
+ */
+int captureWriteHeader(CaptureOutputType* output,
+                       unsigned long dltValue,
+                       uint32_t snapLength,
+                       const char* interfaceName);
+
+/** Adds another interface to the section written by captureWriteHeader().
+ * Only supported by the pcapng format.
+ *
+ * \param[in,out] output the destination, gets the id of the new interface
+ *                       assigned. Frames written with it belong to the new
+ *                       interface.
+ * \param[in] dltValue the link type of the frames captured on the interface.
+ * \param[in] snapLength the maximum length of a captured frame.
+ * \param[in] interfaceName name of the interface.
+ *
+ * \returns 0: if the interface description has been written successfully.
+ * \returns -1: if the function failed or the format is pcap.
+ */
+int captureAddInterface(CaptureOutputType* output,
+                        unsigned long dltValue,
+                        uint32_t snapLength,
+                        const char* interfaceName);
+
+/** Writes a captured frame whose timestamp is already converted to the host
+ * time.
+ *
+ * \param[in] output the destination.
+ * \param[in] dltValue the link type of the frame.
+ * \param[in] timestampNanos capture time in nanoseconds since the unix epoch.
+ * \param[in] frame the frame as received from the CAPTURino device.
+ * \param[in] frameLength number of bytes in frame.
+ *
+ * \returns 0: if the frame has been written successfully.
+ * \returns -1: if the frame is invalid or writing failed.
+ */
+int captureDataFrameAt(const CaptureOutputType* output,
+                       unsigned long dltValue,
+                       uint64_t timestampNanos,
+                       const uint8_t* frame,
+                       size_t frameLength);
+
+/** Writes the statistics of the capture process at its end. Only supported
+ * by the pcapng format, does nothing for the pcap format.
+ *
+ * \param[in] output the destination.
+ * \param[in] framesReceived the number of frames received from the device.
+ * \param[in] framesDropped the number of received frames which could not be
+ *                          written.
+ * \param[in] comment remarks on the capture, e.g. the accuracy of the
+ *                    timestamps. May be NULL.
+ *
+ * \returns 0: if the statistics have been written successfully.
+ * \returns -1: if the function failed.
+ */
+int captureWriteStatistics(const CaptureOutputType* output,
+                           uint64_t framesReceived,
+                           uint64_t framesDropped,
+                           const char* comment);
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 #endif /* CAPTURINO2PCAPADPTR_H_INCLUDED */
@@ -0,0 +1,311 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup capturinodecoder
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "diagnosis.h"
+
+/* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
+#include "capturinodecoder.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+/** timestamp and the first length byte */
+#define MIN_HEADER_LENGTH   (5)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
+
+/* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
+static const char* MODULE_NAME = "CDEC";
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * * */
+
+/* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
+/** Determines the total length of the frame starting at 'frame'.
+ *
+ * \returns the number of bytes necessary to determine the frame length, if
+ *          less than this number of bytes is available.
+ * \returns the total frame length including the header otherwise.
+ */
+static inline size_t getRequiredLength(const uint8_t* frame,
+                                       size_t         available,
+                                       size_t*        headerLength)
+{
+    if (available < MIN_HEADER_LENGTH)
+    {
+        return MIN_HEADER_LENGTH;
+    }
+    if (frame[4] < 0x80)
+    {
+        *headerLength = MIN_HEADER_LENGTH;
+        return MIN_HEADER_LENGTH + frame[4];
+    }
+    /* MSB of PayloadLength1 is set, i.e. parts of the value are stored in
+       PayloadLength2 */
+    if (available < MIN_HEADER_LENGTH + 1)
+    {
+        return MIN_HEADER_LENGTH + 1;
+    }
+    *headerLength = MIN_HEADER_LENGTH + 1;
+    return MIN_HEADER_LENGTH + 1 + ((((size_t)frame[4] & 0x7F) << 8) | frame[5]);
+}
+
+static inline uint32_t getTimestamp(const uint8_t* frame)
+{
+    return ((uint32_t)frame[0] << 24)
+         | ((uint32_t)frame[1] << 16)
+         | ((uint32_t)frame[2] <<  8)
+         |  (uint32_t)frame[3];
+}
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+/** Reports a single complete frame to the callbacks. */
+static int emitFrame(CDEC_DecoderType* decoder,
+                     const uint8_t*    frame,
+                     size_t            headerLength,
+                     size_t            frameLength)
+{
+    uint32_t timestampMicros = getTimestamp(frame);
+    size_t payloadLength = frameLength - headerLength;
+
+    if (payloadLength == 0)
+    {
+        DIAG_LogMsg(DIAG_VERBOSE, MODULE_NAME, __func__, "Null frame received");
+        if (timestampMicros == 0)
+        {
+            if (decoder->previousNullFrameWasAllNull == true)
+            {
+                /* two consecutive null frames received, i.e. the CAPTURino
+                   hardware indicates an error */
+                DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "CAPTURino hardware signalled an internal error");
+                return CDEC_HARDWARE_ERROR;
+            }
+            decoder->previousNullFrameWasAllNull = true;
+        }
+        else
+        {
+            decoder->previousNullFrameWasAllNull = false;
+        }
+        if (   (decoder->nullFrameCb != NULL)
+            && (decoder->nullFrameCb(decoder->cbArg, timestampMicros) != 0))
+        {
+            return CDEC_ABORTED;
+        }
+        return CDEC_OK;
+    }
+
+    if (decoder->frameCb(decoder->cbArg, timestampMicros, &frame[headerLength], payloadLength) != 0)
+    {
+        return CDEC_ABORTED;
+    }
+    return CDEC_OK;
+}
+
+static int checkPayloadLength(size_t headerLength, size_t frameLength)
+{
+    if (frameLength - headerLength > CDEC_MAX_PAYLOAD_LENGTH)
+    {
+        DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "possibly malformed frame received! payload length=%lu, limit is %d", (unsigned long)(frameLength - headerLength), CDEC_MAX_PAYLOAD_LENGTH);
+        return CDEC_MALFORMED_FRAME;
+    }
+    return CDEC_OK;
+}
+
+/** Decodes all frames which are completely contained in the given data
+ * without copying them.
+ */
+static int decodeInPlace(CDEC_DecoderType* decoder,
+                         const uint8_t*    data,
+                         size_t            length,
+                         size_t*           consumed)
+{
+    size_t pos = 0;
+    for (;;)
+    {
+        size_t available = length - pos;
+        size_t headerLength = 0;
+        size_t frameLength = getRequiredLength(&data[pos], available, &headerLength);
+        if (headerLength == 0)
+        {
+            /* not even the header is complete */
+            break;
+        }
+        int rv = checkPayloadLength(headerLength, frameLength);
+        if (rv != CDEC_OK)
+        {
+            *consumed = pos;
+            return rv;
+        }
+        if (frameLength > available)
+        {
+            break;
+        }
+        rv = emitFrame(decoder, &data[pos], headerLength, frameLength);
+        pos += frameLength;
+        if (rv != CDEC_OK)
+        {
+            *consumed = pos;
+            return rv;
+        }
+    }
+    *consumed = pos;
+    return CDEC_OK;
+}
+
+/** Appends the given data to the pending frame until it is complete or the
+ * data is exhausted.
+ */
+static int decodeBuffered(CDEC_DecoderType* decoder,
+                          const uint8_t*    data,
+                          size_t            length,
+                          size_t*           consumed)
+{
+    size_t pos = 0;
+    for (;;)
+    {
+        size_t headerLength = 0;
+        size_t frameLength = getRequiredLength(decoder->pending, decoder->pendingLength, &headerLength);
+        if (headerLength != 0)
+        {
+            int rv = checkPayloadLength(headerLength, frameLength);
+            if (rv != CDEC_OK)
+            {
+                *consumed = pos;
+                return rv;
+            }
+            if (decoder->pendingLength == frameLength)
+            {
+                decoder->pendingLength = 0;
+                *consumed = pos;
+                return emitFrame(decoder, decoder->pending, headerLength, frameLength);
+            }
+        }
+        if (pos >= length)
+        {
+            break;
+        }
+        size_t bytes2copy = frameLength - decoder->pendingLength;
+        if (bytes2copy > length - pos)
+        {
+            bytes2copy = length - pos;
+        }
+        memcpy(&decoder->pending[decoder->pendingLength], &data[pos], bytes2copy);
+        decoder->pendingLength += bytes2copy;
+        pos += bytes2copy;
+    }
+    *consumed = pos;
+    return CDEC_OK;
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+void CDEC_Init(CDEC_DecoderType*    decoder,
+               CDEC_FrameCbType     frameCb,
+               CDEC_NullFrameCbType nullFrameCb,
+               void*                cbArg)
+{
+    decoder->frameCb = frameCb;
+    decoder->nullFrameCb = nullFrameCb;
+    decoder->cbArg = cbArg;
+    decoder->previousNullFrameWasAllNull = false;
+    decoder->pendingLength = 0;
+}
+
+int CDEC_Feed(CDEC_DecoderType* decoder,
+              const uint8_t*    data,
+              size_t            length)
+{
+    size_t pos = 0;
+    while (pos < length)
+    {
+        size_t consumed = 0;
+        int rv;
+        if (decoder->pendingLength == 0)
+        {
+            /* fast path: frames completely within the data are passed on
+               without being copied */
+            rv = decodeInPlace(decoder, &data[pos], length - pos, &consumed);
+            pos += consumed;
+            if ((rv != CDEC_OK) || (pos >= length))
+            {
+                return rv;
+            }
+        }
+        /* the frame at pos is incomplete or a previous call left a partial
+           frame, which must be assembled in the pending buffer */
+        rv = decodeBuffered(decoder, &data[pos], length - pos, &consumed);
+        pos += consumed;
+        if (rv != CDEC_OK)
+        {
+            return rv;
+        }
+    }
+    return CDEC_OK;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
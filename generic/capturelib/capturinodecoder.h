@@ -0,0 +1,186 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup capturinodecoder
+ * \brief Reentrant streaming decoder for the frames sent by the CAPTURino
+ *        device during a capture.
+ *
+ * Every frame starts with a 4 byte big endian timestamp in microseconds,
+ * followed by the payload length. If the MSB of the first length byte is set,
+ * its lower 7 bits are the upper bits of a 15 bit length and a second length
+ * byte follows. A length of 0 indicates a null frame without payload, which
+ * is used for resynchronisation.
+ *
+ * The received bytes are pushed into the decoder in chunks of any size, every
+ * complete frame is reported by a callback. Frames which are completely
+ * contained within a chunk are reported without being copied.
+ *
+ * @{
+ */
+/* ************************************************************************* */
+
+#ifndef CAPTURINODECODER_H_INCLUDED
+#define CAPTURINODECODER_H_INCLUDED
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+/** for now all frames with a payload greater than this value are considered
+    to be malformed */
+#define CDEC_MAX_PAYLOAD_LENGTH     (64)
+/** size of the timestamp and the maximum size of the length field */
+#define CDEC_MAX_HEADER_LENGTH      (6)
+/** size of the shortest frame with a payload. Feeding n times this size to
+    the decoder completes at most n frames with a payload. */
+#define CDEC_MIN_PAYLOAD_FRAME_LENGTH   (6)
+
+/* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * */
+/** Return values of CDEC_Feed() */
+typedef enum
+{
+    CDEC_OK              =  0,  ///< all bytes have been processed
+    CDEC_MALFORMED_FRAME = -1,  ///< a frame exceeds CDEC_MAX_PAYLOAD_LENGTH
+    CDEC_HARDWARE_ERROR  = -2,  ///< the device signalled an internal error by
+                                ///< two consecutive null frames with a
+                                ///< timestamp of 0
+    CDEC_ABORTED         = -3   ///< a callback requested to stop decoding
+} CDEC_ResultType;
+
+/** Called for every complete frame with a payload.
+ *
+ * \param[in] cbArg the argument given to CDEC_Init().
+ * \param[in] timestampMicros the timestamp of the frame.
+ * \param[in] payload the payload of the frame. Only valid during the call.
+ * \param[in] payloadLength the number of bytes in payload.
+ *
+ * \returns 0: to continue decoding.
+ * \returns any other value: to stop decoding, CDEC_Feed() returns
+ *          CDEC_ABORTED.
+ */
+typedef int (*CDEC_FrameCbType)    (      void*    cbArg,
+                                          uint32_t timestampMicros,
+                                    const uint8_t* payload,
+                                          size_t   payloadLength);
+
+/** Called for every null frame. May be NULL if null frames are of no
+ * interest. The parameters and return value match CDEC_FrameCbType. */
+typedef int (*CDEC_NullFrameCbType)(      void*    cbArg,
+                                          uint32_t timestampMicros);
+
+typedef struct
+{
+    CDEC_FrameCbType     frameCb;
+    CDEC_NullFrameCbType nullFrameCb;
+    void*                cbArg;
+    bool                 previousNullFrameWasAllNull;
+    size_t               pendingLength;     /**< number of valid bytes in
+                                                 pending */
+    uint8_t              pending[CDEC_MAX_HEADER_LENGTH + CDEC_MAX_PAYLOAD_LENGTH];
+                                            /**< frame received partially
+                                                 by previous calls */
+} CDEC_DecoderType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E C L A R A T I O N S * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * */
+/** Initializes a decoder expecting the start of a frame.
+ *
+ * \param[out] decoder the decoder to be initialized.
+ * \param[in] frameCb callback for complete frames.
+ * \param[in] nullFrameCb callback for null frames, may be NULL.
+ * \param[in] cbArg argument passed to the callbacks.
+ */
+void CDEC_Init(CDEC_DecoderType*    decoder,
+               CDEC_FrameCbType     frameCb,
+               CDEC_NullFrameCbType nullFrameCb,
+               void*                cbArg);
+
+/** Decodes the given bytes, calling the callbacks for every completed frame.
+ * An incomplete frame at the end is kept within the decoder and completed by
+ * the following calls.
+ *
+ * \param[in] decoder the decoder.
+ * \param[in] data the received bytes.
+ * \param[in] length the number of bytes in data.
+ *
+ * \returns one of CDEC_ResultType. After an error, the decoder must be
+ *          initialized again before it can be used.
+ */
+int  CDEC_Feed(CDEC_DecoderType*    decoder,
+               const uint8_t*       data,
+               size_t               length);
+
+/* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAPTURINODECODER_H_INCLUDED */
+
+/**
+ * @}
+ */
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
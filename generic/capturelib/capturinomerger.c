@@ -0,0 +1,281 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup capturinomerger
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "diagnosis.h"
+
+/* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
+#include "capturinomerger.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
+
+/* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
+static const char* MODULE_NAME = "CMRG";
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * * */
+
+/* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
+static inline const CMRG_FrameType* oldestFrameOf(const CMRG_SourceType* source)
+{
+    return &source->frames[source->head];
+}
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+/** Finds the source holding the oldest frame. On equal timestamps the source
+ * with the lower index wins, so the order of the output is deterministic.
+ *
+ * \returns false: if no frame is held back.
+ */
+static bool findOldestSource(const CMRG_MergerType* merger,
+                             size_t* oldestSource)
+{
+    bool found = false;
+    uint64_t oldestNanos = 0;
+    for (size_t i=0; i<merger->sourceCount; i++)
+    {
+        const CMRG_SourceType* source = &merger->sources[i];
+        if ((source->count > 0)
+         && ((found == false) || (oldestFrameOf(source)->timestampNanos < oldestNanos)))
+        {
+            found = true;
+            oldestNanos = oldestFrameOf(source)->timestampNanos;
+            *oldestSource = i;
+        }
+    }
+    return found;
+}
+
+/** Checks if every source other than 'source' is known to deliver no frame
+ * older than timestampNanos anymore. */
+static bool isOldestForSure(const CMRG_MergerType* merger,
+                            size_t source,
+                            uint64_t timestampNanos)
+{
+    for (size_t i=0; i<merger->sourceCount; i++)
+    {
+        const CMRG_SourceType* other = &merger->sources[i];
+        /* a queued frame of another source cannot be older, otherwise it
+           would have been found as the oldest one */
+        if ((i != source) && (other->count == 0) && (other->reachedNanos < timestampNanos))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Releases the oldest frame of the given source. */
+static int emitOldestFrameOf(CMRG_MergerType* merger,
+                             size_t source)
+{
+    CMRG_SourceType* src = &merger->sources[source];
+    const CMRG_FrameType* frame = oldestFrameOf(src);
+    src->head = (src->head + 1) % CMRG_QUEUE_LENGTH;
+    src->count--;
+
+    if (frame->timestampNanos < merger->lastEmittedNanos)
+    {
+        merger->framesOutOfOrder++;
+    }
+    else
+    {
+        merger->lastEmittedNanos = frame->timestampNanos;
+    }
+    /* the frame stays valid during the callback, as the slot is reused by
+       the next push at the earliest */
+    return merger->emitCb(merger->cbArg, source, frame);
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int CMRG_Init(CMRG_MergerType* merger,
+              size_t sourceCount,
+              uint64_t reorderWindowNanos,
+              CMRG_EmitCbType emitCb,
+              void* cbArg)
+{
+    if ((sourceCount == 0) || (sourceCount > CMRG_MAX_SOURCES))
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "invalid number of sources: %lu", (unsigned long)sourceCount);
+        return -1;
+    }
+    merger->sourceCount = sourceCount;
+    merger->reorderWindowNanos = reorderWindowNanos;
+    merger->emitCb = emitCb;
+    merger->cbArg = cbArg;
+    merger->lastEmittedNanos = 0;
+    merger->framesOutOfOrder = 0;
+    for (size_t i=0; i<sourceCount; i++)
+    {
+        merger->sources[i].head = 0;
+        merger->sources[i].count = 0;
+        merger->sources[i].reachedNanos = 0;
+    }
+    return 0;
+}
+
+int CMRG_Push(CMRG_MergerType* merger,
+              size_t source,
+              uint64_t timestampNanos,
+              const uint8_t* payload,
+              size_t length)
+{
+    if ((source >= merger->sourceCount) || (length > CDEC_MAX_PAYLOAD_LENGTH))
+    {
+        return -1;
+    }
+    CMRG_SourceType* src = &merger->sources[source];
+    while (src->count == CMRG_QUEUE_LENGTH)
+    {
+        /* the other sources are too far behind, give up waiting for them */
+        size_t oldestSource = source;
+        findOldestSource(merger, &oldestSource);
+        int rv = emitOldestFrameOf(merger, oldestSource);
+        if (rv != 0)
+        {
+            return rv;
+        }
+    }
+
+    CMRG_FrameType* frame = &src->frames[(src->head + src->count) % CMRG_QUEUE_LENGTH];
+    frame->timestampNanos = timestampNanos;
+    frame->length = length;
+    memcpy(frame->payload, payload, length);
+    src->count++;
+    if (timestampNanos > src->reachedNanos)
+    {
+        src->reachedNanos = timestampNanos;
+    }
+    return 0;
+}
+
+int CMRG_AdvanceSource(CMRG_MergerType* merger,
+                       size_t source,
+                       uint64_t timestampNanos)
+{
+    if (source >= merger->sourceCount)
+    {
+        return -1;
+    }
+    if (timestampNanos > merger->sources[source].reachedNanos)
+    {
+        merger->sources[source].reachedNanos = timestampNanos;
+    }
+    return 0;
+}
+
+int CMRG_Emit(CMRG_MergerType* merger,
+              uint64_t nowNanos,
+              uint64_t* nextDueNanos)
+{
+    size_t oldestSource;
+    while (findOldestSource(merger, &oldestSource))
+    {
+        uint64_t timestampNanos = oldestFrameOf(&merger->sources[oldestSource])->timestampNanos;
+        uint64_t dueNanos = timestampNanos + merger->reorderWindowNanos;
+        if ((nowNanos < dueNanos)
+         && (isOldestForSure(merger, oldestSource, timestampNanos) == false))
+        {
+            if (nextDueNanos != NULL)
+            {
+                *nextDueNanos = dueNanos;
+            }
+            return 0;
+        }
+        int rv = emitOldestFrameOf(merger, oldestSource);
+        if (rv != 0)
+        {
+            return rv;
+        }
+    }
+    if (nextDueNanos != NULL)
+    {
+        *nextDueNanos = CMRG_NOTHING_DUE;
+    }
+    return 0;
+}
+
+int CMRG_Drain(CMRG_MergerType* merger)
+{
+    size_t oldestSource;
+    while (findOldestSource(merger, &oldestSource))
+    {
+        int rv = emitOldestFrameOf(merger, oldestSource);
+        if (rv != 0)
+        {
+            return rv;
+        }
+    }
+    return 0;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
@@ -0,0 +1,241 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup capturinomerger
+ * \brief Merges the frames captured by several CAPTURino devices into a
+ *        single stream ordered by the timestamps of the frames.
+ *
+ * Every device is a source whose frames arrive in timestamp order. The frames
+ * are held back per source until it is certain that no other source delivers
+ * an older frame. This is the case once every other source has either a
+ * newer frame queued or reported to have reached a newer point in time, e.g.
+ * by a null frame. A source which stays silent must not stop the stream, so
+ * a frame is released at the latest when the current time exceeds its
+ * timestamp by the reorder window.
+ *
+ * @{
+ */
+/* ************************************************************************* */
+
+#ifndef CAPTURINOMERGER_H_INCLUDED
+#define CAPTURINOMERGER_H_INCLUDED
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stddef.h>
+#include <stdint.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "capturinodecoder.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+/** maximum number of devices captured at the same time */
+#define CMRG_MAX_SOURCES        (8)
+/** number of frames held back per source. If a source's queue is full, the
+    oldest frames are released regardless of the other sources. */
+#define CMRG_QUEUE_LENGTH       (256)
+/** reorder window used if none is configured. Must cover the latency
+    differences between the devices and the host */
+#define CMRG_DEFAULT_REORDER_WINDOW_MS  (50)
+/** value of nextDueNanos if no frame is held back */
+#define CMRG_NOTHING_DUE        (UINT64_MAX)
+
+/* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * */
+typedef struct
+{
+    uint64_t timestampNanos;
+    size_t   length;
+    uint8_t  payload[CDEC_MAX_PAYLOAD_LENGTH];
+} CMRG_FrameType;
+
+/** Called for every frame released by the merger, in timestamp order.
+ *
+ * \param[in] cbArg the argument given to CMRG_Init().
+ * \param[in] source index of the source the frame was pushed to.
+ * \param[in] frame the frame. Only valid during the call.
+ *
+ * \returns 0: on success.
+ * \returns any other value: on an error, which is returned by the merger
+ *          function that released the frame.
+ */
+typedef int (*CMRG_EmitCbType)(void* cbArg,
+                               size_t source,
+                               const CMRG_FrameType* frame);
+
+typedef struct
+{
+    CMRG_FrameType frames[CMRG_QUEUE_LENGTH];
+    size_t         head;                /**< index of the oldest frame */
+    size_t         count;
+    uint64_t       reachedNanos;        /**< the source will not deliver any
+                                             frame older than this */
+} CMRG_SourceType;
+
+typedef struct
+{
+    CMRG_SourceType sources[CMRG_MAX_SOURCES];
+    size_t          sourceCount;
+    uint64_t        reorderWindowNanos;
+    CMRG_EmitCbType emitCb;
+    void*           cbArg;
+    uint64_t        lastEmittedNanos;
+    uint64_t        framesOutOfOrder;   /**< frames released after a newer
+                                             frame, because they arrived too
+                                             late */
+} CMRG_MergerType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E C L A R A T I O N S * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * */
+/** Initializes a merger without any frames held back.
+ *
+ * \param[out] merger the merger to be initialized.
+ * \param[in] sourceCount number of sources, at most CMRG_MAX_SOURCES.
+ * \param[in] reorderWindowNanos time a frame is held back at most while
+ *                               waiting for the other sources.
+ * \param[in] emitCb callback for released frames.
+ * \param[in] cbArg argument passed to the callback.
+ *
+ * \returns 0: on success.
+ * \returns -1: if sourceCount is invalid.
+ */
+int CMRG_Init(CMRG_MergerType* merger,
+              size_t           sourceCount,
+              uint64_t         reorderWindowNanos,
+              CMRG_EmitCbType  emitCb,
+              void*            cbArg);
+
+/** Queues a frame of a source. The frame is not released before the next
+ * call to CMRG_Emit(), unless the queue of the source is full.
+ *
+ * \param[in] merger the merger.
+ * \param[in] source index of the source.
+ * \param[in] timestampNanos timestamp of the frame.
+ * \param[in] payload the payload of the frame.
+ * \param[in] length number of bytes in payload, at most
+ *                   CDEC_MAX_PAYLOAD_LENGTH.
+ *
+ * \returns 0: on success.
+ * \returns -1: if the arguments are invalid.
+ * \returns any other value: the error returned by the callback.
+ */
+int CMRG_Push(CMRG_MergerType* merger,
+              size_t           source,
+              uint64_t         timestampNanos,
+              const uint8_t*   payload,
+              size_t           length);
+
+/** Reports that a source will not deliver any frame older than the given
+ * timestamp, e.g. on receiving a null frame.
+ *
+ * \param[in] merger the merger.
+ * \param[in] source index of the source.
+ * \param[in] timestampNanos the time reached by the source.
+ *
+ * \returns 0: on success.
+ * \returns -1: if the source is invalid.
+ */
+int CMRG_AdvanceSource(CMRG_MergerType* merger,
+                       size_t           source,
+                       uint64_t         timestampNanos);
+
+/** Releases all frames in timestamp order, which are either certain to be
+ * the oldest or whose reorder window has expired.
+ *
+ * \param[in] merger the merger.
+ * \param[in] nowNanos the current time, on the same timebase as the frames.
+ * \param[out] nextDueNanos time at which the window of the oldest frame held
+ *                          back expires or CMRG_NOTHING_DUE. May be NULL.
+ *
+ * \returns 0: on success.
+ * \returns any other value: the error returned by the callback.
+ */
+int CMRG_Emit(CMRG_MergerType* merger,
+              uint64_t         nowNanos,
+              uint64_t*        nextDueNanos);
+
+/** Releases all frames held back in timestamp order, e.g. at the end of the
+ * capture.
+ *
+ * \param[in] merger the merger.
+ *
+ * \returns 0: on success.
+ * \returns any other value: the error returned by the callback.
+ */
+int CMRG_Drain(CMRG_MergerType* merger);
+
+/* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
+/** Gets the number of frames that can be pushed to a source without
+ * releasing frames early. */
+static inline size_t CMRG_GetFreeSlots(const CMRG_MergerType* merger,
+                                       size_t source)
+{
+    return CMRG_QUEUE_LENGTH - merger->sources[source].count;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAPTURINOMERGER_H_INCLUDED */
+
+/**
+ * @}
+ */
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
@@ -0,0 +1,411 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup devicecache
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "diagnosis.h"
+#include "systemutils.h"
+
+/* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
+#include "devicecache.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+/** maximum length of a line in the cache file */
+#define MAX_LINE_LENGTH     (512)
+/** number of tab separated fields of an entry */
+#define FIELD_COUNT         (8)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
+
+/* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
+static const char* MODULE_NAME = "DVCC";
+static const char FILE_HEADER[] = "# CAPTURino device cache, format 1\n";
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * * */
+
+/* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
+/** Checks if a string can be written as a field of the cache file. */
+static inline bool isStorable(const char* str)
+{
+    return (strpbrk(str, "\t\r\n") == NULL);
+}
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static bool isSameIdentity(const DVCC_IdentityType* a,
+                           const DVCC_IdentityType* b)
+{
+    return (strcmp(a->portPath, b->portPath) == 0)
+        && (strcmp(a->serialNumber, b->serialNumber) == 0)
+        && (a->deviceId == b->deviceId)
+        && (a->nodeId == b->nodeId)
+        && (a->changeTime == b->changeTime);
+}
+
+/** Copies a field to a buffer of the given size.
+ *
+ * \returns false: if the field does not fit into the buffer.
+ */
+static bool copyField(char* dest,
+                      size_t destSize,
+                      const char* field)
+{
+    size_t length = strlen(field);
+    if (length >= destSize)
+    {
+        return false;
+    }
+    memcpy(dest, field, length + 1);
+    return true;
+}
+
+/** Parses an unsigned number which must span the whole field. */
+static bool parseNumber(const char* field,
+                        int base,
+                        uint64_t* value)
+{
+    char* endptr = NULL;
+    if (field[0] == '\0')
+    {
+        return false;
+    }
+    errno = 0;
+    *value = (uint64_t)strtoull(field, &endptr, base);
+    return (errno == 0) && (*endptr == '\0');
+}
+
+/** Parses the comma separated link types. */
+static bool parseDlts(char* field,
+                      DVCC_EntryType* entry)
+{
+    entry->dltsCount = 0;
+    if (field[0] == '\0')
+    {
+        return true;
+    }
+    char* dlt = field;
+    while (dlt != NULL)
+    {
+        char* next = strchr(dlt, ',');
+        if (next != NULL)
+        {
+            *next = '\0';
+            next++;
+        }
+        uint64_t value;
+        if ((entry->dltsCount >= DVCC_MAX_DLTS)
+         || (parseNumber(dlt, 10, &value) == false)
+         || (value > UINT32_MAX))
+        {
+            return false;
+        }
+        entry->dlts[entry->dltsCount++] = (uint32_t)value;
+        dlt = next;
+    }
+    return true;
+}
+
+/** Parses a line of the cache file, which is modified in place. */
+static bool parseLine(char* line,
+                      DVCC_EntryType* entry)
+{
+    char* fields[FIELD_COUNT];
+    size_t fieldCount = 0;
+    line[strcspn(line, "\r\n")] = '\0';
+
+    char* field = line;
+    while ((field != NULL) && (fieldCount < FIELD_COUNT))
+    {
+        fields[fieldCount++] = field;
+        field = strchr(field, '\t');
+        if (field != NULL)
+        {
+            *field = '\0';
+            field++;
+        }
+    }
+    if ((fieldCount != FIELD_COUNT) || (field != NULL))
+    {
+        return false;
+    }
+
+    uint64_t boardId;
+    if ((fields[0][0] == '\0')
+     || (copyField(entry->identity.portPath, sizeof(entry->identity.portPath), fields[0]) == false)
+     || (copyField(entry->identity.serialNumber, sizeof(entry->identity.serialNumber), fields[1]) == false)
+     || (parseNumber(fields[2], 10, &entry->identity.deviceId) == false)
+     || (parseNumber(fields[3], 10, &entry->identity.nodeId) == false)
+     || (parseNumber(fields[4], 10, &entry->identity.changeTime) == false)
+     || (parseNumber(fields[5], 10, &entry->validatedUnixTime) == false)
+     || (parseNumber(fields[6], 16, &boardId) == false)
+     || (boardId > UINT32_MAX))
+    {
+        return false;
+    }
+    entry->boardId = (uint32_t)boardId;
+    return parseDlts(fields[7], entry);
+}
+
+static int writeEntries(const DVCC_CacheType* cache,
+                        FILE* file)
+{
+    if (fputs(FILE_HEADER, file) < 0)
+    {
+        return -1;
+    }
+    for (size_t i=0; i<cache->count; i++)
+    {
+        const DVCC_EntryType* entry = &cache->entries[i];
+        if (fprintf(file, "%s\t%s\t%llu\t%llu\t%llu\t%llu\t%08lX\t",
+                    entry->identity.portPath,
+                    entry->identity.serialNumber,
+                    (unsigned long long)entry->identity.deviceId,
+                    (unsigned long long)entry->identity.nodeId,
+                    (unsigned long long)entry->identity.changeTime,
+                    (unsigned long long)entry->validatedUnixTime,
+                    (unsigned long)entry->boardId) < 0)
+        {
+            return -1;
+        }
+        for (size_t j=0; j<entry->dltsCount; j++)
+        {
+            if (fprintf(file, (j == 0) ? "%lu" : ",%lu", (unsigned long)entry->dlts[j]) < 0)
+            {
+                return -1;
+            }
+        }
+        if (fputc('\n', file) == EOF)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+void DVCC_Init(DVCC_CacheType* cache)
+{
+    cache->count = 0;
+}
+
+int DVCC_Load(DVCC_CacheType* cache,
+              const char* path)
+{
+    DVCC_Init(cache);
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+    {
+        if (errno == ENOENT)
+        {
+            return 0;
+        }
+        DIAG_LogMsgArg(DIAG_WARNING, MODULE_NAME, __func__, "unable to open \'%s\', strerror() is \'%s\'", path, strerror(errno));
+        return -1;
+    }
+
+    char line[MAX_LINE_LENGTH];
+    while ((cache->count < DVCC_MAX_ENTRIES) && (fgets(line, sizeof(line), file) != NULL))
+    {
+        if ((line[0] == '#') || (line[0] == '\n'))
+        {
+            continue;
+        }
+        if (parseLine(line, &cache->entries[cache->count]) == true)
+        {
+            cache->count++;
+        }
+        else
+        {
+            DIAG_LogMsg(DIAG_WARNING, MODULE_NAME, __func__, "dropping an invalid line of the cache file");
+        }
+    }
+    int rv = (ferror(file) != 0) ? -1 : 0;
+    fclose(file);
+    if (rv != 0)
+    {
+        DVCC_Init(cache);
+    }
+    return rv;
+}
+
+int DVCC_Save(const DVCC_CacheType* cache,
+              const char* path)
+{
+    /* several instances of the plugin may save the cache at the same time,
+       each one replaces the file with its own complete copy */
+    unsigned long processId;
+    SYSU_GetProcessId(&processId);
+    char tempPath[DVCC_MAX_PORT_LENGTH + 256];
+    int written = snprintf(tempPath, sizeof(tempPath), "%s.%lu.tmp", path, processId);
+    if ((written < 0) || ((size_t)written >= sizeof(tempPath)))
+    {
+        return -1;
+    }
+
+    FILE* file = fopen(tempPath, "w");
+    if (file == NULL)
+    {
+        DIAG_LogMsgArg(DIAG_WARNING, MODULE_NAME, __func__, "unable to create \'%s\', strerror() is \'%s\'", tempPath, strerror(errno));
+        return -1;
+    }
+    int rv = writeEntries(cache, file);
+    if (fclose(file) != 0)
+    {
+        rv = -1;
+    }
+    if (rv == 0)
+    {
+        /* rename() does not replace an existing file on Windows */
+        if ((rename(tempPath, path) != 0)
+         && ((remove(path) != 0) || (rename(tempPath, path) != 0)))
+        {
+            rv = -1;
+        }
+    }
+    if (rv != 0)
+    {
+        DIAG_LogMsgArg(DIAG_WARNING, MODULE_NAME, __func__, "unable to write \'%s\'", path);
+        remove(tempPath);
+    }
+    return rv;
+}
+
+const DVCC_EntryType* DVCC_Lookup(const DVCC_CacheType* cache,
+                                  const DVCC_IdentityType* identity,
+                                  uint64_t nowUnixTime,
+                                  uint64_t ttlSeconds)
+{
+    for (size_t i=0; i<cache->count; i++)
+    {
+        const DVCC_EntryType* entry = &cache->entries[i];
+        if (strcmp(entry->identity.portPath, identity->portPath) != 0)
+        {
+            continue;
+        }
+        if (isSameIdentity(&entry->identity, identity) == false)
+        {
+            DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "another device is connected to \'%s\'", identity->portPath);
+            return NULL;
+        }
+        /* an entry from the future is treated as expired, e.g. after the
+           clock of the host was set back */
+        if ((nowUnixTime < entry->validatedUnixTime)
+         || ((nowUnixTime - entry->validatedUnixTime) >= ttlSeconds))
+        {
+            DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "cache entry of \'%s\' expired", identity->portPath);
+            return NULL;
+        }
+        return entry;
+    }
+    return NULL;
+}
+
+int DVCC_Store(DVCC_CacheType* cache,
+               const DVCC_EntryType* entry)
+{
+    if ((isStorable(entry->identity.portPath) == false)
+     || (isStorable(entry->identity.serialNumber) == false)
+     || (entry->identity.portPath[0] == '\0')
+     || (entry->dltsCount > DVCC_MAX_DLTS))
+    {
+        return -1;
+    }
+
+    size_t slot = cache->count;
+    for (size_t i=0; i<cache->count; i++)
+    {
+        if (strcmp(cache->entries[i].identity.portPath, entry->identity.portPath) == 0)
+        {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == DVCC_MAX_ENTRIES)
+    {
+        slot = 0;
+        for (size_t i=1; i<cache->count; i++)
+        {
+            if (cache->entries[i].validatedUnixTime < cache->entries[slot].validatedUnixTime)
+            {
+                slot = i;
+            }
+        }
+    }
+    else if (slot == cache->count)
+    {
+        cache->count++;
+    }
+    cache->entries[slot] = *entry;
+    return 0;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
@@ -0,0 +1,203 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup devicecache
+ * \brief Persistent cache of the board IDs and link types of the CAPTURino
+ *        devices connected to the serial ports.
+ *
+ * Wireshark starts the plugin again for every configuration request, and
+ * querying the device takes a session handshake and two commands. The
+ * results are stored in a file and reused as long as the same device is
+ * connected to the port, i.e. the identity of the port is unchanged, and the
+ * entry has not expired.
+ *
+ * The file holds a line per port with tab separated fields. Lines which
+ * cannot be parsed are dropped, so a corrupted file only costs a query of
+ * the devices.
+ *
+ * @{
+ */
+/* ************************************************************************* */
+
+#ifndef DEVICECACHE_H_INCLUDED
+#define DEVICECACHE_H_INCLUDED
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stddef.h>
+#include <stdint.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+/** maximum number of ports kept in the cache */
+#define DVCC_MAX_ENTRIES                (16)
+/** maximum number of link types stored per device */
+#define DVCC_MAX_DLTS                   (8)
+/** maximum length of a port path including the terminating zero */
+#define DVCC_MAX_PORT_LENGTH            (128)
+/** maximum length of a serial number including the terminating zero */
+#define DVCC_MAX_SERIAL_NUMBER_LENGTH   (64)
+/** time after which an entry is validated by querying the device again, even
+    if the identity of the port is unchanged */
+#define DVCC_DEFAULT_TTL_SECONDS        (3600ULL)
+/** name of the cache file in the cache directory of the user */
+#define DVCC_FILE_NAME                  "capturino-devices.cache"
+
+/* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * */
+/** Identity of a port and the device connected to it. An entry is only used
+ * if all fields match. */
+typedef struct
+{
+    char     portPath[DVCC_MAX_PORT_LENGTH];
+    char     serialNumber[DVCC_MAX_SERIAL_NUMBER_LENGTH];
+    uint64_t deviceId;
+    uint64_t nodeId;
+    uint64_t changeTime;
+} DVCC_IdentityType;
+
+typedef struct
+{
+    DVCC_IdentityType identity;
+    uint64_t          validatedUnixTime;    /**< time the device was queried */
+    uint32_t          boardId;
+    uint32_t          dlts[DVCC_MAX_DLTS];
+    size_t            dltsCount;
+} DVCC_EntryType;
+
+typedef struct
+{
+    DVCC_EntryType entries[DVCC_MAX_ENTRIES];
+    size_t         count;
+} DVCC_CacheType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E C L A R A T I O N S * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * */
+/** Initializes an empty cache.
+ *
+ * \param[out] cache the cache to be initialized.
+ */
+void DVCC_Init(DVCC_CacheType* cache);
+
+/** Loads the cache from a file. A missing file results in an empty cache.
+ *
+ * \param[out] cache the cache.
+ * \param[in] path path of the cache file.
+ *
+ * \returns 0: if the file was read or does not exist.
+ * \returns -1: if the file exists but could not be read. The cache is empty.
+ */
+int DVCC_Load(DVCC_CacheType* cache,
+              const char*     path);
+
+/** Saves the cache to a file. The file is replaced at once by a temporary
+ * file of the calling process, so a concurrent load never reads a partially
+ * written file and concurrent saves do not mix their entries.
+ *
+ * \param[in] cache the cache.
+ * \param[in] path path of the cache file.
+ *
+ * \returns 0: if the file was written.
+ * \returns -1: if the function failed.
+ */
+int DVCC_Save(const DVCC_CacheType* cache,
+              const char*           path);
+
+/** Looks up the entry of a port.
+ *
+ * \param[in] cache the cache.
+ * \param[in] identity the current identity of the port.
+ * \param[in] nowUnixTime the current time in seconds since the unix epoch.
+ * \param[in] ttlSeconds time an entry stays valid after the device was
+ *                       queried.
+ *
+ * \returns the entry, or NULL if the port is not cached, its identity changed
+ *          or the entry expired.
+ */
+const DVCC_EntryType* DVCC_Lookup(const DVCC_CacheType*    cache,
+                                  const DVCC_IdentityType* identity,
+                                  uint64_t                 nowUnixTime,
+                                  uint64_t                 ttlSeconds);
+
+/** Stores the entry of a port, replacing a previous one of the same port. If
+ * the cache is full, the entry validated at the earliest is dropped.
+ *
+ * \param[in] cache the cache.
+ * \param[in] entry the entry.
+ *
+ * \returns 0: on success.
+ * \returns -1: if the entry cannot be stored in the file, e.g. if the port
+ *              path contains a tab or newline character.
+ */
+int DVCC_Store(DVCC_CacheType*       cache,
+               const DVCC_EntryType* entry);
+
+/* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEVICECACHE_H_INCLUDED */
+
+/**
+ * @}
+ */
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
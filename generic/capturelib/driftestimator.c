@@ -0,0 +1,243 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup driftestimator
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "diagnosis.h"
+
+/* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
+#include "driftestimator.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+/** number of sample pairs the Theil-Sen estimator takes the slope of */
+#define MAX_SLOPES      (DRFT_MAX_SAMPLES * (DRFT_MAX_SAMPLES - 1) / 2)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
+
+/* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
+static const char* MODULE_NAME = "DRFT";
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * * */
+
+/* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
+static inline int64_t roundToInt64(double value)
+{
+    return (int64_t)((value >= 0.0) ? (value + 0.5) : (value - 0.5));
+}
+
+static inline const DRFT_SampleType* sampleAt(const DRFT_EstimatorType* estimator,
+                                              size_t i)
+{
+    return &estimator->samples[(estimator->head + i) % DRFT_MAX_SAMPLES];
+}
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static int compareDoubles(const void* a,
+                          const void* b)
+{
+    double valA = *((const double*)a);
+    double valB = *((const double*)b);
+    return (valA > valB) - (valA < valB);
+}
+
+/** Sorts the given values and returns their median. */
+static double median(double* values,
+                     size_t count)
+{
+    qsort(values, count, sizeof(double), compareDoubles);
+    if ((count % 2) == 0)
+    {
+        return (values[count/2 - 1] + values[count/2]) / 2.0;
+    }
+    return values[count/2];
+}
+
+/** Fits a line through the samples and updates the estimate evaluated for
+ * every frame. The offsets are taken relative to the timebase of the session
+ * start to keep the precision of the double values. */
+static void fitSamples(DRFT_EstimatorType* estimator)
+{
+    const size_t count = estimator->count;
+    const uint64_t refDeviceMicros = sampleAt(estimator, count - 1)->deviceMicros;
+    const int64_t baseOffsetNanos = estimator->sync.offsetNanos;
+
+    double slopes[MAX_SLOPES];
+    size_t slopeCount = 0;
+    for (size_t i=0; i<count; i++)
+    {
+        for (size_t j=i+1; j<count; j++)
+        {
+            const DRFT_SampleType* sampleI = sampleAt(estimator, i);
+            const DRFT_SampleType* sampleJ = sampleAt(estimator, j);
+            if (sampleJ->deviceMicros > sampleI->deviceMicros)
+            {
+                slopes[slopeCount++] = (double)(sampleJ->offsetNanos - sampleI->offsetNanos)
+                                     / (double)(sampleJ->deviceMicros - sampleI->deviceMicros);
+            }
+        }
+    }
+    double slope = (slopeCount > 0) ? median(slopes, slopeCount) : 0.0;
+
+    /* the offset at the reference time is the median of the offsets
+       projected onto it */
+    double projected[DRFT_MAX_SAMPLES];
+    for (size_t i=0; i<count; i++)
+    {
+        const DRFT_SampleType* sample = sampleAt(estimator, i);
+        projected[i] = (double)(sample->offsetNanos - baseOffsetNanos)
+                     - slope * (double)(int64_t)(sample->deviceMicros - refDeviceMicros);
+    }
+    double intercept = median(projected, count);
+
+    if (estimator->biasValid == false)
+    {
+        /* the session start timebase is not biased by the transfer latency,
+           the difference of the fit to it is the minimum latency. It is
+           refined as long as the oldest sample is from the session start */
+        estimator->biasNanos = roundToInt64(intercept + slope * (double)(int64_t)(estimator->sync.deviceMicros - refDeviceMicros));
+        if (count == DRFT_MAX_SAMPLES)
+        {
+            estimator->biasValid = true;
+            DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "minimum transfer latency estimated to %lld ns", (long long)estimator->biasNanos);
+        }
+    }
+
+    estimator->refDeviceMicros = refDeviceMicros;
+    estimator->refOffsetNanos = baseOffsetNanos + roundToInt64(intercept) - estimator->biasNanos;
+    estimator->skew = roundToInt64(slope * (double)DRFT_SKEW_ONE);
+    DIAG_LogMsgArg(DIAG_DEBUG, MODULE_NAME, __func__, "estimated skew of the device clock is %lld ppb", (long long)DRFT_GetSkewPpb(estimator));
+}
+
+static void addBucket(DRFT_EstimatorType* estimator)
+{
+    if (estimator->count == DRFT_MAX_SAMPLES)
+    {
+        estimator->head = (estimator->head + 1) % DRFT_MAX_SAMPLES;
+        estimator->count--;
+    }
+    estimator->samples[(estimator->head + estimator->count) % DRFT_MAX_SAMPLES] = estimator->bucket;
+    estimator->count++;
+    if (estimator->count >= DRFT_MIN_FIT_SAMPLES)
+    {
+        fitSamples(estimator);
+    }
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+void DRFT_Init(DRFT_EstimatorType* estimator,
+               uint64_t deviceMicros,
+               uint64_t hostNanos)
+{
+    estimator->head = 0;
+    estimator->count = 0;
+    estimator->bucketValid = false;
+    estimator->bucketEndMicros = 0;
+    estimator->sync.deviceMicros = deviceMicros;
+    estimator->sync.offsetNanos = (int64_t)(hostNanos - deviceMicros * 1000ULL);
+    estimator->biasValid = false;
+    estimator->biasNanos = 0;
+    estimator->refDeviceMicros = deviceMicros;
+    estimator->refOffsetNanos = estimator->sync.offsetNanos;
+    estimator->skew = 0;
+}
+
+void DRFT_AddSample(DRFT_EstimatorType* estimator,
+                    uint64_t deviceMicros,
+                    uint64_t hostNanos)
+{
+    DRFT_SampleType sample = {
+        .deviceMicros = deviceMicros,
+        .offsetNanos = (int64_t)(hostNanos - deviceMicros * 1000ULL)
+    };
+
+    if ((estimator->bucketValid == true) && (deviceMicros >= estimator->bucketEndMicros))
+    {
+        addBucket(estimator);
+        estimator->bucketValid = false;
+    }
+    if (estimator->bucketValid == false)
+    {
+        estimator->bucket = sample;
+        estimator->bucketEndMicros = deviceMicros + DRFT_BUCKET_MICROS;
+        estimator->bucketValid = true;
+    }
+    else if (sample.offsetNanos < estimator->bucket.offsetNanos)
+    {
+        /* lower latency than all other samples of the bucket */
+        estimator->bucket = sample;
+    }
+}
+
+int64_t DRFT_GetSkewPpb(const DRFT_EstimatorType* estimator)
+{
+    return (estimator->skew * 1000000LL) / DRFT_SKEW_ONE;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
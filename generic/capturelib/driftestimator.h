@@ -0,0 +1,195 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup driftestimator
+ * \brief Estimates the offset and the drift of the clock of a CAPTURino
+ *        device relative to the host clock.
+ *
+ * The timebase taken at the start of a session is only exact at that time,
+ * as the crystal of the device runs slightly faster or slower than the host
+ * clock. During the capture, the device timestamps of the received frames
+ * are sampled together with the host time of their reception. The host time
+ * is always later by the transfer latency, thus only the sample with the
+ * lowest latency of every bucket is kept. A line fitted through these samples
+ * by the Theil-Sen estimator, which is insensitive to outliers, gives the
+ * offset and the skew of the device clock.
+ *
+ * The samples are biased by the minimum transfer latency. The bias is
+ * determined by comparing the fits of the first buckets to the timebase taken
+ * at the start of the session and removed from all following fits.
+ *
+ * @{
+ */
+/* ************************************************************************* */
+
+#ifndef DRIFTESTIMATOR_H_INCLUDED
+#define DRIFTESTIMATOR_H_INCLUDED
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+/** number of buckets the line is fitted through. Together with the bucket
+    length this is the time span the estimate follows changes of the drift,
+    e.g. due to the temperature of the crystal. */
+#define DRFT_MAX_SAMPLES            (64)
+/** device time covered by a bucket */
+#define DRFT_BUCKET_MICROS          (4000000ULL)
+/** number of buckets necessary for the first fit */
+#define DRFT_MIN_FIT_SAMPLES        (4)
+/** fixed point representation of a skew of 1 ns per us */
+#define DRFT_SKEW_ONE               (4294967296LL)
+
+/* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * */
+typedef struct
+{
+    uint64_t deviceMicros;
+    int64_t  offsetNanos;   /**< host time minus device time */
+} DRFT_SampleType;
+
+typedef struct
+{
+    DRFT_SampleType samples[DRFT_MAX_SAMPLES];  /**< lowest latency sample of
+                                                     the latest buckets */
+    size_t          head;                       /**< index of the oldest
+                                                     sample */
+    size_t          count;
+    DRFT_SampleType bucket;                     /**< lowest latency sample of
+                                                     the current bucket */
+    bool            bucketValid;
+    uint64_t        bucketEndMicros;
+    DRFT_SampleType sync;                       /**< timebase taken at the
+                                                     start of the session */
+    bool            biasValid;                  /**< biasNanos is final */
+    int64_t         biasNanos;                  /**< minimum transfer latency */
+    /* current estimate, evaluated for every frame */
+    uint64_t        refDeviceMicros;
+    int64_t         refOffsetNanos;
+    int64_t         skew;                       /**< ns per us, in units of
+                                                     1/DRFT_SKEW_ONE */
+} DRFT_EstimatorType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E C L A R A T I O N S * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * */
+/** Initializes an estimator with the timebase taken at the start of the
+ * session. Until enough samples are available, the device clock is assumed
+ * to run at the rate of the host clock.
+ *
+ * \param[out] estimator the estimator to be initialized.
+ * \param[in] deviceMicros device time at hostNanos.
+ * \param[in] hostNanos host time in nanoseconds since the unix epoch.
+ */
+void DRFT_Init(DRFT_EstimatorType* estimator,
+               uint64_t            deviceMicros,
+               uint64_t            hostNanos);
+
+/** Adds a sample, i.e. the device timestamp of a received frame and the host
+ * time at its reception. The estimate is updated whenever a bucket is
+ * complete.
+ *
+ * \param[in] estimator the estimator.
+ * \param[in] deviceMicros device timestamp, extended to 64 bit. Must not
+ *                         decrease from sample to sample.
+ * \param[in] hostNanos host time in nanoseconds since the unix epoch.
+ */
+void DRFT_AddSample(DRFT_EstimatorType* estimator,
+                    uint64_t            deviceMicros,
+                    uint64_t            hostNanos);
+
+/** Gets the skew of the device clock estimated at last.
+ *
+ * \returns the deviation of the device clock in parts per billion. Positive
+ *          if the device clock runs slower than the host clock.
+ */
+int64_t DRFT_GetSkewPpb(const DRFT_EstimatorType* estimator);
+
+/* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
+/** Converts a device timestamp to the host time, called for every frame.
+ *
+ * \param[in] estimator the estimator.
+ * \param[in] deviceMicros device timestamp, extended to 64 bit.
+ *
+ * \returns the host time in nanoseconds since the unix epoch.
+ */
+static inline uint64_t DRFT_ToHostNanos(const DRFT_EstimatorType* estimator,
+                                        uint64_t                  deviceMicros)
+{
+    int64_t deltaMicros = (int64_t)(deviceMicros - estimator->refDeviceMicros);
+    /* the division by a power of two is compiled to a shift */
+    int64_t skewNanos = (deltaMicros * estimator->skew) / DRFT_SKEW_ONE;
+    return deviceMicros * 1000ULL
+         + (uint64_t)(estimator->refOffsetNanos + skewNanos);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIFTESTIMATOR_H_INCLUDED */
+
+/**
+ * @}
+ */
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
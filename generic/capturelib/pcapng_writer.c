@@ -0,0 +1,284 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "diagnosis.h"
+#include "pcap_writer.h"
+#include "pipehandling.h"
+
+/* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
+#include "pcapng_writer.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+#define BLOCK_TYPE_SHB              (0x0A0D0D0AUL)
+#define BLOCK_TYPE_IDB              (0x00000001UL)
+#define BLOCK_TYPE_ISB              (0x00000005UL)
+#define BLOCK_TYPE_EPB              (0x00000006UL)
+
+#define BYTE_ORDER_MAGIC            (0x1A2B3C4DUL)
+
+#define OPT_ENDOFOPT                (0)
+#define OPT_COMMENT                 (1)
+#define OPT_SHB_USERAPPL            (4)
+#define OPT_IF_NAME                 (2)
+#define OPT_IF_TSRESOL              (9)
+#define OPT_ISB_IFRECV              (4)
+#define OPT_ISB_IFDROP              (5)
+
+/** length of the if_name option value, longer names are truncated */
+#define MAX_INTERFACE_NAME_LENGTH   (128)
+/** length of the opt_comment option value, longer comments are truncated */
+#define MAX_COMMENT_LENGTH          (256)
+
+/** block type, block total length and the fields of the enhanced packet
+    block up to the packet data */
+#define EPB_HEADER_LENGTH           (28)
+/** the trailing block total length */
+#define BLOCK_TRAILER_LENGTH        (4)
+/** the enhanced packet block with the largest packet is the largest block
+    written by this module */
+#define BLOCK_BUFFER_SIZE           (EPB_HEADER_LENGTH + PCNG_MAX_SNAP_LENGTH + 1 + BLOCK_TRAILER_LENGTH)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+/** rounds up to the next multiple of 4, as all blocks and options are 32 bit
+    aligned */
+#define PAD32(x)                    (((x) + 3) & ~((size_t)3))
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
+/** every block is built within this buffer before it is written */
+static uint8_t mBlockBuffer[BLOCK_BUFFER_SIZE];
+
+static uint32_t mInterfaceSnapLengths[PCNG_MAX_INTERFACES];
+static uint32_t mInterfaceCount = 0;
+
+/* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
+static const char* MODULE_NAME = "PCNG";
+
+static const char USER_APPLICATION[] = "CAPTURino Wireshark plugin";
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * * */
+
+/* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
+/* NOTE: pcapng files are written in the byte order of the host, the reader
+         detects it by the byte order magic of the section header block */
+static inline size_t putU16(size_t pos, uint16_t value)
+{
+    memcpy(&mBlockBuffer[pos], &value, sizeof(value));
+    return pos + sizeof(value);
+}
+
+static inline size_t putU32(size_t pos, uint32_t value)
+{
+    memcpy(&mBlockBuffer[pos], &value, sizeof(value));
+    return pos + sizeof(value);
+}
+
+static inline size_t putU64(size_t pos, uint64_t value)
+{
+    memcpy(&mBlockBuffer[pos], &value, sizeof(value));
+    return pos + sizeof(value);
+}
+
+/** Timestamps are stored as upper 32 bits followed by the lower 32 bits,
+    independent of the byte order. */
+static inline size_t putTimestamp(size_t pos, uint64_t timestamp)
+{
+    pos = putU32(pos, (uint32_t)(timestamp >> 32));
+    return putU32(pos, (uint32_t)timestamp);
+}
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+/** Appends an option and pads its value to 32 bits. */
+static size_t putOption(size_t pos, uint16_t code, const void* value, uint16_t length)
+{
+    pos = putU16(pos, code);
+    pos = putU16(pos, length);
+    if (length > 0)
+    {
+        memcpy(&mBlockBuffer[pos], value, length);
+    }
+    memset(&mBlockBuffer[pos + length], 0, PAD32(length) - length);
+    return pos + PAD32(length);
+}
+
+/** Starts a block of the given type, the length is filled by writeBlock(). */
+static size_t beginBlock(uint32_t blockType)
+{
+    size_t pos = putU32(0, blockType);
+    return putU32(pos, 0);
+}
+
+/** Completes the block ending at pos and writes it. */
+static int writeBlock(PipeHandleType hFile, size_t pos)
+{
+    uint32_t blockTotalLength = (uint32_t)(pos + BLOCK_TRAILER_LENGTH);
+    putU32(4, blockTotalLength);
+    putU32(pos, blockTotalLength);
+    return PCAP_WriteBuffered(hFile, mBlockBuffer, blockTotalLength);
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int PCNG_WriteSectionHeader(PipeHandleType hFile)
+{
+    mInterfaceCount = 0;
+
+    size_t pos = beginBlock(BLOCK_TYPE_SHB);
+    pos = putU32(pos, BYTE_ORDER_MAGIC);
+    pos = putU16(pos, 1); /* major version */
+    pos = putU16(pos, 0); /* minor version */
+    /* the section length is unknown as the file is written as a stream */
+    pos = putU64(pos, UINT64_MAX);
+    pos = putOption(pos, OPT_SHB_USERAPPL, USER_APPLICATION, sizeof(USER_APPLICATION) - 1);
+    pos = putOption(pos, OPT_ENDOFOPT, NULL, 0);
+    return writeBlock(hFile, pos);
+}
+
+int PCNG_WriteInterfaceDescription(PipeHandleType hFile,
+                                   PCAP_ValidLinkTypesType linkType,
+                                   uint32_t snapLength,
+                                   uint8_t tsresol,
+                                   const char* name,
+                                   uint32_t* interfaceId)
+{
+    if (mInterfaceCount >= PCNG_MAX_INTERFACES)
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "no more than %d interfaces supported!", PCNG_MAX_INTERFACES);
+        return -1;
+    }
+    if ((snapLength == 0) || (snapLength > PCNG_MAX_SNAP_LENGTH))
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "invalid snap length %u!", snapLength);
+        return -1;
+    }
+
+    size_t pos = beginBlock(BLOCK_TYPE_IDB);
+    pos = putU16(pos, (uint16_t)linkType);
+    pos = putU16(pos, 0); /* reserved */
+    pos = putU32(pos, snapLength);
+    if (name != NULL)
+    {
+        pos = putOption(pos, OPT_IF_NAME, name, (uint16_t)strnlen(name, MAX_INTERFACE_NAME_LENGTH));
+    }
+    pos = putOption(pos, OPT_IF_TSRESOL, &tsresol, sizeof(tsresol));
+    pos = putOption(pos, OPT_ENDOFOPT, NULL, 0);
+
+    int rv = writeBlock(hFile, pos);
+    if (rv != 0)
+    {
+        return -1;
+    }
+
+    DIAG_LogMsgArg(DIAG_DEBUG, MODULE_NAME, __func__, "interface %u: link type %d, snap length %u", mInterfaceCount, linkType, snapLength);
+    mInterfaceSnapLengths[mInterfaceCount] = snapLength;
+    *interfaceId = mInterfaceCount;
+    mInterfaceCount++;
+    return 0;
+}
+
+int PCNG_WriteEnhancedPacket(PipeHandleType hFile,
+                             uint32_t interfaceId,
+                             uint64_t timestamp,
+                             const void* packetData,
+                             uint32_t packetLength)
+{
+    if (interfaceId >= mInterfaceCount)
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "unknown interface %u!", interfaceId);
+        return -1;
+    }
+    /* truncate the packet if it exceeds the snap length */
+    uint32_t capturedLength = (packetLength > mInterfaceSnapLengths[interfaceId])
+                                ? mInterfaceSnapLengths[interfaceId] : packetLength;
+
+    size_t pos = beginBlock(BLOCK_TYPE_EPB);
+    pos = putU32(pos, interfaceId);
+    pos = putTimestamp(pos, timestamp);
+    pos = putU32(pos, capturedLength);
+    pos = putU32(pos, packetLength);
+    memcpy(&mBlockBuffer[pos], packetData, capturedLength);
+    memset(&mBlockBuffer[pos + capturedLength], 0, PAD32(capturedLength) - capturedLength);
+    pos += PAD32(capturedLength);
+    return writeBlock(hFile, pos);
+}
+
+int PCNG_WriteInterfaceStatistics(PipeHandleType hFile,
+                                  uint32_t interfaceId,
+                                  uint64_t timestamp,
+                                  uint64_t packetsReceived,
+                                  uint64_t packetsDropped,
+                                  const char* comment)
+{
+    if (interfaceId >= mInterfaceCount)
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "unknown interface %u!", interfaceId);
+        return -1;
+    }
+
+    size_t pos = beginBlock(BLOCK_TYPE_ISB);
+    pos = putU32(pos, interfaceId);
+    pos = putTimestamp(pos, timestamp);
+    pos = putOption(pos, OPT_ISB_IFRECV, &packetsReceived, sizeof(packetsReceived));
+    pos = putOption(pos, OPT_ISB_IFDROP, &packetsDropped, sizeof(packetsDropped));
+    if (comment != NULL)
+    {
+        pos = putOption(pos, OPT_COMMENT, comment, (uint16_t)strnlen(comment, MAX_COMMENT_LENGTH));
+    }
+    pos = putOption(pos, OPT_ENDOFOPT, NULL, 0);
+    return writeBlock(hFile, pos);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
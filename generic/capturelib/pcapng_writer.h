@@ -0,0 +1,176 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \brief Writer for the pcapng file format.
+ *
+ * A pcapng stream starts with a section header block, followed by one
+ * interface description block per captured interface. Every packet refers to
+ * its interface by the interface id, i.e. the index of the interface
+ * description block within the section. The timestamps are 64 bit values in
+ * the resolution given to the interface description block.
+ *
+ * All blocks are built within a single preallocated buffer and passed to the
+ * write buffer of the pcap writer, see PCAP_WriteBuffered(). Thus the blocks
+ * are subject to the flush latency of the pcap writer as well.
+ *
+ * \see https://www.ietf.org/archive/id/draft-ietf-opsawg-pcapng-02.html
+ */
+/* ************************************************************************* */
+
+#ifndef PCAPNG_WRITER_H_INCLUDED
+#define PCAPNG_WRITER_H_INCLUDED
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stddef.h>
+#include <stdint.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "pcap_writer.h"
+#include "pipehandling.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+/** maximum number of interfaces within a section */
+#define PCNG_MAX_INTERFACES         (16)
+/** maximum snap length of an interface */
+#define PCNG_MAX_SNAP_LENGTH        (65535)
+
+/** value of the if_tsresol option for microsecond timestamps */
+#define PCNG_TSRESOL_MICROS         (6)
+/** value of the if_tsresol option for nanosecond timestamps */
+#define PCNG_TSRESOL_NANOS          (9)
+
+/* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E C L A R A T I O N S * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
+
+/* G L O B A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * */
+/** Writes a section header block, which starts a new section. All interfaces
+ * of a previous section are forgotten.
+ *
+ * \param hFile Handle to the file to write the block to
+ *
+ * \returns 0: if the block has been written successfully.
+ * \returns -1: if the function failed.
+ */
+int PCNG_WriteSectionHeader    (      PipeHandleType               hFile);
+
+/** Writes an interface description block.
+ *
+ * \param hFile Handle to the file to write the block to
+ * \param linkType The link type of the packets captured on the interface
+ * \param snapLength The maximum number of bytes stored per packet, must not
+ *                   exceed PCNG_MAX_SNAP_LENGTH
+ * \param tsresol The timestamp resolution as power of 10, e.g.
+ *                PCNG_TSRESOL_NANOS
+ * \param name The name of the interface stored in the if_name option, may be
+ *             NULL
+ * \param interfaceId Receives the id to be used for the packets of this
+ *                    interface
+ *
+ * \returns 0: if the block has been written successfully.
+ * \returns -1: if the function failed.
+ */
+int PCNG_WriteInterfaceDescription(   PipeHandleType               hFile,
+                                      PCAP_ValidLinkTypesType      linkType,
+                                      uint32_t                     snapLength,
+                                      uint8_t                      tsresol,
+                                const char*                        name,
+                                      uint32_t*                    interfaceId);
+
+/** Writes an enhanced packet block. The packet is truncated to the snap length
+ * of the interface.
+ *
+ * \param hFile Handle to the file to write the block to
+ * \param interfaceId The interface the packet was captured on
+ * \param timestamp The timestamp in the resolution of the interface
+ * \param packetData The captured packet
+ * \param packetLength The number of bytes in packetData
+ *
+ * \returns 0: if the block has been written successfully.
+ * \returns -1: if the function failed.
+ */
+int PCNG_WriteEnhancedPacket   (      PipeHandleType               hFile,
+                                      uint32_t                     interfaceId,
+                                      uint64_t                     timestamp,
+                                const void*                        packetData,
+                                      uint32_t                     packetLength);
+
+/** Writes an interface statistics block with the isb_ifrecv and isb_ifdrop
+ * options.
+ *
+ * \param hFile Handle to the file to write the block to
+ * \param interfaceId The interface the statistics belong to
+ * \param timestamp The time the statistics were taken in the resolution of
+ *                  the interface
+ * \param packetsReceived The number of packets received on the interface
+ * \param packetsDropped The number of packets which could not be processed
+ * \param comment A comment stored in the opt_comment option, may be NULL
+ *
+ * \returns 0: if the block has been written successfully.
+ * \returns -1: if the function failed.
+ */
+int PCNG_WriteInterfaceStatistics(   PipeHandleType               hFile,
+                                      uint32_t                     interfaceId,
+                                      uint64_t                     timestamp,
+                                      uint64_t                     packetsReceived,
+                                      uint64_t                     packetsDropped,
+                                const char*                        comment);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#endif // PCAPNG_WRITER_H_INCLUDED
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
@@ -0,0 +1,144 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup timestampunwrapper
+ * \brief Extends the 32 bit microsecond timestamps of a CAPTURino device to
+ *        64 bit.
+ *
+ * The timestamps of the device wrap every 2^32 us, i.e. about 71.6 minutes.
+ * Comparing a timestamp only to the previous one misses every wrap during a
+ * period without frames. Instead, the host time elapsed since the previous
+ * timestamp predicts the extended timestamp, and the device timestamp is
+ * placed at the value with the same lower 32 bits which is closest to this
+ * prediction. This is correct as long as the prediction is off by less than
+ * half of the wrap period, e.g. due to data queued in the host.
+ *
+ * @{
+ */
+/* ************************************************************************* */
+
+#ifndef TIMESTAMPUNWRAPPER_H_INCLUDED
+#define TIMESTAMPUNWRAPPER_H_INCLUDED
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdint.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+
+/* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * */
+typedef struct
+{
+    uint64_t extendedMicros;    /**< previous timestamp, extended to 64 bit */
+    uint32_t hostMillis;        /**< monotonic host time at which the previous
+                                     timestamp was received */
+} TSUW_UnwrapperType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E C L A R A T I O N S * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * */
+/** Initializes an unwrapper with a timestamp of the device, e.g. the one of
+ * the time synchronization. Its extended value equals the device timestamp.
+ *
+ * \param[out] unwrapper the unwrapper to be initialized.
+ * \param[in] deviceMicros timestamp of the device.
+ * \param[in] hostMillis monotonic host time at which deviceMicros was
+ *                       received, e.g. by SYSU_GetCurrentMillis(). May wrap.
+ */
+void TSUW_Init(TSUW_UnwrapperType* unwrapper,
+               uint32_t            deviceMicros,
+               uint32_t            hostMillis);
+
+/* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
+/** Extends a timestamp of the device to 64 bit. The timestamps must be passed
+ * in the order they have been received.
+ *
+ * \param[in] unwrapper the unwrapper.
+ * \param[in] deviceMicros timestamp of the device.
+ * \param[in] hostMillis monotonic host time at which deviceMicros was
+ *                       received.
+ *
+ * \returns the extended timestamp.
+ */
+static inline uint64_t TSUW_Unwrap(TSUW_UnwrapperType* unwrapper,
+                                   uint32_t            deviceMicros,
+                                   uint32_t            hostMillis)
+{
+    uint64_t elapsedMicros = (uint64_t)(uint32_t)(hostMillis - unwrapper->hostMillis) * 1000ULL;
+    uint64_t predictedMicros = unwrapper->extendedMicros + elapsedMicros;
+    /* the difference in the lower 32 bits, taken as signed value, is the
+       distance to the closest matching value */
+    int32_t deviationMicros = (int32_t)(deviceMicros - (uint32_t)predictedMicros);
+    unwrapper->extendedMicros = predictedMicros + (uint64_t)(int64_t)deviationMicros;
+    unwrapper->hostMillis = hostMillis;
+    return unwrapper->extendedMicros;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMESTAMPUNWRAPPER_H_INCLUDED */
+
+/**
+ * @}
+ */
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
@@ -38,9 +38,12 @@
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
 #include "argparser.h"
 #include "capturinoconn.h"
+#include "capturinomerger.h"
 #include "console.h"
+#include "devicecache.h"
 #include "diagnosis.h"
 #include "genericutils.h"
+#include "pcap_writer.h"
 #include "pipehandling.h"
 #include "serialhandling.h"
 #include "systemutils.h"
@@ -104,10 +107,20 @@ const Dlt2StringType mDlt2StringMapping[CAPTURino_KNOWN_DLTS_COUNT] =
     }
 };
 
+/** USB IDs of the CAPTURino boards. The ports of other USB devices are only
+ * listed if no CAPTURino board is connected. */
+const CapturinoUsbIdType mKnownUsbIds[CAPTURino_KNOWN_USB_IDS_COUNT] =
+{
+    {
+        /* Arduino SA */
+        .vendorId = 0x2341,
+        .productId = CAPTURino_ANY_PRODUCT_ID
+    }
+};
+
 /* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
 static volatile bool mTerminateFlag = false;
-static unsigned long long mCapturinoBaseUnixTime = 0;
-static unsigned long mCapturinoBaseMicros = 0;
+static DVCC_CacheType mDeviceCache;
 
 /* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
 static const char* MODULE_NAME = "CAPT_COMM";
@@ -119,28 +132,75 @@ static const char* MODULE_NAME = "CAPT_COMM";
 /* L O C A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * * */
 static int capturinoExtcapConfig_addPortList(int argc, char *argv[], int configArgNo);
 
+static int capturinoExtcapConfig_probePortList(int argc, char *argv[], int configArgNo);
+
 static int capturinoExtcapConfig_reloadInterfaceList(int argc, char *argv[], int configArgNo);
 
-static int capturinoExtcapConfig_printUpdatedInterfaceDescription(int configArgNo);
+static int capturinoExtcapConfig_queryBoardInfo(CCON_SessionType* session,
+                                                uint32_t* boardId,
+                                                uint32_t* dlts,
+                                                size_t maxDltsCount,
+                                                size_t* dltsCount);
+
+static void capturinoExtcapConfig_printInterfaceDescription(uint32_t boardId,
+                                                            const uint32_t* dlts,
+                                                            size_t dltsCount,
+                                                            int configArgNo);
+
+static int capturinoExtcapConfig_getPortIdentity(const char* comPort,
+                                                 DVCC_IdentityType* identity);
 
 /* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
 
 /* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static bool capturinoExtcapConfig_isKnownUsbId(const SERH_PortInfoType* port)
+{
+    for (size_t i=0; i<CAPTURino_KNOWN_USB_IDS_COUNT; i++)
+    {
+        if ((port->vendorId == mKnownUsbIds[i].vendorId)
+         && ((mKnownUsbIds[i].productId == CAPTURino_ANY_PRODUCT_ID)
+          || (port->productId == mKnownUsbIds[i].productId)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 static int capturinoExtcapConfig_addPortList(int argc, char *argv[], int configArgNo)
 {
-    char comPortBuf[128];
-    char* comPorts[15];
-    size_t comPortsFound = 0;
+    SERH_PortInfoType ports[SERH_MAX_PORTS];
+    size_t portsFound = 0;
 
-    int rvGetPortList = SERH_GetPortList(comPortBuf, 128, comPorts, 15, &comPortsFound);
+    int rvGetPortList = SERH_GetPortInfoList(ports, SERH_MAX_PORTS, &portsFound);
     if (rvGetPortList == 0)
     {
+        bool knownUsbIdFound = false;
+        for (size_t i=0; i<portsFound; i++)
+        {
+            knownUsbIdFound |= capturinoExtcapConfig_isKnownUsbId(&ports[i]);
+        }
+
         CNSL_WriteArgLn("value {arg=%d}{value=X}{display= }", configArgNo);
-        for (size_t i=0; i<comPortsFound; i++)
+        for (size_t i=0; i<portsFound; i++)
         {
-            CNSL_WriteArgLn("value {arg=%d}{value=%s}{display=%s}{default=false}",
-                            configArgNo, comPorts[i],
-                            comPorts[i]);
+            if ((knownUsbIdFound == true) && (capturinoExtcapConfig_isKnownUsbId(&ports[i]) == false))
+            {
+                continue;
+            }
+            if (ports[i].vendorId != 0)
+            {
+                CNSL_WriteArgLn("value {arg=%d}{value=%s}{display=%s (%04X:%04X %s)}{default=false}",
+                                configArgNo, ports[i].path,
+                                ports[i].nodePath, ports[i].vendorId, ports[i].productId,
+                                (ports[i].serialNumber[0] != '\0') ? ports[i].serialNumber : ports[i].driver);
+            }
+            else
+            {
+                CNSL_WriteArgLn("value {arg=%d}{value=%s}{display=%s}{default=false}",
+                                configArgNo, ports[i].path,
+                                ports[i].path);
+            }
         }
     }
     else
@@ -151,6 +211,72 @@ static int capturinoExtcapConfig_addPortList(int argc, char *argv[], int configA
     return 0;
 }
 
+/** Lists only the ports a CAPTURino device responds at, together with its
+ * physical layer. All ports are probed at once within a single timeout. */
+static int capturinoExtcapConfig_probePortList(int argc, char *argv[], int configArgNo)
+{
+    char comPortBuf[CCON_MAX_PROBED_SESSIONS * SERH_MAX_PORT_PATH_LENGTH];
+    char* comPorts[CCON_MAX_PROBED_SESSIONS];
+    size_t comPortsFound = 0;
+    if (SERH_GetPortList(comPortBuf, sizeof(comPortBuf), comPorts, CCON_MAX_PROBED_SESSIONS, &comPortsFound) != 0)
+    {
+        DIAG_LogMsg(DIAG_WARNING, MODULE_NAME, __func__, "unable to retrieve COM port list!");
+        return 0;
+    }
+
+    long baudrate;
+    if (ARGP_getLongOfArgs(argc, argv, "--baudrate", &baudrate) != 0)
+    {
+        baudrate = CAPTURino_DEFAULT_BAUDRATE;
+    }
+
+    CCON_SessionType sessions[CCON_MAX_PROBED_SESSIONS];
+    const char* sessionPorts[CCON_MAX_PROBED_SESSIONS];
+    uint32_t boardIds[CCON_MAX_PROBED_SESSIONS];
+    bool responded[CCON_MAX_PROBED_SESSIONS];
+    size_t sessionCount = 0;
+    for (size_t i=0; i<comPortsFound; i++)
+    {
+        sessions[sessionCount] = (CCON_SessionType)CCON_SESSION_INITIALIZER;
+        if (CCON_Open(&sessions[sessionCount], comPorts[i], baudrate) == 0)
+        {
+            sessionPorts[sessionCount] = comPorts[i];
+            sessionCount++;
+        }
+    }
+
+    CNSL_WriteArgLn("value {arg=%d}{value=X}{display= }", configArgNo);
+    if (CCON_ProbeBoardIds(sessions, sessionCount, CAPTURino_PROBE_TIMEOUT_MS, &mTerminateFlag, boardIds, responded) == 0)
+    {
+        for (size_t i=0; i<sessionCount; i++)
+        {
+            if (responded[i] == false)
+            {
+                continue;
+            }
+            const char* phyName = "unknown physical layer";
+            for (size_t j = 0; j < sizeof(mId2PhyNameMapping) / sizeof(CapturinoId2PhyNameType); j++)
+            {
+                if (mId2PhyNameMapping[j].boardId == boardIds[i])
+                {
+                    phyName = mId2PhyNameMapping[j].physicalLayerName;
+                    break;
+                }
+            }
+            DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "CAPTURino device with board id 0x%08X found at \'%s\'", boardIds[i], sessionPorts[i]);
+            CNSL_WriteArgLn("value {arg=%d}{value=%s}{display=%s - %s (0x%08X)}{default=false}",
+                            configArgNo, sessionPorts[i],
+                            sessionPorts[i], phyName, boardIds[i]);
+        }
+    }
+
+    for (size_t i=0; i<sessionCount; i++)
+    {
+        CCON_Close(&sessions[i]);
+    }
+    return 0;
+}
+
 static int capturinoExtcapConfig_reloadInterfaceList(int argc, char *argv[], int configArgNo)
 {
     int rv;
@@ -175,8 +301,30 @@ static int capturinoExtcapConfig_reloadInterfaceList(int argc, char *argv[], int
         return 0;
     }
     
+    /* Wireshark calls the plugin for every reload, answer from the cache as
+       long as the same device is connected */
+    DVCC_IdentityType identity;
+    char cachePath[512];
+    unsigned long long nowUnixTime;
+    unsigned long nowMicros;
+    SYSU_GetCurrentTime(&nowUnixTime, &nowMicros);
+    bool useCache = (capturinoExtcapConfig_getPortIdentity(comPort, &identity) == 0)
+                 && (SYSU_GetCacheFilePath(DVCC_FILE_NAME, cachePath, sizeof(cachePath)) == 0);
+    if (useCache == true)
+    {
+        DVCC_Load(&mDeviceCache, cachePath);
+        const DVCC_EntryType* entry = DVCC_Lookup(&mDeviceCache, &identity, nowUnixTime, DVCC_DEFAULT_TTL_SECONDS);
+        if (entry != NULL)
+        {
+            DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "using the cached linktypes of the device at '%s'", comPort);
+            capturinoExtcapConfig_printInterfaceDescription(entry->boardId, entry->dlts, entry->dltsCount, configArgNo);
+            return 0;
+        }
+    }
+
     DIAG_LogMsg(DIAG_INFO, MODULE_NAME, __func__, "open serial port to get supported linktypes");
-    rv = CCON_Open(comPort, baudrate);
+    CCON_SessionType session = CCON_SESSION_INITIALIZER;
+    rv = CCON_Open(&session, comPort, baudrate);
     if (rv != 0)
     {
         /* if no capture interface was found change the default selector text */
@@ -186,33 +334,59 @@ static int capturinoExtcapConfig_reloadInterfaceList(int argc, char *argv[], int
         return 0;
     }
 
-    capturinoExtcapConfig_printUpdatedInterfaceDescription(configArgNo);
+    DVCC_EntryType entry;
+    rv = capturinoExtcapConfig_queryBoardInfo(&session, &entry.boardId, entry.dlts, DVCC_MAX_DLTS, &entry.dltsCount);
 
     DIAG_LogMsg(DIAG_INFO, MODULE_NAME, __func__, "closing serial port");
-    CCON_Close();
+    CCON_Close(&session);
+
+    if (rv == 0)
+    {
+        capturinoExtcapConfig_printInterfaceDescription(entry.boardId, entry.dlts, entry.dltsCount, configArgNo);
+        if (useCache == true)
+        {
+            entry.identity = identity;
+            entry.validatedUnixTime = nowUnixTime;
+            if ((DVCC_Store(&mDeviceCache, &entry) != 0)
+             || (DVCC_Save(&mDeviceCache, cachePath) != 0))
+            {
+                DIAG_LogMsgArg(DIAG_WARNING, MODULE_NAME, __func__, "unable to cache the linktypes of the device at '%s'", comPort);
+            }
+        }
+    }
 
     return 0;
 }
 
-static int capturinoExtcapConfig_printUpdatedInterfaceDescription(int configArgNo)
+static int capturinoExtcapConfig_queryBoardInfo(CCON_SessionType* session,
+                                                uint32_t* boardId,
+                                                uint32_t* dlts,
+                                                size_t maxDltsCount,
+                                                size_t* dltsCount)
 {
     int rv;
 
-    rv = CCON_InitiateSession(200, &mTerminateFlag);
+    rv = CCON_InitiateSession(session, 200, &mTerminateFlag);
     if (rv != 0)
     {
         DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "failed to initiate a session with the CAPTURino device. Return value was %d", rv);
-        return 0;
+        return -1;
     }
 
-    uint32_t boardId;
-    rv = CCON_GetBoardId(500, &mTerminateFlag, &boardId);
+    rv = CCON_GetBoardInfo(session, 500, &mTerminateFlag, boardId, dlts, maxDltsCount, dltsCount);
     if (rv != 0)
     {
-        DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "failed to get the board id from the CAPTURino device. Return value was %d", rv);
-        return 0;
+        DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "failed to get the board id and the supported dlts from the CAPTURino device. Return value was %d", rv);
+        return -1;
     }
+    return 0;
+}
 
+static void capturinoExtcapConfig_printInterfaceDescription(uint32_t boardId,
+                                                            const uint32_t* dlts,
+                                                            size_t dltsCount,
+                                                            int configArgNo)
+{
     const char* phyName = "";
     DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "CAPTURino device returned board id 0x%08X", boardId);
     for (size_t i = 0; i < sizeof(mId2PhyNameMapping) / sizeof(CapturinoId2PhyNameType); i++)
@@ -224,14 +398,6 @@ static int capturinoExtcapConfig_printUpdatedInterfaceDescription(int configArgN
         }
     }
 
-    uint32_t dlts[8];
-    size_t dltsCount = 0;
-    rv = CCON_GetSupportedDlts(500, &mTerminateFlag, dlts, 8, &dltsCount);
-    if (rv != 0)
-    {
-        DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "failed to get the supported dlts from the CAPTURino device. Return value was %d", rv);
-        return 0;
-    }
     const char* dltString = "";
     for (size_t i = 0; i < dltsCount; i++)
     {
@@ -248,7 +414,23 @@ static int capturinoExtcapConfig_printUpdatedInterfaceDescription(int configArgN
                         phyName,
                         dltString);
     }
+}
 
+static int capturinoExtcapConfig_getPortIdentity(const char* comPort,
+                                                 DVCC_IdentityType* identity)
+{
+    SERH_PortIdentityType portIdentity;
+    if ((SERH_GetPortIdentity(comPort, &portIdentity) != 0)
+     || (strlen(comPort) >= DVCC_MAX_PORT_LENGTH)
+     || (strlen(portIdentity.serialNumber) >= DVCC_MAX_SERIAL_NUMBER_LENGTH))
+    {
+        return -1;
+    }
+    strcpy(identity->portPath, comPort);
+    strcpy(identity->serialNumber, portIdentity.serialNumber);
+    identity->deviceId = portIdentity.deviceId;
+    identity->nodeId = portIdentity.nodeId;
+    identity->changeTime = portIdentity.changeTime;
     return 0;
 }
 
@@ -273,6 +455,10 @@ int capturinoCommonExtcapConfig(int argc, char *argv[])
         {
             capturinoExtcapConfig_reloadInterfaceList(argc, argv, 4);
         }
+        else if (strcmp(reloadArg, "port") == 0)
+        {
+            capturinoExtcapConfig_probePortList(argc, argv, 0);
+        }
         else
         {
             DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "Unknown reload option \'%s\' found", reloadArg);
@@ -284,7 +470,7 @@ int capturinoCommonExtcapConfig(int argc, char *argv[])
 
         /* NOTE: the call="..." argument must only consist of lower case letters. Otherwise Wireshark
         *       will crash with error 0xc0000409 */
-        CNSL_WriteArgLn("arg {number=%d}{call=--port}{display=Serial port}{tooltip=Serial port for the communication}{type=editselector}{required=true}{group=Connection}", 0);
+        CNSL_WriteArgLn("arg {number=%d}{call=--port}{display=Serial port}{tooltip=Serial port for the communication}{type=editselector}{reload=true}{placeholder=Search CAPTURino devices}{required=true}{group=Connection}", 0);
         capturinoExtcapConfig_addPortList(argc, argv, 0);
         CNSL_WriteArgLn("arg {number=%d}{call=--logfile}{display=Logfile}{tooltip=Log file of the CAPTURino plugin}{type=fileselect}{mustexist=false}{group=Connection}", 1);
         CNSL_WriteArgLn("arg {number=%d}{call=--loglevel}{display=Loglevel}{tooltip=Severity limit of the messages to be captured}{type=selector}{default=2}{group=Connection}", 2);
@@ -294,7 +480,14 @@ int capturinoCommonExtcapConfig(int argc, char *argv[])
         CNSL_WriteArgLn("value {arg=%d}{value=3}{display=warning}", 2);
         CNSL_WriteArgLn("value {arg=%d}{value=4}{display=error}", 2);
 
-        CNSL_WriteArgLn("arg {number=%d}{call=--baudrate}{display=Baudrate}{tooltip=Baudrate for the serial communication}{type=string}{default=115200}{required=true}{group=Connection}", 3);
+        CNSL_WriteArgLn("arg {number=%d}{call=--baudrate}{display=Baudrate}{tooltip=Baudrate for the serial communication. Any baudrate supported by the USB serial converter can be entered}{type=editselector}{default=115200}{required=true}{group=Connection}", 3);
+        CNSL_WriteArgLn("value {arg=%d}{value=115200}{display=115200}{default=true}", 3);
+        CNSL_WriteArgLn("value {arg=%d}{value=230400}{display=230400}{default=false}", 3);
+        CNSL_WriteArgLn("value {arg=%d}{value=460800}{display=460800}{default=false}", 3);
+        CNSL_WriteArgLn("value {arg=%d}{value=921600}{display=921600}{default=false}", 3);
+        CNSL_WriteArgLn("value {arg=%d}{value=1000000}{display=1000000}{default=false}", 3);
+        CNSL_WriteArgLn("value {arg=%d}{value=2000000}{display=2000000}{default=false}", 3);
+        CNSL_WriteArgLn("value {arg=%d}{value=3000000}{display=3000000}{default=false}", 3);
         
         CNSL_WriteArgLn("arg {number=%d}{call=--dlts}{display=Capture interface}{tooltip=Click reload to search for available interfaces}{type=selector}{reload=true}{placeholder=Reload}{group=Connection}{required=true}", 4);
         CNSL_WriteArgLn("value {arg=%d}{value=-1}{display=No CAPTURino interface selected.}", 4);
@@ -324,6 +517,22 @@ int capturinoCommonExtcapConfig(int argc, char *argv[])
         CNSL_WriteArgLn("value {arg=%d}{value=2}{display=2 Stoppbits}", 10);
 
         CNSL_WriteArgLn("arg {number=%d}{call=--serialtimeout}{display=No new frame timeout (us)}{tooltip=Timeout to monitor if no more messages appear for a certain time}{type=string}{default=1750}{group=UART}{required=true}", 11);
+
+        CNSL_WriteArgLn("arg {number=%d}{call=--flushlatency}{display=Live view latency (ms)}{tooltip=Maximum time captured packets are held back to be written to Wireshark in bulk. 0 writes every packet immediately}{type=unsigned}{default=%d}{range=0,1000}{group=Capture}", 12, PCAP_DEFAULT_FLUSH_LATENCY_MS);
+        CNSL_WriteArgLn("arg {number=%d}{call=--format}{display=Output format}{tooltip=File format the captured packets are passed to Wireshark in}{type=selector}{group=Capture}", 13);
+        CNSL_WriteArgLn("value {arg=%d}{value=pcap}{display=pcap}{default=true}", 13);
+        CNSL_WriteArgLn("value {arg=%d}{value=pcapng}{display=pcapng (nanosecond timestamps, capture statistics)}{default=false}", 13);
+
+        CNSL_WriteArgLn("arg {number=%d}{call=--boards}{display=Boards}{tooltip=Captures several CAPTURino devices into one pcapng stream instead of the selected port. Comma separated list of port:dlt pairs, e.g. /dev/ttyACM0:227,/dev/ttyACM1:148}{type=string}{group=Multi-board}", 14);
+        CNSL_WriteArgLn("arg {number=%d}{call=--reorderwindow}{display=Reorder window (ms)}{tooltip=Maximum time a packet is held back to merge the packets of all devices in timestamp order}{type=unsigned}{default=%d}{range=0,10000}{group=Multi-board}", 15, CMRG_DEFAULT_REORDER_WINDOW_MS);
+        CNSL_WriteArgLn("arg {number=%d}{call=--linkprofile}{display=USB serial tuning}{tooltip=Tunes the USB serial converter, e.g. the latency timer of FTDI converters. The original settings are restored after the capture}{type=selector}{group=Connection}", 16);
+        CNSL_WriteArgLn("value {arg=%d}{value=latency}{display=latency (pass on received data immediately)}{default=true}", 16);
+        CNSL_WriteArgLn("value {arg=%d}{value=throughput}{display=throughput (collect received data to larger transfers)}{default=false}", 16);
+        CNSL_WriteArgLn("value {arg=%d}{value=default}{display=keep the settings of the driver}{default=false}", 16);
+        CNSL_WriteArgLn("arg {number=%d}{call=--flowcontrol}{display=Flow control}{tooltip=Flow control of the serial communication. RTS/CTS requires these lines to be connected to the CAPTURino device}{type=selector}{group=Connection}", 17);
+        CNSL_WriteArgLn("value {arg=%d}{value=none}{display=none}{default=true}", 17);
+        CNSL_WriteArgLn("value {arg=%d}{value=rtscts}{display=RTS/CTS}{default=false}", 17);
+        CNSL_WriteArgLn("arg {number=%d}{call=--maxbaudrate}{display=Maximum baudrate}{tooltip=Highest baudrate negotiated with the CAPTURino device, starting at the baudrate above. Any baudrate not above it disables the negotiation}{type=unsigned}{default=%d}{group=Connection}", 18, CAPTURino_DEFAULT_MAX_BAUDRATE);
     }
     return 0;
 }
@@ -632,53 +841,67 @@ int capturinoCommonGenerateCaptureCmd(uint32_t dlt,
     }
 }
 
-/** \warning microsOffset must not be > 1000000 */
-int capturinoCommonUpdateTimebase(unsigned long long secondsOffset,
-                                  unsigned long microsOffset)
+/** Samples the time of the device like an NTP client does. The host time is
+ * taken right before sending and after receiving every time request. The
+ * device took its timestamp somewhere within this round trip, thus the
+ * midpoint of the exchange with the shortest round trip is the best estimate
+ * and half of the round trip is the maximum error.
+ *
+ * \param[in] timeoutMS timeout of a single time request.
+ * \param[out] sync the estimated host time of the device timestamp.
+ */
+int capturinoCommonSyncTime(CCON_SessionType* session,
+                            unsigned long timeoutMS,
+                            volatile bool* terminateFlag,
+                            CapturinoTimeSyncType* sync)
 {
-    mCapturinoBaseUnixTime += secondsOffset;
-    mCapturinoBaseMicros += microsOffset;
-    if (mCapturinoBaseMicros > 1000000)
+    bool synced = false;
+    uint64_t minRoundTripMicros = 0;
+    for (unsigned int i=0; i<CAPTURino_TIME_SYNC_EXCHANGES; i++)
     {
-        mCapturinoBaseUnixTime++;
-        mCapturinoBaseMicros%1000000;
-    }
-
-    return 0;
-}
+        unsigned long long sendUnixTime;
+        unsigned long sendMicros;
+        unsigned long long rcvUnixTime;
+        unsigned long rcvMicros;
+        uint32_t capturinoMicros;
+
+        SYSU_GetCurrentTime(&sendUnixTime, &sendMicros);
+        int rv = CCON_GetBoardMicros(session, timeoutMS, terminateFlag, &capturinoMicros);
+        SYSU_GetCurrentTime(&rcvUnixTime, &rcvMicros);
+        if (rv != 0)
+        {
+            DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "time request %u failed! Return value=%d", i, rv);
+            return -1;
+        }
 
-int capturinoCommonSetTimebase(unsigned long long hostUnixTime,
-                               unsigned long hostMicros,
-                               unsigned long capturinoMicros)
-{
-    mCapturinoBaseUnixTime = hostUnixTime - (capturinoMicros / 1000000);
-    mCapturinoBaseMicros = hostMicros - (capturinoMicros % 1000000);
-    if (mCapturinoBaseMicros > hostMicros)
-    {
-        mCapturinoBaseUnixTime -= 1;
-        mCapturinoBaseMicros += 1000000;
-        DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "Timebase micros needed correction");
+        uint64_t sendTotalMicros = (uint64_t)sendUnixTime * 1000000ULL + sendMicros;
+        uint64_t rcvTotalMicros = (uint64_t)rcvUnixTime * 1000000ULL + rcvMicros;
+        if (rcvTotalMicros < sendTotalMicros)
+        {
+            /* the host clock has been set back in between */
+            continue;
+        }
+        uint64_t roundTripMicros = rcvTotalMicros - sendTotalMicros;
+        DIAG_LogMsgArg(DIAG_DEBUG, MODULE_NAME, __func__, "time request %u: round trip %llu us", i, (unsigned long long)roundTripMicros);
+        if ((synced == false) || (roundTripMicros < minRoundTripMicros))
+        {
+            uint64_t midpointMicros = sendTotalMicros + roundTripMicros/2;
+            sync->hostUnixTime = (unsigned long long)(midpointMicros / 1000000ULL);
+            sync->hostMicros = (unsigned long)(midpointMicros % 1000000ULL);
+            sync->capturinoMicros = capturinoMicros;
+            /* round up, so the bound holds for odd round trips */
+            sync->errorBoundMicros = (unsigned long)((roundTripMicros + 1) / 2);
+            minRoundTripMicros = roundTripMicros;
+            synced = true;
+        }
     }
-    DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "Timebase is %llu seconds, %lu micros", mCapturinoBaseUnixTime, mCapturinoBaseMicros);
-    return 0;
-}
-
-int capturinoCommonGetTimestamp(unsigned long capturinoMicros,
-                                unsigned long long* unixSeconds,
-                                unsigned long*      unixMicros)
-{
-    /** \todo how shall a overflow of the micros counter be handeled? Right now,
-     *        the timestamp wraps back to the base time after ~71 minutes */
-    *unixSeconds = mCapturinoBaseUnixTime + (unsigned long long)(capturinoMicros / 1000000);
-    *unixMicros = mCapturinoBaseMicros + (capturinoMicros % 1000000);
-    if (*unixMicros >= 1000000)
+    if (synced == false)
     {
-        *unixSeconds += 1;
-        *unixMicros -= 1000000;
-        DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "Timestamp micros needed correction");
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "no valid time request, the host clock was changed during the synchronization!");
+        return -1;
     }
-    DIAG_LogMsgArg(DIAG_VERBOSE, MODULE_NAME, __func__, "Timestamp was %lu micros => seconds = %llu, micros = %lu", capturinoMicros, *unixSeconds, *unixMicros);
-
+    DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "device time %lu us synchronized to %llu s %lu us, error bound %lu us",
+                   (unsigned long)sync->capturinoMicros, sync->hostUnixTime, sync->hostMicros, sync->errorBoundMicros);
     return 0;
 }
 
@@ -32,9 +32,11 @@
  *************************************************************************** */
 
 /* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdbool.h>
 #include <stdint.h>
 
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "capturinoconn.h"
 
 /* ***************************************************************************
  * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
@@ -43,6 +45,19 @@
 /* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
 #define CAPTURino_KNOWN_IDS_COUNT 2
 #define CAPTURino_KNOWN_DLTS_COUNT 2
+#define CAPTURino_KNOWN_USB_IDS_COUNT 1
+/** matches every product of a vendor in CapturinoUsbIdType */
+#define CAPTURino_ANY_PRODUCT_ID 0
+/** number of time requests sent by capturinoCommonSyncTime() */
+#define CAPTURino_TIME_SYNC_EXCHANGES 8
+/** baudrate used to probe the serial ports if none is configured */
+#define CAPTURino_DEFAULT_BAUDRATE 115200
+/** time all serial ports are probed within */
+#define CAPTURino_PROBE_TIMEOUT_MS 200
+/** highest baudrate negotiated if none is configured */
+#define CAPTURino_DEFAULT_MAX_BAUDRATE 3000000
+/** timeout of each step of the baudrate negotiation */
+#define CAPTURino_NEGOTIATION_TIMEOUT_MS 200
 
 /* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
 
@@ -57,12 +72,28 @@ typedef struct
     const char* physicalLayerName;
 } CapturinoId2PhyNameType;
 
+typedef struct
+{
+    unsigned short vendorId;
+    unsigned short productId;
+} CapturinoUsbIdType;
+
 typedef struct 
 {
     uint32_t dlt;
     const char* dltString;
 } Dlt2StringType;
 
+/** Host time at which the device reported capturinoMicros */
+typedef struct
+{
+    unsigned long long hostUnixTime;
+    unsigned long      hostMicros;
+    uint32_t           capturinoMicros;
+    unsigned long      errorBoundMicros;    /**< maximum deviation of the
+                                                 host time */
+} CapturinoTimeSyncType;
+
 /* ***************************************************************************
  * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
  *************************************************************************** */
@@ -70,6 +101,7 @@ typedef struct
 /* G L O B A L   C O N S T A N T   D E C L A R A T I O N S * * * * * * * * * */
 extern const CapturinoId2PhyNameType mId2PhyNameMapping[CAPTURino_KNOWN_IDS_COUNT];
 extern const Dlt2StringType mDlt2StringMapping[CAPTURino_KNOWN_DLTS_COUNT];
+extern const CapturinoUsbIdType mKnownUsbIds[CAPTURino_KNOWN_USB_IDS_COUNT];
 /* G L O B A L   V A R I A B L E   D E C L A R A T I O N S * * * * * * * * * */
 
 /* ***************************************************************************
@@ -93,16 +125,10 @@ int capturinoCommonGenerateCaptureCmd(uint32_t dlt,
                                       size_t maxCmdLen,
                                       size_t* cmdLen);
 
-int capturinoCommonSetTimebase(unsigned long long hostUnixTime,
-                               unsigned long hostMicros,
-                               unsigned long capturinoMicros);
-
-int capturinoCommonUpdateTimebase(unsigned long long secondsOffset,
-                                  unsigned long microsOffset);
-
-int capturinoCommonGetTimestamp(unsigned long capturinoMicros,
-                                unsigned long long* unixSeconds,
-                                unsigned long*      unixMicros);
+int capturinoCommonSyncTime(CCON_SessionType* session,
+                            unsigned long timeoutMS,
+                            volatile bool* terminateFlag,
+                            CapturinoTimeSyncType* sync);
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 #endif // CAPTURINO_COMMON_INTFC_FUNCS_H_INCLUDED
@@ -42,10 +42,12 @@
 /* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
 #include <string.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
 #include "diagnosis.h"
+#include "eventloop.h"
 #include "genericutils.h"
 #include "serialhandling.h"
 #include "systemutils.h"
@@ -58,7 +60,13 @@
  *************************************************************************** */
 
 /* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
-#define RCV_BUFFER_LENGTH       (256)
+#define PROMPT                  "CAPTURino>"
+#define PROMPT_LEN              STATIC_STRLEN(PROMPT)
+/** the response to "dlts" lists a line per supported link type */
+#define DLTS_RESPONSE_LENGTH    (256)
+/** the response to "bauds" lists a line per supported baudrate */
+#define BAUDS_RESPONSE_LENGTH   (256)
+
 /* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
 
 /* ***************************************************************************
@@ -79,8 +87,6 @@
 static const char MODULE_NAME[] = "CCON";
 
 /* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
-SerialHandleType mSerialHandle = 0;
-static char mRcvBuffer[RCV_BUFFER_LENGTH];
 
 /* ***************************************************************************
  * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
@@ -89,222 +95,546 @@ static char mRcvBuffer[RCV_BUFFER_LENGTH];
 /* L O C A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * * */
 
 /* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
+static inline void initCommand(CCON_CommandType* command,
+                               const char* cmd,
+                               size_t cmdLen,
+                               char* responseBuf,
+                               size_t responseBufLen)
+{
+    command->cmd = cmd;
+    command->cmdLen = cmdLen;
+    command->terminateSequence = PROMPT;
+    command->terminateSequenceLen = PROMPT_LEN;
+    command->responseBuf = responseBuf;
+    command->responseBufLen = responseBufLen;
+    command->responseLen = 0;
+    command->result = CCON_PENDING;
+}
+
+/** The device echoes the command without its newline character. */
+static inline size_t echoLengthOf(const CCON_CommandType* command)
+{
+    return (command->cmdLen > 0) ? (command->cmdLen - 1) : 0;
+}
+
+static inline CCON_CommandType* oldestCommandOf(CCON_SessionType* session)
+{
+    return session->queue[session->queueHead];
+}
 
 /* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
-/**
- * Checks for an upcounting rollover timer if a certain timeout has been
- * reached.
- */
-static bool isTimeoutReached(uint32_t timeoutStartPoint,
-                             uint32_t timeoutReachedPoint,
-                             uint32_t currentMillis)
+/** Advances the number of matched characters of a sequence by a received
+ * character. On a mismatch, the longest prefix of the sequence which is a
+ * suffix of the received characters stays matched. */
+static size_t advanceMatch(const char* sequence,
+                           size_t matched,
+                           char c)
 {
-    if (timeoutReachedPoint < timeoutStartPoint)
+    if (sequence[matched] == c)
+    {
+        return matched + 1;
+    }
+    for (size_t k=matched; k>0; k--)
     {
-        /* timeout occurs after counter overflow */
-        if ((currentMillis > timeoutReachedPoint) && (currentMillis < timeoutStartPoint))
+        /* the candidate prefix of length k ends with c, the characters before
+           it are the last k-1 ones matched so far */
+        if ((sequence[k-1] == c)
+         && (strncmp(sequence, sequence+matched-(k-1), k-1) == 0))
         {
-            DIAG_LogMsg(DIAG_INFO, MODULE_NAME, __func__, "timeout reached after counter overflow");
-            return true;
+            return k;
         }
-        else 
+    }
+    return 0;
+}
+
+/** Removes the oldest command from the queue and sets its result. */
+static void completeOldestCommand(CCON_SessionType* session,
+                                  int result)
+{
+    CCON_CommandType* command = oldestCommandOf(session);
+    if (command->responseBuf != NULL)
+    {
+        command->responseBuf[command->responseLen] = '\0';
+    }
+    if ((result == 0) && (session->overflow == true))
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "response to command \'%.*s\' exceeds the buffer of %lu bytes", (int)echoLengthOf(command), command->cmd, (unsigned long)command->responseBufLen);
+        result = -1;
+    }
+    command->result = result;
+    session->queueHead = (session->queueHead + 1) % CCON_MAX_QUEUED_COMMANDS;
+    session->queueCount--;
+    session->echoPos = 0;
+    session->terminatePos = 0;
+    session->overflow = false;
+}
+
+/** Completes all queued commands with the given result. The characters
+ * still to be received for them are discarded on the next submit. */
+static void abortQueue(CCON_SessionType* session,
+                       int result)
+{
+    while (session->queueCount > 0)
+    {
+        completeOldestCommand(session, result);
+    }
+}
+
+/** Completes the oldest commands as long as they wait for no more
+ * characters, e.g. "\x03" which is not echoed. */
+static void completeFinishedCommands(CCON_SessionType* session)
+{
+    while (session->queueCount > 0)
+    {
+        const CCON_CommandType* command = oldestCommandOf(session);
+        if ((session->echoPos < echoLengthOf(command))
+         || (command->terminateSequence != NULL))
         {
-            return false;
+            return;
         }
+        completeOldestCommand(session, 0);
     }
-    else
+}
+
+/** Gets the number of characters which belong to the oldest command for
+ * sure. Reading no more than that leaves the characters following the
+ * response, e.g. the acknowledgement of the capture command, in the serial
+ * port for CCON_Read(). */
+static size_t pendingLengthOf(const CCON_SessionType* session)
+{
+    const CCON_CommandType* command = session->queue[session->queueHead];
+    size_t echoLen = echoLengthOf(command);
+    size_t terminateLen = (command->terminateSequence != NULL) ? command->terminateSequenceLen : 0;
+    if (session->echoPos < echoLen)
     {
-        /* timeout occurs before counter overflow */
-        if ((currentMillis > timeoutReachedPoint) || (currentMillis < timeoutStartPoint))
+        return (echoLen - session->echoPos) + terminateLen;
+    }
+    return terminateLen - session->terminatePos;
+}
+
+/** Parses a received character as part of the echo or the response of the
+ * oldest command. */
+static void parseChar(CCON_SessionType* session,
+                      char c)
+{
+    CCON_CommandType* command = oldestCommandOf(session);
+    if (session->echoPos < echoLengthOf(command))
+    {
+        if (c != command->cmd[session->echoPos])
         {
-            DIAG_LogMsg(DIAG_INFO, MODULE_NAME, __func__, "timeout reached before counter overflow");
-            return true;
+            DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "echo of command \'%.*s\' does not match", (int)echoLengthOf(command), command->cmd);
+            abortQueue(session, -1);
+            return;
+        }
+        session->echoPos++;
+        return;
+    }
+
+    if (command->responseBuf != NULL)
+    {
+        if (command->responseLen < command->responseBufLen - 1)
+        {
+            command->responseBuf[command->responseLen] = c;
+            command->responseLen++;
         }
         else
         {
-            return false;
+            session->overflow = true;
         }
     }
+    session->terminatePos = advanceMatch(command->terminateSequence, session->terminatePos, c);
+    if (session->terminatePos == command->terminateSequenceLen)
+    {
+        completeOldestCommand(session, 0);
+    }
+}
+
+/** Reads and parses the characters available at the serial port.
+ *
+ * \returns the number of characters read, or -1 on an error.
+ */
+static int processAvailable(CCON_SessionType* session)
+{
+    char rcvBuffer[64];
+    size_t bytesReceived = 0;
+    size_t maxLength = pendingLengthOf(session);
+    if (SERH_Read(session->serialHandle,
+                  rcvBuffer,
+                  (maxLength < sizeof(rcvBuffer)) ? maxLength : sizeof(rcvBuffer),
+                  &bytesReceived) != 0)
+    {
+        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "reading from serial port failed!");
+        return -1;
+    }
+    for (size_t i=0; (i<bytesReceived) && (session->queueCount > 0); i++)
+    {
+        parseChar(session, rcvBuffer[i]);
+        completeFinishedCommands(session);
+    }
+    return (int)bytesReceived;
 }
 
-static int wait4Response(unsigned long timeoutMS,
-                         volatile bool* terminateFlag,
-                         char* responseBuf,
-                         size_t* responseLen,
-                         size_t responseBufLen,
-                         const char* terminateSequence,
-                         size_t terminateSequenceLen)
+/** Parses the board ID from the response to "idfcn". */
+static int parseBoardId(const CCON_CommandType* command,
+                        uint32_t* boardId)
 {
-    unsigned long timeoutStartPoint;
-    SYSU_GetCurrentMillis(&timeoutStartPoint);
+    const char* response = command->responseBuf;
+    size_t responseLen = command->responseLen;
+    if ((command->result != 0) || (responseLen < 2 + 8))
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "error waiting for CAPTURino response to command \'idfcn\'! rv=%d, received bytes=%d", command->result, responseLen);
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "error waiting for CAPTURino response to command \'idfcn\'! Received %u chars: \'%.*s\'", responseLen, responseLen, response);
+        return -1;
+    }
 
-    size_t totalBytesReceived = 0;
-    while (*terminateFlag == false)
+    char* endptr = NULL;
+    *boardId = strtoul(response+2, &endptr, 16);
+    /* it is expected that the command returns eight digits, hence the
+    endptr must match the response+2+8 address */
+    if (endptr != response+2+8)
     {
-        unsigned long currentMillis;
-        SYSU_GetCurrentMillis(&currentMillis);
-        if (isTimeoutReached(timeoutStartPoint,
-                             timeoutStartPoint + timeoutMS,
-                             currentMillis))
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "error parsing board id from CAPTURino response! endptr=%p, expected=%p", endptr, response+2+8);
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "error parsing board id from CAPTURino response! Received %u chars: \'%.*s\'", responseLen, responseLen, response);
+        return -1;
+    }
+    return 0;
+}
+
+/** Parses a response listing a decimal number per line, e.g. the supported
+ * link types in response to "dlts". */
+static int parseNumberList(const CCON_CommandType* command,
+                           uint32_t* values,
+                           size_t maxCount,
+                           size_t* count)
+{
+    const char* response = command->responseBuf;
+    size_t responseLen = command->responseLen;
+    if ((command->result != 0) || (responseLen <= 2))
+    {
+        DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "error waiting for CAPTURino response to command \'%.*s\'! rv=%d, received bytes=%d", (int)echoLengthOf(command), command->cmd, command->result, responseLen);
+        DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "error waiting for CAPTURino response to command \'%.*s\'! Received %u chars: \'%.*s\'", (int)echoLengthOf(command), command->cmd, responseLen, responseLen, response);
+        return -1;
+    }
+
+    size_t j = 0;
+    bool skipCurrentLine = false;
+    for (size_t i=0; i<(responseLen-PROMPT_LEN);)
+    {
+        if (skipCurrentLine == true)
         {
-            *responseLen = 0;
-            return -2;
+            if ((response[i] == '\r') || (response[i] == '\n'))
+            {
+                skipCurrentLine = false;
+            }
+            i++;
         }
-        size_t bytesReceived = 0;
-        int rvRead = SERH_Read(mSerialHandle,
-                               responseBuf+totalBytesReceived,
-                               responseBufLen-totalBytesReceived-1,
-                               &bytesReceived);
-        totalBytesReceived += bytesReceived;
-        if (rvRead != 0)
+        else if ((response[i] == '\r') || (response[i] == '\n'))
         {
-            DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "reading from serial port failed!");
-            return -1;
+            i++;
+            continue;
         }
-        if (totalBytesReceived >= terminateSequenceLen)
+        else
         {
-            if (strncmp(responseBuf+totalBytesReceived-terminateSequenceLen,
-                        terminateSequence,
-                        terminateSequenceLen) == 0)
+            uint32_t value = 0;
+            char* endptr = NULL;
+            value = strtoul(response+i, &endptr, 10);
+            if (endptr == response+i)
+            {
+                DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "error parsing the response to \'%.*s\'! endptr=%p, expected=%p", (int)echoLengthOf(command), command->cmd, endptr, response+i);
+                DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "error parsing the response to \'%.*s\'! Received %u chars: \'%.*s\'", (int)echoLengthOf(command), command->cmd, responseLen, responseLen, response);
+                skipCurrentLine = true;
+                continue;
+            }
+            else
             {
-                break;
+                if (j < maxCount)
+                {
+                    values[j] = value;
+                    j++;
+                }
+                else
+                {
+                    DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "error parsing the response to \'%.*s\'! too many values received! received %u values, but only %u values are supported", (int)echoLengthOf(command), command->cmd, j, maxCount);
+                    *count = j;
+                    return 0;
+                }
+                i = (endptr - response) / sizeof(char);
             }
         }
-        if (totalBytesReceived >= responseBufLen - 1)
+    }
+    *count = j;
+    return 0;
+}
+
+static int compareBaudratesDescending(const void* a,
+                                      const void* b)
+{
+    uint32_t valA = *((const uint32_t*)a);
+    uint32_t valB = *((const uint32_t*)b);
+    return (valA < valB) - (valA > valB);
+}
+
+/** Checks the connection at the current baudrate by reading the board ID
+ * several times. */
+static int probeBaudrate(CCON_SessionType* session,
+                         uint32_t expectedBoardId,
+                         unsigned long timeoutMS,
+                         volatile bool* terminateFlag)
+{
+    if (CCON_InitiateSession(session, timeoutMS, terminateFlag) != 0)
+    {
+        return -1;
+    }
+    for (int i=0; i<CCON_BAUDRATE_PROBES; i++)
+    {
+        uint32_t boardId = 0;
+        if ((CCON_GetBoardId(session, timeoutMS, terminateFlag, &boardId) != 0)
+         || (boardId != expectedBoardId))
         {
             return -1;
         }
-        /* TODO: i've heard about the sleep function might sleep more or less than specified. Is that really true? It might be an issue here */
-        SYSU_Sleep(5); /* avoid high processor load */
     }
+    return 0;
+}
 
-    *responseLen = totalBytesReceived;
-    responseBuf[totalBytesReceived] = '\0';
+/** Switches the device and the port to the given baudrate. */
+static int switchBaudrate(CCON_SessionType* session,
+                          unsigned int baudrate,
+                          unsigned long timeoutMS,
+                          volatile bool* terminateFlag)
+{
+    char cmd[32];
+    int cmdLen = snprintf(cmd, sizeof(cmd), "baud %u\n", baudrate);
+    CCON_CommandType command;
+    initCommand(&command, cmd, (size_t)cmdLen, NULL, 0);
+    if (CCON_Submit(session, &command) == 0)
+    {
+        CCON_Complete(session, &command, timeoutMS, terminateFlag);
+    }
+    if ((command.result != 0)
+     || (SERH_SetBaudrate(session->serialHandle, baudrate) != 0))
+    {
+        return -1;
+    }
+    session->baudrate = baudrate;
     return 0;
 }
 
+/** Returns to the safe baudrate after a failed switch. The session is not
+ * initiated again once the terminate flag is set. */
+static int revertBaudrate(CCON_SessionType* session,
+                          unsigned int safeBaudrate,
+                          unsigned long timeoutMS,
+                          volatile bool* terminateFlag)
+{
+    if (session->baudrate != safeBaudrate)
+    {
+        /* a device which confirmed the new baudrate must be switched back by
+           a command, one which did not returns by itself */
+        if (switchBaudrate(session, safeBaudrate, timeoutMS, terminateFlag) != 0)
+        {
+            if (SERH_SetBaudrate(session->serialHandle, safeBaudrate) != 0)
+            {
+                return -1;
+            }
+            session->baudrate = safeBaudrate;
+            CCON_Wait(CCON_BAUDRATE_REVERT_MS, terminateFlag);
+        }
+    }
+    else
+    {
+        /* the port refused the baudrate the device switched to */
+        CCON_Wait(CCON_BAUDRATE_REVERT_MS, terminateFlag);
+    }
+    if (*terminateFlag == true)
+    {
+        return 0;
+    }
+    return CCON_InitiateSession(session, timeoutMS, terminateFlag);
+}
+
 /* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
-int CCON_Open(const char* path,
+int CCON_Open(CCON_SessionType* session,
+              const char* path,
               unsigned int baudrate)
 {
-    return SERH_Open(path, baudrate, &mSerialHandle);
+    session->queueHead = 0;
+    session->queueCount = 0;
+    session->echoPos = 0;
+    session->terminatePos = 0;
+    session->overflow = false;
+    if (EVLP_Open(&session->eventLoop) != 0)
+    {
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "unable to open an event loop for the session!");
+        return -1;
+    }
+    int rv = SERH_Open(path, baudrate, &session->serialHandle);
+    if (rv != 0)
+    {
+        EVLP_Close(session->eventLoop);
+        session->eventLoop = INVALID_EVENTLOOP_HANDLE;
+    }
+    session->baudrate = baudrate;
+    return rv;
 }
 
-int CCON_InitiateSession(unsigned long timeoutMS,
-                         volatile bool* terminateFlag)
+int CCON_SetLinkProfile(CCON_SessionType* session,
+                        SERH_LinkProfileType profile)
 {
-    int rv;
-    char tempRcvBuffer[128];
-    size_t bytesReceived;
+    return SERH_SetLinkProfile(session->serialHandle, profile);
+}
 
-    /* send a newline character to the CAPTURino to get a response */
-    DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
-    if (SERH_FlushInput(mSerialHandle) != 0)
+int CCON_SetHardwareFlowControl(CCON_SessionType* session,
+                                bool enable)
+{
+    return SERH_SetHardwareFlowControl(session->serialHandle, enable);
+}
+
+int CCON_Submit(CCON_SessionType* session,
+                CCON_CommandType* command)
+{
+    if (session->queueCount >= CCON_MAX_QUEUED_COMMANDS)
     {
-        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error clearing serial port buffers!");
+        DIAG_LogMsg(DIAG_ERROR, MODULE_NAME, __func__, "too many commands waiting for their response!");
         return -1;
     }
-    
-    if (SERH_Write(mSerialHandle, "\x03", STATIC_STRLEN("\x03")) != 0)
+    if (session->queueCount == 0)
     {
-        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error sending command to CAPTURino!");
-        return -1;
+        /* discard everything received which is not a response to a queued
+           command */
+        if (SERH_FlushInput(session->serialHandle) != 0)
+        {
+            DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error clearing serial port buffers!");
+            command->result = -1;
+            return -1;
+        }
+        session->echoPos = 0;
+        session->terminatePos = 0;
+        session->overflow = false;
     }
 
-    rv = wait4Response(timeoutMS/2,
-                       terminateFlag,
-                       tempRcvBuffer,
-                       &bytesReceived,
-                       128,
-                       "CAPTURino>",
-                       STATIC_STRLEN("CAPTURino>"));
-    if (rv != -2)
+    if (SERH_Write(session->serialHandle, command->cmd, command->cmdLen) != 0)
     {
-        /* return immediately if the function succeeded or failed totally */
-        return rv;
+        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error sending command to CAPTURino!");
+        command->result = -1;
+        return -1;
     }
-    else
+    command->responseLen = 0;
+    command->result = CCON_PENDING;
+    session->queue[(session->queueHead + session->queueCount) % CCON_MAX_QUEUED_COMMANDS] = command;
+    session->queueCount++;
+    return 0;
+}
+
+int CCON_Complete(CCON_SessionType* session,
+                  CCON_CommandType* command,
+                  unsigned long timeoutMS,
+                  volatile bool* terminateFlag)
+{
+    unsigned long startMillis;
+    SYSU_GetCurrentMillis(&startMillis);
+
+    completeFinishedCommands(session);
+    while (command->result == CCON_PENDING)
     {
-        /* take a second try with the ^C character if a timeout occured */
-        if (SERH_FlushInput(mSerialHandle) != 0)
+        if (*terminateFlag == true)
         {
-            DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error clearing serial port buffers!");
-            return -1;
+            /* the commands must not stay queued, they are left by the caller */
+            abortQueue(session, -1);
+            break;
         }
-        
-        if (SERH_Write(mSerialHandle, "\x03", STATIC_STRLEN("\x03")) != 0)
+        int bytesReceived = processAvailable(session);
+        if (bytesReceived < 0)
         {
-            DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error sending command to CAPTURino!");
-            return -1;
+            abortQueue(session, -1);
+            break;
+        }
+        if ((bytesReceived > 0) || (command->result != CCON_PENDING))
+        {
+            continue;
+        }
+
+        unsigned long currentMillis;
+        SYSU_GetCurrentMillis(&currentMillis);
+        /* the unsigned difference stays valid on a counter overflow */
+        unsigned long elapsedMillis = currentMillis - startMillis;
+        if (elapsedMillis >= timeoutMS)
+        {
+            DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "timeout waiting for the response to command \'%.*s\'", (int)echoLengthOf(command), command->cmd);
+            abortQueue(session, -2);
+            break;
+        }
+        EVLP_WaitResultType waitResult;
+        if (EVLP_WaitSerial(session->eventLoop,
+                            session->serialHandle,
+                            timeoutMS - elapsedMillis,
+                            &waitResult) != 0)
+        {
+            abortQueue(session, -1);
+            break;
         }
+    }
+    return command->result;
+}
 
-        return wait4Response(timeoutMS/2,
-                             terminateFlag,
-                             tempRcvBuffer,
-                             &bytesReceived,
-                             128,
-                             "CAPTURino>",
-                             STATIC_STRLEN("CAPTURino>"));
+int CCON_InitiateSession(CCON_SessionType* session,
+                         unsigned long timeoutMS,
+                         volatile bool* terminateFlag)
+{
+    DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
+
+    /* ^C is not echoed, the CAPTURino aborts any running command and prints
+       its prompt. The queue is empty afterwards, as it is waited for the
+       prompt before the next command is submitted. */
+    int rv = -2;
+    for (int attempt=0; (attempt < 2) && (rv == -2); attempt++)
+    {
+        CCON_CommandType command;
+        initCommand(&command, "\x03", STATIC_STRLEN("\x03"), NULL, 0);
+        abortQueue(session, -1);
+        if (CCON_Submit(session, &command) != 0)
+        {
+            return -1;
+        }
+        /* take a second try with the ^C character if a timeout occured */
+        rv = CCON_Complete(session, &command, timeoutMS/2, terminateFlag);
     }
+    return rv;
 }
 
-int CCON_GetBoardId(unsigned long timeoutMS,
+int CCON_GetBoardId(CCON_SessionType* session,
+                    unsigned long timeoutMS,
                     volatile bool* terminateFlag,
                     uint32_t* boardId)
 {
-    int rv;
     char rcvBuffer[128];
-    size_t bytesReceived = 0;
-    rv = CCON_ExecWithResponse("idfcn\n",
-                               STATIC_STRLEN("idfcn\n"),
-                               timeoutMS,
-                               terminateFlag,
-                               rcvBuffer,
-                               &bytesReceived,
-                               128,
-                               "CAPTURino>",
-                               STATIC_STRLEN("CAPTURino>"));
-    if ((rv != 0) || (bytesReceived < STATIC_STRLEN("idfcn") + 2 + 8))
+    CCON_CommandType command;
+    initCommand(&command, "idfcn\n", STATIC_STRLEN("idfcn\n"), rcvBuffer, sizeof(rcvBuffer));
+    if (CCON_Submit(session, &command) == 0)
     {
-        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "error waiting for CAPTURino response to command \'idfcn\'! rv=%d, received bytes=%d", rv, bytesReceived);
-        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "error waiting for CAPTURino response to command \'idfcn\'! Received %u chars: \'%.*s\'", bytesReceived, bytesReceived, rcvBuffer);
-        return -1;
-    }
-    else
-    {
-        char* endptr = NULL;
-        *boardId = strtoul(rcvBuffer+2, &endptr, 16);
-        /* it is expected that the command returns eight digits, hence the
-        endptr must match the rcvBuffer+STATIC_STRLEN("idfcn")+2+8 address */
-        if (endptr != rcvBuffer+2+8)
-        {
-            DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "error parsing board id from CAPTURino response! endptr=%p, expected=%p", endptr, rcvBuffer+2+8);
-            DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "error parsing board id from CAPTURino response! Received %u chars: \'%.*s\'", bytesReceived, bytesReceived, rcvBuffer);
-            return -1;
-        }
-        else
-        {
-            return 0;
-        }
+        CCON_Complete(session, &command, timeoutMS, terminateFlag);
     }
+    return parseBoardId(&command, boardId);
 }
 
-int CCON_GetBoardMicros(unsigned long timeoutMS,
+int CCON_GetBoardMicros(CCON_SessionType* session,
+                        unsigned long timeoutMS,
                         volatile bool* terminateFlag,
                         uint32_t* boardMicros)
 {
     int rv;
     char rcvBuffer[128];
     size_t bytesReceived = 0;
-    rv = CCON_ExecWithResponse("time\n",
+    rv = CCON_ExecWithResponse(session,
+                               "time\n",
                                STATIC_STRLEN("time\n"),
                                timeoutMS,
                                terminateFlag,
                                rcvBuffer,
                                &bytesReceived,
                                128,
-                               "CAPTURino>",
-                               STATIC_STRLEN("CAPTURino>"));
+                               PROMPT,
+                               PROMPT_LEN);
     if ((rv != 0) || (bytesReceived < 3))
     {
         DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "error waiting for CAPTURino response to command \'time\'! rv=%d, received bytes=%d", rv, bytesReceived);
@@ -328,146 +658,220 @@ int CCON_GetBoardMicros(unsigned long timeoutMS,
     }
 }
 
-int CCON_GetSupportedDlts(unsigned long timeoutMS,
+int CCON_GetSupportedDlts(CCON_SessionType* session,
+                          unsigned long timeoutMS,
                           volatile bool* terminateFlag,
                           uint32_t* dlts,
                           size_t maxDltsCount,
                           size_t* dltsCount)
 {
-    int rv;
-    char rcvBuffer[512];
-    size_t bytesReceived = 0;
-    /* get supported linktypes */
-    rv = CCON_ExecWithResponse("dlts\n",
-                                STATIC_STRLEN("dlts\n"),
-                                timeoutMS,
-                                terminateFlag,
-                                rcvBuffer,
-                                &bytesReceived,
-                                256,
-                                "CAPTURino>",
-                                STATIC_STRLEN("CAPTURino>"));
-    if ((rv != 0) || (bytesReceived <= 2))
-    {
-        DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "error waiting for CAPTURino response to command \'dlts\'! rv=%d, received bytes=%d", rv, bytesReceived);
-        DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "error waiting for CAPTURino response to command \'dlts\'! Received %u chars: \'%.*s\'", bytesReceived, bytesReceived, rcvBuffer);
+    char rcvBuffer[DLTS_RESPONSE_LENGTH];
+    CCON_CommandType command;
+    initCommand(&command, "dlts\n", STATIC_STRLEN("dlts\n"), rcvBuffer, sizeof(rcvBuffer));
+    if (CCON_Submit(session, &command) == 0)
+    {
+        CCON_Complete(session, &command, timeoutMS, terminateFlag);
+    }
+    return parseNumberList(&command, dlts, maxDltsCount, dltsCount);
+}
+
+int CCON_GetBoardInfo(CCON_SessionType* session,
+                      unsigned long timeoutMS,
+                      volatile bool* terminateFlag,
+                      uint32_t* boardId,
+                      uint32_t* dlts,
+                      size_t maxDltsCount,
+                      size_t* dltsCount)
+{
+    char idRcvBuffer[128];
+    char dltsRcvBuffer[DLTS_RESPONSE_LENGTH];
+    CCON_CommandType idCommand;
+    CCON_CommandType dltsCommand;
+    initCommand(&idCommand, "idfcn\n", STATIC_STRLEN("idfcn\n"), idRcvBuffer, sizeof(idRcvBuffer));
+    initCommand(&dltsCommand, "dlts\n", STATIC_STRLEN("dlts\n"), dltsRcvBuffer, sizeof(dltsRcvBuffer));
+
+    /* the second command is buffered by the device while it answers the
+       first one */
+    if ((CCON_Submit(session, &idCommand) != 0)
+     || (CCON_Submit(session, &dltsCommand) != 0))
+    {
+        abortQueue(session, -1);
         return -1;
     }
+    CCON_Complete(session, &dltsCommand, timeoutMS, terminateFlag);
+    abortQueue(session, -1);
 
-    size_t j = 0;
-    bool skipCurrentLine = false;
-    for (size_t i=0; i<(bytesReceived-STATIC_STRLEN("CAPTURino>"));)
+    if ((parseBoardId(&idCommand, boardId) != 0)
+     || (parseNumberList(&dltsCommand, dlts, maxDltsCount, dltsCount) != 0))
     {
-        if (skipCurrentLine == true)
+        return -1;
+    }
+    return 0;
+}
+
+int CCON_ProbeBoardIds(CCON_SessionType* sessions,
+                       size_t sessionCount,
+                       unsigned long timeoutMS,
+                       volatile bool* terminateFlag,
+                       uint32_t* boardIds,
+                       bool* responded)
+{
+    DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
+    if (sessionCount > CCON_MAX_PROBED_SESSIONS)
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "unable to probe more than %d ports at once", CCON_MAX_PROBED_SESSIONS);
+        return -1;
+    }
+    unsigned long startMillis;
+    SYSU_GetCurrentMillis(&startMillis);
+
+    /* every round submits a command to all ports which responded so far and
+       collects the responses afterwards, while the devices process them in
+       parallel. A silent port takes the whole time of a round, hence every
+       round gets its own share of the timeout. */
+    static const char* const ROUND_CMDS[] = { "\x03", "idfcn\n" };
+    const size_t roundCount = sizeof(ROUND_CMDS) / sizeof(ROUND_CMDS[0]);
+    char rcvBuffers[CCON_MAX_PROBED_SESSIONS][128];
+    CCON_CommandType commands[CCON_MAX_PROBED_SESSIONS];
+    for (size_t i=0; i<sessionCount; i++)
+    {
+        responded[i] = true;
+    }
+    for (size_t round=0; round<roundCount; round++)
+    {
+        unsigned long roundEndMillis = (timeoutMS / roundCount) * (round + 1);
+        for (size_t i=0; i<sessionCount; i++)
         {
-            if ((rcvBuffer[i] == '\r') || (rcvBuffer[i] == '\n'))
+            initCommand(&commands[i], ROUND_CMDS[round], strlen(ROUND_CMDS[round]), rcvBuffers[i], sizeof(rcvBuffers[i]));
+            if (responded[i] == true)
             {
-                skipCurrentLine = false;
+                abortQueue(&sessions[i], -1);
+                responded[i] = (CCON_Submit(&sessions[i], &commands[i]) == 0);
             }
         }
-        else if ((rcvBuffer[i] == '\r') || (rcvBuffer[i] == '\n'))
-        {
-            i++;
-            continue;
-        }
-        else
+        for (size_t i=0; i<sessionCount; i++)
         {
-            uint32_t dlt = 0;
-            char* endptr = NULL;
-            dlt = strtoul(rcvBuffer+i, &endptr, 10);
-            if (endptr == rcvBuffer+i)
+            if (responded[i] == false)
             {
-                DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "error parsing dlts from CAPTURino response! endptr=%p, expected=%p", endptr, rcvBuffer+i);
-                DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "error parsing dlts from CAPTURino response! Received %u chars: \'%.*s\'", bytesReceived, bytesReceived, rcvBuffer);
-                skipCurrentLine = true;
                 continue;
             }
-            else
-            {
-                if (j < maxDltsCount)
-                {
-                    dlts[j] = dlt;
-                    j++;
-                }
-                else
-                {
-                    DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "error parsing dlt from CAPTURino response! too many dlts received! received %u dlts, but only %u dlts are supported", j, maxDltsCount);
-                    *dltsCount = j;
-                    return 0;
-                }
-                i = (endptr - rcvBuffer) / sizeof(char);
-            }
+            unsigned long currentMillis;
+            SYSU_GetCurrentMillis(&currentMillis);
+            unsigned long elapsedMillis = currentMillis - startMillis;
+            /* a timeout of zero still takes the characters received so far */
+            unsigned long remainingMillis = (elapsedMillis < roundEndMillis) ? (roundEndMillis - elapsedMillis) : 0;
+            responded[i] = (CCON_Complete(&sessions[i], &commands[i], remainingMillis, terminateFlag) == 0);
+        }
+    }
+
+    for (size_t i=0; i<sessionCount; i++)
+    {
+        if (responded[i] == true)
+        {
+            responded[i] = (parseBoardId(&commands[i], &boardIds[i]) == 0);
         }
     }
-    *dltsCount = j;
     return 0;
 }
 
-int CCON_Exec(const char* cmd,
+int CCON_Exec(CCON_SessionType* session,
+              const char* cmd,
               size_t cmdLen, 
               unsigned long timeoutMS,
               volatile bool* terminateFlag)
 {
     DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
-    if (SERH_FlushInput(mSerialHandle) != 0)
+    CCON_CommandType command;
+    initCommand(&command, cmd, cmdLen, NULL, 0);
+    command.terminateSequence = NULL;
+    command.terminateSequenceLen = 0;
+    if (CCON_Submit(session, &command) != 0)
     {
-        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error clearing serial port buffers!");
         return -1;
     }
-    
-    if (SERH_Write(mSerialHandle, cmd, cmdLen) != 0)
+    return CCON_Complete(session, &command, timeoutMS, terminateFlag);
+}
+
+int CCON_NegotiateBaudrate(CCON_SessionType* session,
+                           unsigned int maxBaudrate,
+                           unsigned long timeoutMS,
+                           volatile bool* terminateFlag)
+{
+    DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
+    const unsigned int safeBaudrate = session->baudrate;
+
+    uint32_t boardId = 0;
+    if (CCON_GetBoardId(session, timeoutMS, terminateFlag, &boardId) != 0)
     {
-        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error sending command to CAPTURino!");
         return -1;
     }
 
-    size_t totalBytesReceived = 0;
-    unsigned long timeoutStartPoint;
-    char responseBuf[128];
-    SYSU_GetCurrentMillis(&timeoutStartPoint);
-    while (*terminateFlag == false)
+    char rcvBuffer[BAUDS_RESPONSE_LENGTH];
+    CCON_CommandType command;
+    initCommand(&command, "bauds\n", STATIC_STRLEN("bauds\n"), rcvBuffer, sizeof(rcvBuffer));
+    if (CCON_Submit(session, &command) == 0)
     {
-        unsigned long currentMillis;
-        SYSU_GetCurrentMillis(&currentMillis);
-        if (isTimeoutReached(timeoutStartPoint,
-                             timeoutStartPoint + timeoutMS,
-                             currentMillis))
+        CCON_Complete(session, &command, timeoutMS, terminateFlag);
+    }
+    uint32_t baudrates[CCON_MAX_BAUDRATES];
+    size_t baudratesCount = 0;
+    if ((parseNumberList(&command, baudrates, CCON_MAX_BAUDRATES, &baudratesCount) != 0)
+     || (baudratesCount == 0))
+    {
+        DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "the device lists no baudrates, staying at %u baud", safeBaudrate);
+        /* an unknown command might have been answered by anything */
+        return CCON_InitiateSession(session, timeoutMS, terminateFlag);
+    }
+
+    qsort(baudrates, baudratesCount, sizeof(uint32_t), compareBaudratesDescending);
+    for (size_t i=0; (i < baudratesCount) && (*terminateFlag == false); i++)
+    {
+        unsigned int baudrate = baudrates[i];
+        if ((baudrate <= safeBaudrate) || ((maxBaudrate != 0) && (baudrate > maxBaudrate)))
         {
-            return -2;
+            continue;
         }
-        size_t bytesReceived = 0;
-        int rvRead = SERH_Read(mSerialHandle,
-                               responseBuf+totalBytesReceived,
-                               cmdLen-1-totalBytesReceived,
-                               &bytesReceived);
-        totalBytesReceived += bytesReceived;
-        if (rvRead != 0)
+        if ((switchBaudrate(session, baudrate, timeoutMS, terminateFlag) == 0)
+         && (probeBaudrate(session, boardId, timeoutMS, terminateFlag) == 0))
         {
-            DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "reading from serial port failed!");
-            return -1;
+            DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "switched from %u to %u baud", safeBaudrate, baudrate);
+            return 0;
         }
-        if (totalBytesReceived >= (cmdLen-1))
+        DIAG_LogMsgArg(DIAG_WARNING, MODULE_NAME, __func__, "the connection failed at %u baud, falling back to %u baud", baudrate, safeBaudrate);
+        if (revertBaudrate(session, safeBaudrate, timeoutMS, terminateFlag) != 0)
         {
-            /* check if the returned characters match the command */
-            return ((strncmp(responseBuf, cmd, cmdLen-1) == 0) ? 0 : -1);
+            DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "the device does not respond at %u baud anymore!", safeBaudrate);
+            return -1;
         }
-        /* TODO: i've heard about the sleep function might sleep more or less than specified. Is that really true? It might be an issue here */
-        SYSU_Sleep(5); /* avoid high processor load */
     }
+    DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "staying at %u baud", safeBaudrate);
     return 0;
 }
 
-int CCON_Read(char* buf,
+int CCON_Read(CCON_SessionType* session,
+              char* buf,
               size_t bufLen,
               size_t* bytesRead)
 {
-    return SERH_Read(mSerialHandle,
+    return SERH_Read(session->serialHandle,
                      buf,
                      bufLen,
                      bytesRead);
 }
 
-int CCON_ExecWithResponse(const char* cmd,
+int CCON_WaitForData(CCON_SessionType* session,
+                     EventLoopHandleType eventLoop,
+                     unsigned long timeoutMS,
+                     EVLP_WaitResultType* result)
+{
+    return EVLP_WaitSerial(eventLoop,
+                           session->serialHandle,
+                           timeoutMS,
+                           result);
+}
+
+int CCON_ExecWithResponse(CCON_SessionType* session,
+                          const char* cmd,
                           size_t cmdLen, 
                           unsigned long timeoutMS,
                           volatile bool* terminateFlag,
@@ -478,27 +882,19 @@ int CCON_ExecWithResponse(const char* cmd,
                           size_t terminateSequenceLen)
 {
     DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
-    unsigned long functionStartMillis;
-    SYSU_GetCurrentMillis(&functionStartMillis);
+    CCON_CommandType command;
+    initCommand(&command, cmd, cmdLen, responseBuf, responseBufLen);
+    command.terminateSequence = terminateSequence;
+    command.terminateSequenceLen = terminateSequenceLen;
 
     *responseLen = 0;
-
-    if (CCON_Exec(cmd, cmdLen, timeoutMS, terminateFlag) != 0)
+    responseBuf[0] = '\0';
+    if (CCON_Submit(session, &command) != 0)
     {
         return -1;
-    } 
-
-    unsigned long currentMillis;
-    SYSU_GetCurrentMillis(&currentMillis);
-    /** \todo call probably does not work on a timer overflow */
-    int rv = wait4Response(timeoutMS - (currentMillis - functionStartMillis),
-                           terminateFlag,
-                           responseBuf,
-                           responseLen,
-                           responseBufLen,
-                           terminateSequence,
-                           terminateSequenceLen);
-    responseBuf[*responseLen] = '\0';
+    }
+    int rv = CCON_Complete(session, &command, timeoutMS, terminateFlag);
+    *responseLen = command.responseLen;
     return rv;
 }
 
@@ -508,19 +904,15 @@ int CCON_Wait(unsigned long timeMS,
               volatile bool* terminateFlag)
 {
     DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
-    unsigned long currentMillis;
-    SYSU_GetCurrentMillis(&currentMillis);
-    unsigned long timeoutPoint = currentMillis + timeMS;
-    bool overflowFlag = timeoutPoint < currentMillis;
+    unsigned long startMillis;
+    SYSU_GetCurrentMillis(&startMillis);
 
     while (*terminateFlag == false)
     {
+        unsigned long currentMillis;
         SYSU_GetCurrentMillis(&currentMillis);
-        if ((overflowFlag == true) && (currentMillis < timeoutPoint))
-        {
-            overflowFlag = false;
-        }
-        if ((currentMillis > timeoutPoint) && (overflowFlag == false))
+        /* the unsigned difference stays valid on a counter overflow */
+        if ((currentMillis - startMillis) >= timeMS)
         {
             break;
         }
@@ -529,13 +921,19 @@ int CCON_Wait(unsigned long timeMS,
     return 0;
 }
 
-int CCON_Close()
+int CCON_Close(CCON_SessionType* session)
 {
     int rv = -1;
-    if (mSerialHandle != INVALID_SERIAL_HANDLE)
+    abortQueue(session, -1);
+    if (session->eventLoop != INVALID_EVENTLOOP_HANDLE)
+    {
+        EVLP_Close(session->eventLoop);
+        session->eventLoop = INVALID_EVENTLOOP_HANDLE;
+    }
+    if (session->serialHandle != INVALID_SERIAL_HANDLE)
     {
-        rv = SERH_Close(mSerialHandle);
-        mSerialHandle = INVALID_SERIAL_HANDLE;
+        rv = SERH_Close(session->serialHandle);
+        session->serialHandle = INVALID_SERIAL_HANDLE;
     }
     return rv;
 }
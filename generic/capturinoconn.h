@@ -32,6 +32,12 @@
  * \addtogroup capturinoconn
  * \brief Module managing the connection and communication to the CAPTURino
  *        embedded system.
+ *
+ * The device echoes every command, followed by the response and the
+ * "CAPTURino>" prompt. Commands are queued per session and may be written
+ * before the previous ones have been answered. The received characters are
+ * parsed as they arrive, and the caller blocks on the serial port instead of
+ * polling it.
  * 
  * @{
  */
@@ -47,8 +53,10 @@
 /* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "eventloop.h"
 #include "serialhandling.h"
 
 /* ***************************************************************************
@@ -60,6 +68,21 @@ extern "C"
 #endif
 
 /* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+/** initializer for a session that is not connected to any device */
+#define CCON_SESSION_INITIALIZER { .serialHandle = 0, .eventLoop = 0, .queueCount = 0 }
+/** maximum number of commands waiting for their response per session */
+#define CCON_MAX_QUEUED_COMMANDS    (4)
+/** maximum number of ports probed by CCON_ProbeBoardIds() at once */
+#define CCON_MAX_PROBED_SESSIONS    (16)
+/** result of a command which has not been completed yet */
+#define CCON_PENDING                (1)
+/** maximum number of baudrates listed by the device */
+#define CCON_MAX_BAUDRATES          (16)
+/** time after which the device returns to its former baudrate, if it did not
+    receive a complete command at the new one */
+#define CCON_BAUDRATE_REVERT_MS     (1000)
+/** number of "idfcn" round trips probing the integrity of a new baudrate */
+#define CCON_BAUDRATE_PROBES        (3)
 
 /* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
 
@@ -68,6 +91,40 @@ extern "C"
  *************************************************************************** */
 
 /* G L O B A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * */
+/** A command executed by the CAPTURino device. Must stay valid until it has
+ * been completed. */
+typedef struct
+{
+    const char* cmd;
+    size_t      cmdLen;
+    const char* terminateSequence;  /**< end of the response, NULL to complete
+                                         the command once it was echoed */
+    size_t      terminateSequenceLen;
+    char*       responseBuf;        /**< receives the response following the
+                                         echo, NULL to discard it */
+    size_t      responseBufLen;
+    size_t      responseLen;
+    int         result;             /**< CCON_PENDING, 0 on success, -1 on an
+                                         error or -2 on a timeout */
+} CCON_CommandType;
+
+/** Connection to a single CAPTURino device. Each opened device needs its own
+ * session, which allows talking to several devices at the same time. */
+typedef struct
+{
+    SerialHandleType    serialHandle;
+    EventLoopHandleType eventLoop;      /**< to wait for the response */
+    unsigned int        baudrate;       /**< current baudrate of the port */
+    CCON_CommandType*   queue[CCON_MAX_QUEUED_COMMANDS];
+    size_t              queueHead;
+    size_t              queueCount;
+    size_t              echoPos;        /**< echoed characters of the oldest
+                                             command */
+    size_t              terminatePos;   /**< matched characters of its
+                                             terminate sequence */
+    bool                overflow;       /**< its response exceeded the
+                                             buffer */
+} CCON_SessionType;
 
 /* ***************************************************************************
  * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
@@ -82,17 +139,46 @@ extern "C"
 /* G L O B A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * */
 /** Opens a serial connection to the CAPTURino device.
  * 
+ * \param[out] session session that is connected to the device.
  * \param[in] path serial port to the CAPTURino device.
  * \param[in] baudrate baudrate of the serial connection.
  * 
  * \returns 0: if the serial connection was opened successfully.
  * \returns -1: if the function failed.
  */
-int CCON_Open            (const    char*         path,
+int CCON_Open            (         CCON_SessionType* session,
+                          const    char*         path,
                                    unsigned int  baudrate);
 
+/** Tunes the USB serial converter of the connection for either low latency
+ * or high throughput, see SERH_SetLinkProfile(). The original settings are
+ * restored by CCON_Close().
+ *
+ * \param[in] session session of the CAPTURino device.
+ * \param[in] profile the profile to be applied.
+ *
+ * \returns 0: if the profile was applied as far as supported by the
+ *             converter.
+ * \returns -1: if the function failed.
+ */
+int CCON_SetLinkProfile  (         CCON_SessionType*    session,
+                                   SERH_LinkProfileType profile);
+
+/** Enables the RTS/CTS flow control of the connection, which must be
+ * supported by the wiring between the adapter and the CAPTURino device.
+ *
+ * \param[in] session session of the CAPTURino device.
+ * \param[in] enable true to enable the flow control.
+ *
+ * \returns 0: if the flow control was changed.
+ * \returns -1: if the function failed.
+ */
+int CCON_SetHardwareFlowControl(   CCON_SessionType*    session,
+                                   bool                 enable);
+
 /** Initiates a session with the CAPTURino device.
  * 
+ * \param[in] session session of the CAPTURino device.
  * \param[in] timeoutMS timeout in milliseconds.
  * \param[in] terminateFlag flag to indicate that the session should be
  *                          terminated. This flag might be set asynchronously.
@@ -100,11 +186,13 @@ int CCON_Open            (const    char*         path,
  * \returns 0: if the session was initiated successfully.
  * \returns -1: if the function failed.
  */
-int CCON_InitiateSession (         unsigned long timeoutMS,
+int CCON_InitiateSession (         CCON_SessionType* session,
+                                   unsigned long timeoutMS,
                           volatile bool*         terminateFlag);
 
 /** Gets the board ID of the CAPTURino device.
  * 
+ * \param[in] session session of the CAPTURino device.
  * \param[in] timeoutMS timeout in milliseconds.
  * \param[in] terminateFlag flag to indicate that the command should be
  *                          terminated. This flag might be set asynchronously.
@@ -112,12 +200,14 @@ int CCON_InitiateSession (         unsigned long timeoutMS,
  * \returns 0: if the board ID was read successfully.
  * \returns -1: if the function failed.
  */
-int CCON_GetBoardId      (         unsigned long timeoutMS,
+int CCON_GetBoardId      (         CCON_SessionType* session,
+                                   unsigned long timeoutMS,
                           volatile bool*         terminateFlag,
                                    uint32_t*     boardId);
 
 /** Gets the board micros of the CAPTURino device.
  * 
+ * \param[in] session session of the CAPTURino device.
  * \param[in] timeoutMS timeout in milliseconds.
  * \param[in] terminateFlag flag to indicate that the command should be
  *                          terminated. This flag might be set asynchronously.
@@ -127,12 +217,14 @@ int CCON_GetBoardId      (         unsigned long timeoutMS,
  * \returns 0: if the board micros were read successfully.
  * \returns -1: if the function failed.
  */
-int CCON_GetBoardMicros  (         unsigned long timeoutMS,
+int CCON_GetBoardMicros  (         CCON_SessionType* session,
+                                   unsigned long timeoutMS,
                           volatile bool*         terminateFlag,
                                    uint32_t*     boardMicros);
 
 /** Gets a list of the supported link types of the CAPTURino device.
  * 
+ * \param[in] session session of the CAPTURino device.
  * \param[in] timeoutMS timeout in milliseconds.
  * \param[in] terminateFlag flag to indicate that the command should be
  *                          terminated. This flag might be set asynchronously.
@@ -143,17 +235,135 @@ int CCON_GetBoardMicros  (         unsigned long timeoutMS,
  * \returns 0: if the supported link types were read successfully.
  * \returns -1: if the function failed.
  */
-int CCON_GetSupportedDlts(         unsigned long timeoutMS,
+int CCON_GetSupportedDlts(         CCON_SessionType* session,
+                                   unsigned long timeoutMS,
+                          volatile bool*         terminateFlag,
+                                   uint32_t*     dlts,
+                                   size_t        maxDltsCount,
+                                   size_t*       dltsCount);
+
+/** Gets the board ID and the supported link types of the CAPTURino device.
+ * Both commands are sent at once, which saves a round trip compared to
+ * CCON_GetBoardId() followed by CCON_GetSupportedDlts().
+ *
+ * \param[in] session session of the CAPTURino device.
+ * \param[in] timeoutMS timeout in milliseconds for both commands.
+ * \param[in] terminateFlag flag to indicate that the commands should be
+ *                          terminated. This flag might be set asynchronously.
+ * \param[out] boardId board ID of the CAPTURino device.
+ * \param[out] dlts array of supported link types.
+ * \param[in] maxDltsCount maximum number of supported link types.
+ * \param[out] dltsCount number of supported link types.
+ *
+ * \returns 0: if both were read successfully.
+ * \returns -1: if the function failed.
+ */
+int CCON_GetBoardInfo    (         CCON_SessionType* session,
+                                   unsigned long timeoutMS,
                           volatile bool*         terminateFlag,
+                                   uint32_t*     boardId,
                                    uint32_t*     dlts,
                                    size_t        maxDltsCount,
                                    size_t*       dltsCount);
 
+/** Checks which of several opened ports are connected to a CAPTURino device
+ * and gets their board IDs. The session initiation and the "idfcn" command
+ * are sent to all ports at once, so all devices are probed within a single
+ * timeout regardless of their number.
+ *
+ * \param[in] sessions sessions of the opened ports.
+ * \param[in] sessionCount number of sessions.
+ * \param[in] timeoutMS timeout in milliseconds for probing all ports.
+ * \param[in] terminateFlag flag to indicate that the probing should be
+ *                          terminated. This flag might be set asynchronously.
+ * \param[out] boardIds board ID of the device at each port.
+ * \param[out] responded true for every port a CAPTURino device responded at.
+ *
+ * \returns 0: if the probing was done, even if no device responded.
+ * \returns -1: if the function failed.
+ */
+int CCON_ProbeBoardIds   (         CCON_SessionType* sessions,
+                                   size_t        sessionCount,
+                                   unsigned long timeoutMS,
+                          volatile bool*         terminateFlag,
+                                   uint32_t*     boardIds,
+                                   bool*         responded);
+
+/** Switches the connection to the highest baudrate supported by both the
+ * device and the serial port. The session must have been initiated at the
+ * baudrate given to CCON_Open(), which is the safe baudrate falling back to.
+ *
+ * The device lists its baudrates in response to "bauds", a line per
+ * baudrate. For every baudrate above the current one, starting with the
+ * highest:
+ * 1. "baud <rate>" is sent. The device prints its prompt and switches to
+ *    the new baudrate afterwards.
+ * 2. The port is switched to the new baudrate.
+ * 3. The session is initiated again and the board ID is read
+ *    CCON_BAUDRATE_PROBES times, which must match the one read before.
+ *
+ * The device keeps the new baudrate once it received a complete command at
+ * it. Otherwise it returns to its former baudrate after
+ * CCON_BAUDRATE_REVERT_MS. If a step fails, the device is switched back to
+ * the safe baudrate by a command or by waiting for it to return by itself,
+ * and the next lower baudrate is tried. A device which does not know the
+ * "bauds" command stays at the safe baudrate.
+ *
+ * \param[in] session session of the CAPTURino device.
+ * \param[in] maxBaudrate the highest baudrate to be tried, 0 for no limit.
+ * \param[in] timeoutMS timeout of each step in milliseconds.
+ * \param[in] terminateFlag flag to indicate that the negotiation should be
+ *                          terminated. This flag might be set asynchronously.
+ *
+ * \returns 0: if the session is usable at the baudrate of the session, which
+ *             is the negotiated or the safe baudrate.
+ * \returns -1: if the device does not respond at the safe baudrate anymore.
+ */
+int CCON_NegotiateBaudrate(        CCON_SessionType* session,
+                                   unsigned int  maxBaudrate,
+                                   unsigned long timeoutMS,
+                          volatile bool*         terminateFlag);
+
+/** Writes a command to the CAPTURino device without waiting for its
+ * response. The command is queued behind the ones submitted before.
+ *
+ * \warning In order for the CAPTURino device to execute the command, the last
+ *          character of the command string must be a newline character.
+ *
+ * \param[in] session session of the CAPTURino device.
+ * \param[in,out] command the command, its result is set to CCON_PENDING.
+ *
+ * \returns 0: if the command was written successfully.
+ * \returns -1: if the function failed or the queue is full.
+ */
+int CCON_Submit          (         CCON_SessionType* session,
+                                   CCON_CommandType* command);
+
+/** Processes the received characters until the given command and all
+ * commands submitted before have been completed. Blocks on the serial port
+ * while no characters are available.
+ *
+ * \param[in] session session of the CAPTURino device.
+ * \param[in] command a command submitted to the session.
+ * \param[in] timeoutMS timeout in milliseconds.
+ * \param[in] terminateFlag flag to indicate that the commands should be
+ *                          terminated. This flag might be set asynchronously.
+ *
+ * \returns 0: if the command has been completed successfully.
+ * \returns -1: if the function or the command failed.
+ * \returns -2: if the function failed due to a timeout.
+ */
+int CCON_Complete        (         CCON_SessionType* session,
+                                   CCON_CommandType* command,
+                                   unsigned long timeoutMS,
+                          volatile bool*         terminateFlag);
+
 /** Writes a given command to the CAPTURino device.
  * 
  * \warning In order for the CAPTURino device to execute the command, the last
  *          character of the command string must be a newline character.
  *
+ * \param[in] session session of the CAPTURino device.
  * \param[in] cmd command to be executed.
  * \param[in] cmdLen number of characters in cmd.
  * \param[in] timeoutMS timeout in milliseconds.
@@ -163,13 +373,15 @@ int CCON_GetSupportedDlts(         unsigned long timeoutMS,
  * \returns 0: if the command was executed successfully.
  * \returns -1: if the function failed.
  */
-int CCON_Exec            (const    char*         cmd,
+int CCON_Exec            (         CCON_SessionType* session,
+                          const    char*         cmd,
                                    size_t        cmdLen, 
                                    unsigned long timeoutMS,
                           volatile bool*         terminateFlag);
 
 /** Reads data from the CAPTURino device.
  * 
+ * \param[in] session session of the CAPTURino device.
  * \param[out] buf buffer to store the read data.
  * \param[in] bufLen size of the buffer.
  * \param[out] bytesRead number of bytes read.
@@ -177,15 +389,33 @@ int CCON_Exec            (const    char*         cmd,
  * \returns 0: if the data was read successfully.
  * \returns -1: if the function failed.
  */
-int CCON_Read            (         char*         buf,
+int CCON_Read            (         CCON_SessionType* session,
+                                   char*         buf,
                                    size_t        bufLen,
                                    size_t*       bytesRead);
 
+/** Blocks until data from the CAPTURino device is available, the given event
+ * loop is woken up or the timeout expires.
+ * 
+ * \param[in] session session of the CAPTURino device.
+ * \param[in] eventLoop event loop that is used to wait for the data.
+ * \param[in] timeoutMS timeout in milliseconds.
+ * \param[out] result reason for the function to return.
+ * 
+ * \returns 0: if the wait operation was successful.
+ * \returns -1: if the function failed.
+ */
+int CCON_WaitForData     (         CCON_SessionType* session,
+                                   EventLoopHandleType  eventLoop,
+                                   unsigned long        timeoutMS,
+                                   EVLP_WaitResultType* result);
+
 /** Writes a given command to the CAPTURino device and waits for a response.
  * 
  * \warning In order for the CAPTURino device to execute the command, the last
  *          character of the command string must be a newline character.
  * 
+ * \param[in] session session of the CAPTURino device.
  * \param[in] cmd command to be executed.
  * \param[in] cmdLen number of characters in cmd.
  * \param[in] timeoutMS timeout in milliseconds.
@@ -203,7 +433,8 @@ int CCON_Read            (         char*         buf,
  * \returns -1: if the function failed.
  * \returns -2: if the function failed due to a timeout.
  */
-int CCON_ExecWithResponse(const    char*         cmd,
+int CCON_ExecWithResponse(         CCON_SessionType* session,
+                          const    char*         cmd,
                                    size_t        cmdLen, 
                                    unsigned long timeoutMS,
                           volatile bool*         terminateFlag,
@@ -225,11 +456,13 @@ int CCON_Wait            (         unsigned long timeMS,
                           volatile bool*         terminateFlag);
 
 /** Closes the connection to the CAPTURino device.
+ *
+ * \param[in,out] session session of the CAPTURino device.
  *
  * \returns 0: if the connection was closed successfully.
  * \returns -1: if the function failed.
  */
-int CCON_Close           ();
+int CCON_Close           (         CCON_SessionType* session);
 
 /* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
 
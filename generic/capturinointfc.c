@@ -31,20 +31,27 @@
 /* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
 #include "capturino2pcapadptr.h"
 #include "capturinoconn.h"
+#include "capturinodecoder.h"
+#include "capturinomerger.h"
+#include "capturinoreader.h"
 #include "console.h"
 #include "diagnosis.h"
+#include "driftestimator.h"
+#include "timestampunwrapper.h"
+#include "eventloop.h"
 #include "genericutils.h"
 #include "pipehandling.h"
 #include "pcap_writer.h"
 #include "serialhandling.h"
 #include "systemutils.h"
 #include "capturinocommonintfcfuncs.h"
-#include "ringbuf.h"
 
 /* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
 #include "capturinointfc.h"
@@ -54,18 +61,56 @@
  *************************************************************************** */
 
 /* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+/** maximum time to block while waiting for data from the CAPTURino device.
+    The capture loop is woken up earlier on received data or termination. */
+#define IDLE_WAIT_TIMEOUT_MS    (500)
 
 /* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
 
 /* ***************************************************************************
  * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
  *************************************************************************** */
-typedef enum
+/** Converts the timestamps of a device to the host time */
+typedef struct
 {
-    CAPTURINO_STATE_RCV_HEADER_TIMESTAMP = 0,
-    CAPTURINO_STATE_RCV_HEADER_PAYLOAD_LENGTH = 1,
-    CAPTURINO_STATE_RCV_CONTENT = 2,
-} LocalCaptureStmacStatesType;
+    TSUW_UnwrapperType unwrapper;
+    DRFT_EstimatorType drift;
+    unsigned long      syncErrorBoundMicros;
+    uint32_t           rcvMillis;               /**< monotonic host time at
+                                                     which the data being
+                                                     decoded was received */
+    uint64_t           rcvHostNanos;            /**< the same as unix time */
+    uint64_t           latestMicros;            /**< latest device timestamp,
+                                                     extended to 64 bit */
+    bool               timestampReceived;       /**< since the last drift
+                                                     sample */
+} LocalTimelineType;
+
+typedef struct
+{
+    const CaptureOutputType* output;
+    unsigned long            dltValue;
+    LocalTimelineType        timeline;
+    uint64_t                 framesReceived;
+    uint64_t                 framesDropped;
+} LocalCaptureContextType;
+
+/** A board captured together with others */
+typedef struct
+{
+    const char*       comPort;
+    unsigned long     dltValue;
+    size_t            index;                    /**< source within the merger */
+    CaptureOutputType output;                   /**< with the interface id of
+                                                     the board */
+    CCON_SessionType  session;
+    CRDR_ReaderType   reader;
+    bool              readerStarted;
+    CDEC_DecoderType  decoder;
+    LocalTimelineType timeline;
+    uint64_t          framesReceived;
+    uint64_t          framesDropped;
+} LocalBoardType;
 
 /* ***************************************************************************
  * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
@@ -75,7 +120,11 @@ typedef enum
 
 /* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
 static volatile bool mTerminateFlag = false;
-static LocalCaptureStmacStatesType mCaptureState = CAPTURINO_STATE_RCV_HEADER_TIMESTAMP;
+static EventLoopHandleType mEventLoop = 0;
+static CCON_SessionType mSession = CCON_SESSION_INITIALIZER;
+/** state of the multi-board capture, too large for the stack */
+static LocalBoardType mBoards[CMRG_MAX_SOURCES];
+static CMRG_MergerType mMerger;
 
 /* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
 static const char* MODULE_NAME = "CAPT_INTF";
@@ -105,14 +154,77 @@ const EXMG_IntfcType capturinoIntfc =
 
 /* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
 
-static int captureWithOpenFifoAndComm(PipeHandleType fifoPipe,
-                                      unsigned long dltValue,
-                                      int argc,
-                                      char *argv[])
+/** Waits for the first character returned by the capture command. Must be
+ * ^F (0x06) to indicate a successful start of the capture process.
+ */
+static int waitForCaptureStart(CCON_SessionType* session)
+{
+    while (mTerminateFlag == false)
+    {
+        size_t bytesRead = 0;
+        char rcvChar;
+        int fcnRt = CCON_Read(session, &rcvChar, 1, &bytesRead);
+        if (fcnRt != 0)
+        {
+            DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error reading from serial port!");
+            return -1;
+        }
+        if (bytesRead > 0)
+        {
+            DIAG_LogMsgArg(DIAG_DEBUG, MODULE_NAME, __func__, "Received char: 0x%02X", rcvChar);
+            if ((rcvChar == '\r') || (rcvChar == '\n'))
+            {
+                /* ignore new line characters \r and \n */
+                continue;
+            }
+            else if (rcvChar == 0x06)
+            {
+                break;
+            }
+            else
+            {
+                DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "Expected to receive %02X, but received %02X", 0x06, rcvChar);
+                if (rcvChar == 'R')
+                {
+                    CNSL_WriteErr("The CAPTURino hardware is trying to communicate with a human, but I am a machine. Please flash the correct software to the CAPTURino hardware!",
+                            STATIC_STRLEN("The CAPTURino hardware is trying to communicate with a human, but I am a machine. Please flash the correct software to the CAPTURino hardware!"));
+                }
+                return -1;
+            }
+        }
+        else
+        {
+            /* block until the next character arrives to avoid high CPU usage */
+            EVLP_WaitResultType waitResult;
+            if (CCON_WaitForData(session, mEventLoop, IDLE_WAIT_TIMEOUT_MS, &waitResult) != 0)
+            {
+                DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error waiting for data from serial port!");
+                return -1;
+            }
+            if (waitResult == EVLP_TIMEOUT)
+            {
+                DIAG_LogMsgArg(DIAG_VERBOSE, MODULE_NAME, __func__, "no data received within %d ms", IDLE_WAIT_TIMEOUT_MS);
+            }
+        }
+    }
+    return 0;
+}
+
+/** Starts the capture process on the device. On success the device streams
+ * the captured frames from now on.
+ *
+ * \param[out] sync timestamp of the device and the host time at which the
+ *                  device reported it.
+ */
+static int startCapture(CCON_SessionType* session,
+                        unsigned long dltValue,
+                        int argc,
+                        char *argv[],
+                        CapturinoTimeSyncType* sync)
 {
     int fcnRt = 0;
 
-    fcnRt = CCON_InitiateSession(5000, &mTerminateFlag);
+    fcnRt = CCON_InitiateSession(session, 5000, &mTerminateFlag);
     if (fcnRt != 0)
     {
         DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "error waiting for CAPTURino response! Return value=%d", fcnRt);
@@ -120,22 +232,30 @@ static int captureWithOpenFifoAndComm(PipeHandleType fifoPipe,
     }
     
     DIAG_LogMsg(DIAG_INFO, MODULE_NAME, __func__, "connection to CAPTURino established");
+
+    /* optional argument, the negotiation is skipped if it does not exceed
+       the configured baudrate */
+    unsigned long maxBaudrate = CAPTURino_DEFAULT_MAX_BAUDRATE;
+    if (ARGP_getUnsignedLongOfArgs(argc, argv, "--maxbaudrate", &maxBaudrate) != 0)
+    {
+        maxBaudrate = CAPTURino_DEFAULT_MAX_BAUDRATE;
+    }
+    if (maxBaudrate > session->baudrate)
+    {
+        fcnRt = CCON_NegotiateBaudrate(session, (unsigned int)maxBaudrate, CAPTURino_NEGOTIATION_TIMEOUT_MS, &mTerminateFlag);
+        if (fcnRt != 0)
+        {
+            DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "lost the connection to CAPTURino while negotiating the baudrate!");
+            return -1;
+        }
+    }
     
-    /* get current time from the system ... */
-    unsigned long long hostUnixTime = 0;
-    unsigned long hostMicros = 0;
-    SYSU_GetCurrentTime(&hostUnixTime, &hostMicros);
-    /* ... get current millis from the device ... */
-    uint32_t capturinoMicros = 0;
-    fcnRt = CCON_GetBoardMicros(500, &mTerminateFlag, &capturinoMicros);
+    fcnRt = capturinoCommonSyncTime(session, 500, &mTerminateFlag, sync);
     if (fcnRt != 0)
     {
-        DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "error waiting for CAPTURino response! Return value=%d", fcnRt);
+        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to synchronize the time of the CAPTURino device!");
         return -1;
     }
-    /* ... and calculate the base time to print the current timestamp within
-       wireshark */
-    capturinoCommonSetTimebase(hostUnixTime, hostMicros, capturinoMicros);
 
     /** \warning the command length must not be greater than the CLI_INPUT_BUFFER_SIZE
      *           of the embedded software */
@@ -148,7 +268,7 @@ static int captureWithOpenFifoAndComm(PipeHandleType fifoPipe,
         return -1;
     }
 
-    fcnRt = CCON_Exec(captureCmd, cmdLen, 200, &mTerminateFlag);
+    fcnRt = CCON_Exec(session, captureCmd, cmdLen, 200, &mTerminateFlag);
     if (fcnRt != 0)
     {
         DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error sending capture command!");
@@ -157,176 +277,204 @@ static int captureWithOpenFifoAndComm(PipeHandleType fifoPipe,
 
     DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "Sent capture command with %lu characters: \'%.*s\'", cmdLen, cmdLen, captureCmd);
 
-    /* wait for the first character returned by the capture command. Must be
-       ^F (0x06) to indicate a successful start of the capture process */
+    return waitForCaptureStart(session);
+}
+
+/** Writes the statistics of a capture together with the accuracy of the
+ * timebase. */
+static void writeStatistics(const CaptureOutputType* output,
+                            uint64_t framesReceived,
+                            uint64_t framesDropped,
+                            unsigned long syncErrorBoundMicros)
+{
+    char comment[64];
+    snprintf(comment, sizeof(comment), "timebase synchronized within +/-%lu us", syncErrorBoundMicros);
+    captureWriteStatistics(output, framesReceived, framesDropped, comment);
+}
+
+static uint64_t getHostNanos(void)
+{
+    unsigned long long unixTime;
+    unsigned long micros;
+    SYSU_GetCurrentTime(&unixTime, &micros);
+    return (uint64_t)unixTime * 1000000000ULL + (uint64_t)micros * 1000ULL;
+}
+
+static uint32_t getHostMillis(void)
+{
+    unsigned long millis = 0;
+    SYSU_GetCurrentMillis(&millis);
+    return (uint32_t)millis;
+}
+
+/** Starts the timeline of a device at the time synchronization. */
+static void timelineInit(LocalTimelineType* timeline,
+                         const CapturinoTimeSyncType* sync)
+{
+    TSUW_Init(&timeline->unwrapper, sync->capturinoMicros, getHostMillis());
+    DRFT_Init(&timeline->drift,
+              sync->capturinoMicros,
+              (uint64_t)sync->hostUnixTime * 1000000000ULL + (uint64_t)sync->hostMicros * 1000ULL);
+    timeline->syncErrorBoundMicros = sync->errorBoundMicros;
+    timeline->latestMicros = sync->capturinoMicros;
+    timeline->timestampReceived = false;
+}
+
+/** Takes the host time before the received data is decoded. */
+static void timelineStartBatch(LocalTimelineType* timeline)
+{
+    timeline->rcvMillis = getHostMillis();
+    timeline->rcvHostNanos = getHostNanos();
+}
+
+/** Converts a timestamp of the decoded data to nanoseconds since the unix
+ * epoch. The timestamps must be passed in the order they have been received. */
+static uint64_t timelineToHostNanos(LocalTimelineType* timeline,
+                                    uint32_t timestampMicros)
+{
+    timeline->latestMicros = TSUW_Unwrap(&timeline->unwrapper, timestampMicros, timeline->rcvMillis);
+    timeline->timestampReceived = true;
+    return DRFT_ToHostNanos(&timeline->drift, timeline->latestMicros);
+}
+
+/** Feeds the latest timestamp of the decoded data to the drift estimation.
+ * The data has been received before the start of the batch, so the latest
+ * timestamp together with the host time taken then is a sample of the device
+ * clock. */
+static void timelineEndBatch(LocalTimelineType* timeline)
+{
+    if (timeline->timestampReceived == true)
+    {
+        DRFT_AddSample(&timeline->drift, timeline->latestMicros, timeline->rcvHostNanos);
+        timeline->timestampReceived = false;
+    }
+}
+
+/** CDEC_FrameCbType writing the decoded frame to the fifo. */
+static int onCaptureFrame(void* cbArg,
+                          uint32_t timestampMicros,
+                          const uint8_t* payload,
+                          size_t payloadLength)
+{
+    LocalCaptureContextType* context = (LocalCaptureContextType*)cbArg;
+    uint64_t timestampNanos = timelineToHostNanos(&context->timeline, timestampMicros);
+    DIAG_LogMsgArg(DIAG_VERBOSE, MODULE_NAME, __func__, "frame received. Length=%lu", (unsigned long)payloadLength);
+    context->framesReceived++;
+    if (captureDataFrameAt(context->output,
+                           context->dltValue,
+                           timestampNanos,
+                           payload,
+                           payloadLength) != 0)
+    {
+        context->framesDropped++;
+    }
+    return 0;
+}
+
+/** CDEC_NullFrameCbType, null frames are only used for resynchronisation. */
+static int onCaptureNullFrame(void* cbArg,
+                              uint32_t timestampMicros)
+{
+    timelineToHostNanos(&((LocalCaptureContextType*)cbArg)->timeline, timestampMicros);
+    return 0;
+}
+
+static int captureWithOpenFifoAndComm(const CaptureOutputType* output,
+                                      unsigned long dltValue,
+                                      int argc,
+                                      char *argv[])
+{
+    int fcnRt = 0;
+
+    CapturinoTimeSyncType sync;
+    fcnRt = startCapture(&mSession, dltValue, argc, argv, &sync);
+    if (fcnRt != 0)
+    {
+        return -1;
+    }
+    /* from now on the serial port is drained by the reader thread, so that a
+       blocking fifo does not stop the serial port from being read */
+    CRDR_ReaderType reader;
+    fcnRt = CRDR_Start(&reader, &mSession, mEventLoop);
+    if (fcnRt != 0)
+    {
+        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to start the reader thread!");
+        return -1;
+    }
+
+    int captureRv = 0;
+    LocalCaptureContextType context = {
+        .output = output,
+        .dltValue = dltValue,
+        .framesReceived = 0,
+        .framesDropped = 0
+    };
+    /* the timebase to print the current timestamp within wireshark is
+       corrected by the drift of the device clock during the capture */
+    timelineInit(&context.timeline, &sync);
+    CDEC_DecoderType decoder;
+    CDEC_Init(&decoder, onCaptureFrame, onCaptureNullFrame, &context);
+    
     while (mTerminateFlag == false)
     {
+        /* the received bytes are decoded in place within the queue of the
+           reader thread */
+        const uint8_t* rcvData = NULL;
         size_t bytesRead = 0;
-        char rcvChar;
-        fcnRt = CCON_Read(&rcvChar, 1, &bytesRead);
+        fcnRt = CRDR_GetReadSpan(&reader, &rcvData, &bytesRead);
         if (fcnRt != 0)
         {
             DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error reading from serial port!");
-            return -1;
+            captureRv = -1;
+            break;
         }
-        if (bytesRead > 0)
+        if (bytesRead == 0)
         {
-            DIAG_LogMsgArg(DIAG_DEBUG, MODULE_NAME, __func__, "Received char: 0x%02X", rcvChar);
-            if ((rcvChar == '\r') || (rcvChar == '\n'))
+            /* all received data has already been decoded, block until new
+               data arrives or the buffered packet records are due to be
+               written to the fifo */
+            unsigned long waitTimeoutMS;
+            if (PCAP_FlushIfDue(output->fifoPipe, &waitTimeoutMS) != 0)
             {
-                /* ignore new line characters \r and \n */
-                continue;
+                DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error writing to the fifo!");
+                captureRv = -1;
+                break;
             }
-            else if (rcvChar == 0x06)
+            if (waitTimeoutMS > IDLE_WAIT_TIMEOUT_MS)
             {
-                break;
+                waitTimeoutMS = IDLE_WAIT_TIMEOUT_MS;
             }
-            else
+            if (CRDR_WaitForData(&reader, waitTimeoutMS) != 0)
             {
-                DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "Expected to receive %02X, but received %02X", 0x06, rcvChar);
-                if (rcvChar == 'R')
-                {
-                    CNSL_WriteErr("The CAPTURino hardware is trying to communicate with a human, but I am a machine. Please flash the correct software to the CAPTURino hardware!",
-                            STATIC_STRLEN("The CAPTURino hardware is trying to communicate with a human, but I am a machine. Please flash the correct software to the CAPTURino hardware!"));
-                }
-                return -1;
+                DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error waiting for data from the reader thread!");
+                captureRv = -1;
+                break;
             }
+            continue;
         }
-        else
-        {
-            /* sleep for a little to avoid high CPU usage, but only if no character has been received */
-            SYSU_Sleep(1);
-        }
-    }
+        DIAG_LogMsgArg(DIAG_VERBOSE, MODULE_NAME, __func__, "Received %d chars", bytesRead);
 
-    size_t bytesToReceive = 0;
-    uint8_t rcvBuffer[512];
-    RingBufType buffer = {
-        .head = 0,
-        .tail = 0,
-        .elementSize = 1,
-        .buffer = rcvBuffer,
-        .bufferSize = 512
-    };
-    uint32_t captureTimestampMicros = 0;
-    uint32_t previousTimestampMicros = 0;
-    bool previousNullFrameWasAllNull = false;
-    
-    while (mTerminateFlag == false)
-    {
-        size_t bytesRead = 0;
-        fcnRt = CCON_Read(RingBuf_getHead(&buffer), RingBuf_getFreeElementsHead2End(&buffer), &bytesRead);
-        if (fcnRt != 0)
+        timelineStartBatch(&context.timeline);
+        fcnRt = CDEC_Feed(&decoder, rcvData, bytesRead);
+        CRDR_CommitRead(&reader, bytesRead);
+        timelineEndBatch(&context.timeline);
+        if (fcnRt != CDEC_OK)
         {
-            DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error reading from serial port!");
-            return -1;
+            if (fcnRt == CDEC_HARDWARE_ERROR)
+            {
+                CNSL_WriteErr("Internal error in the CAPTURino hardware. Capture process stopped!",
+                              STATIC_STRLEN("Internal error in the CAPTURino hardware. Capture process stopped!"));
+            }
+            /* instead of returning directly, leave the while loop so that the currently running command
+               on the embedded device is terminated */
+            mTerminateFlag = true;
         }
-        if (bytesRead > 0)
+        /* data arriving steadily must not hold back the buffered records */
+        if (PCAP_FlushIfDue(output->fifoPipe, NULL) != 0)
         {
-            DIAG_LogMsgArg(DIAG_VERBOSE, MODULE_NAME, __func__, "Received %d chars", bytesRead);
-            RingBuf_increaseHeadMore(&buffer, bytesRead);
-        }
-
-        size_t bufferElements = RingBuf_getElementsCount(&buffer);
-        switch (mCaptureState)
-        {
-            case CAPTURINO_STATE_RCV_HEADER_TIMESTAMP:
-                if (bufferElements >= 4)
-                {
-                    previousTimestampMicros = captureTimestampMicros;
-                    captureTimestampMicros = 0;
-                    for (size_t i=0; i<4; i++)
-                    {
-                        captureTimestampMicros <<= 8;
-                        captureTimestampMicros += *((uint8_t*)RingBuf_getTailOffset(&buffer, i));
-                    }
-                    RingBuf_increaseTailMore(&buffer, 4);
-                    mCaptureState = CAPTURINO_STATE_RCV_HEADER_PAYLOAD_LENGTH;
-                    if (captureTimestampMicros < previousTimestampMicros)
-                    {
-                        DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "embedded timestamp wrapped from %d to %d", previousTimestampMicros, captureTimestampMicros);
-                        const uint32_t secondsOffset = UINT32_MAX / 1000000;
-                        const uint32_t microsOffset = UINT32_MAX - secondsOffset*1000000; 
-                        capturinoCommonUpdateTimebase((unsigned long long)secondsOffset,
-                                                      (unsigned long)microsOffset);
-                    }
-                }
-                else
-                {
-                    SYSU_Sleep(1);
-                }
-                break;
-
-            case CAPTURINO_STATE_RCV_HEADER_PAYLOAD_LENGTH:
-                if (bufferElements >= 1)
-                {
-                    uint8_t tempByte;
-                    tempByte = *((uint8_t*)RingBuf_getTail(&buffer));
-                    if (tempByte >= 0x80)
-                    {
-                        /* MSB of PayloadLength1 is set, i.e. parts of the value are stored in PayloadLength2 */
-                        if (bufferElements >= 2)
-                        {
-                            bytesToReceive = (tempByte & 0x7F) << 8;
-                            bytesToReceive += *((uint8_t*)RingBuf_getTailOffset(&buffer, 5));
-                            DIAG_LogMsgArg(DIAG_VERBOSE, MODULE_NAME, __func__, "large frame received. Length=%d", bytesToReceive);
-                            RingBuf_increaseTailMore(&buffer, 2);
-                            mCaptureState = CAPTURINO_STATE_RCV_CONTENT;
-                        }
-                    }
-                    else if (tempByte > 0)
-                    {
-                        bytesToReceive = tempByte;
-                        DIAG_LogMsgArg(DIAG_VERBOSE, MODULE_NAME, __func__, "short frame received. Length=%d", bytesToReceive);
-                        RingBuf_increaseTail(&buffer);
-                        mCaptureState = CAPTURINO_STATE_RCV_CONTENT;
-                    }
-                    else /* null frame received (used for resynchronisation) */
-                    {
-                        RingBuf_increaseTail(&buffer);
-                        DIAG_LogMsg(DIAG_VERBOSE, MODULE_NAME, __func__, "Null frame received");
-                        if (captureTimestampMicros == 0)
-                        {
-                            if (previousNullFrameWasAllNull == true)
-                            {
-                                /* two consecutive null frames received, i.e. the CAPTURino hardware indicates an error */
-                                mTerminateFlag = true;
-                                CNSL_WriteErr("Internal error in the CAPTURino hardware. Capture process stopped!",
-                                              STATIC_STRLEN("Internal error in the CAPTURino hardware. Capture process stopped!"));
-                            }
-                            else 
-                            {
-                                previousNullFrameWasAllNull = true;
-                            }
-                        }
-                        else
-                        {
-                            previousNullFrameWasAllNull = false;
-                        }
-                        mCaptureState = CAPTURINO_STATE_RCV_HEADER_TIMESTAMP;
-                    }
-                }
-                break;
-
-            case CAPTURINO_STATE_RCV_CONTENT:
-                if (bufferElements >= bytesToReceive)
-                {
-                    /* write the received data to the fifo */
-                    captureDataFrame(fifoPipe,
-                                     dltValue,
-                                     captureTimestampMicros,
-                                     bytesToReceive,
-                                     &buffer);
-                    mCaptureState = CAPTURINO_STATE_RCV_HEADER_TIMESTAMP;
-                }
-                else if (bytesToReceive > 64) /* for now all values greater than 64 are malformed packets */
-                {
-                    DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "Capture failed due to a possibly malformed packet! bytesToReceive=%lu, limit was %lu", bytesToReceive, 64);
-                    /* instead of returning directly, leave the while loop so that the currently running command
-                       on the embedded device is terminated */
-                    mTerminateFlag = true;
-                }
-                break;
+            DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error writing to the fifo!");
+            captureRv = -1;
+            break;
         }
         /** \todo in case of no captured data is available for a certain amount
                   of time, the CAPTURino control board shall send a null frame,
@@ -334,15 +482,27 @@ static int captureWithOpenFifoAndComm(PipeHandleType fifoPipe,
                   also to resynchronize the transmitted timestamp */
     }
 
+    CRDR_Stop(&reader);
+
+    DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "%llu frames received, %llu frames dropped, clock skew %lld ppb",
+                   (unsigned long long)context.framesReceived, (unsigned long long)context.framesDropped,
+                   (long long)DRFT_GetSkewPpb(&context.timeline.drift));
+    writeStatistics(output, context.framesReceived, context.framesDropped, context.timeline.syncErrorBoundMicros);
+
+    /* write the records still held back in the write buffer */
+    PCAP_Flush(output->fifoPipe);
+
     /* terminate a possible running capture command */
     bool noTerminateFlag = false;
-    CCON_Exec("\x03", 1, 50, &noTerminateFlag);
+    CCON_Exec(&mSession, "\x03", 1, 50, &noTerminateFlag);
 
-    return 0;
+    return captureRv;
 }
 
-static int captureWithOpenFifo(PipeHandleType fifoPipe,
+static int captureWithOpenFifo(CaptureOutputType* output,
                                long baudrate,
+                               bool flowControl,
+                               SERH_LinkProfileType linkProfile,
                                char* comPort,
                                uint32_t dltValue,
                                int argc,
@@ -351,33 +511,407 @@ static int captureWithOpenFifo(PipeHandleType fifoPipe,
     int fcnRt = 0;
 
     /** \todo move this function call to a DLT specific capture function */
-    fcnRt = PCAP_WriteHeader(fifoPipe, false, 512, dltValue, 0, 0, 0);
+    fcnRt = captureWriteHeader(output, dltValue, 512, comPort);
     if (fcnRt != 0)
     {
         DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to write pcap header!");
         return -1;
     }
 
-    fcnRt = CCON_Open(comPort, baudrate);
+    fcnRt = CCON_Open(&mSession, comPort, baudrate);
     if (fcnRt != 0)
     {
         DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "Unable to open serial communication to CAPTURino!");
         return -1;
     }
     DIAG_LogMsg(DIAG_INFO, MODULE_NAME, __func__, "Opened communication to CAPTURino successfully");
+    if ((flowControl == true) && (CCON_SetHardwareFlowControl(&mSession, true) != 0))
+    {
+        CCON_Close(&mSession);
+        return -1;
+    }
+    CCON_SetLinkProfile(&mSession, linkProfile);
+
+    fcnRt = EVLP_Open(&mEventLoop);
+    if (fcnRt != 0)
+    {
+        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "Unable to create the event loop!");
+        CCON_Close(&mSession);
+        return -1;
+    }
     
-    fcnRt = captureWithOpenFifoAndComm(fifoPipe, dltValue, argc, argv);
+    fcnRt = captureWithOpenFifoAndComm(output, dltValue, argc, argv);
     if (fcnRt != 0)
     {
         DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "call to captureWithOpenFifoAndComm returned %d", fcnRt);
     }
 
+    EventLoopHandleType eventLoop = mEventLoop;
+    mEventLoop = INVALID_EVENTLOOP_HANDLE;
+    EVLP_Close(eventLoop);
+
     DIAG_LogMsg(DIAG_INFO, MODULE_NAME, __func__, "closing serial port");
-    CCON_Close();
+    CCON_Close(&mSession);
+
+    return 0;
+}
+
+/** CDEC_FrameCbType passing the decoded frame of a board to the merger. */
+static int onBoardFrame(void* cbArg,
+                        uint32_t timestampMicros,
+                        const uint8_t* payload,
+                        size_t payloadLength)
+{
+    LocalBoardType* board = (LocalBoardType*)cbArg;
+    board->framesReceived++;
+    if (CMRG_Push(&mMerger,
+                  board->index,
+                  timelineToHostNanos(&board->timeline, timestampMicros),
+                  payload,
+                  payloadLength) != 0)
+    {
+        board->framesDropped++;
+    }
+    return 0;
+}
+
+/** CDEC_NullFrameCbType, a null frame proves that the board will not deliver
+ * any older frame. */
+static int onBoardNullFrame(void* cbArg,
+                            uint32_t timestampMicros)
+{
+    LocalBoardType* board = (LocalBoardType*)cbArg;
+    CMRG_AdvanceSource(&mMerger, board->index, timelineToHostNanos(&board->timeline, timestampMicros));
+    return 0;
+}
+
+/** CMRG_EmitCbType writing the frames in timestamp order to the fifo. */
+static int onMergedFrame(void* cbArg,
+                         size_t source,
+                         const CMRG_FrameType* frame)
+{
+    (void)cbArg;
+    LocalBoardType* board = &mBoards[source];
+    if (captureDataFrameAt(&board->output,
+                           board->dltValue,
+                           frame->timestampNanos,
+                           frame->payload,
+                           frame->length) != 0)
+    {
+        board->framesDropped++;
+    }
+    return 0;
+}
 
+/** Parses the value of the --boards argument, a comma separated list of
+ * port:dlt pairs. The given string is split in place. */
+static int parseBoards(char* boardsArg,
+                       size_t* boardCount)
+{
+    *boardCount = 0;
+    char* entry = boardsArg;
+    while (entry != NULL)
+    {
+        char* nextEntry = strchr(entry, ',');
+        if (nextEntry != NULL)
+        {
+            *nextEntry = '\0';
+            nextEntry++;
+        }
+        /* the last colon separates the dlt, the port name may contain others */
+        char* dltString = strrchr(entry, ':');
+        if (dltString == NULL)
+        {
+            DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "missing dlt for board \'%s\'", entry);
+            return -1;
+        }
+        *dltString = '\0';
+        dltString++;
+        if (*boardCount == CMRG_MAX_SOURCES)
+        {
+            DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "at most %d boards can be captured at the same time", CMRG_MAX_SOURCES);
+            return -1;
+        }
+        char* endptr = NULL;
+        LocalBoardType* board = &mBoards[*boardCount];
+        board->comPort = entry;
+        board->dltValue = strtoul(dltString, &endptr, 10);
+        if ((endptr == dltString) || (*endptr != '\0'))
+        {
+            DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "invalid dlt \'%s\' for board \'%s\'", dltString, entry);
+            return -1;
+        }
+        (*boardCount)++;
+        entry = nextEntry;
+    }
     return 0;
 }
 
+/** Parses the value of the --linkprofile argument. */
+static int parseLinkProfile(const char* linkProfileArg,
+                            SERH_LinkProfileType* linkProfile)
+{
+    if (strcmp(linkProfileArg, "default") == 0)
+    {
+        *linkProfile = SERH_LINK_PROFILE_DEFAULT;
+        return 0;
+    }
+    if (strcmp(linkProfileArg, "latency") == 0)
+    {
+        *linkProfile = SERH_LINK_PROFILE_LATENCY;
+        return 0;
+    }
+    if (strcmp(linkProfileArg, "throughput") == 0)
+    {
+        *linkProfile = SERH_LINK_PROFILE_THROUGHPUT;
+        return 0;
+    }
+    DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "unknown link profile \'%s\'", linkProfileArg);
+    return -1;
+}
+
+/** Parses the value of the --flowcontrol argument. */
+static int parseFlowControl(const char* flowControlArg,
+                            bool* flowControl)
+{
+    if (strcmp(flowControlArg, "none") == 0)
+    {
+        *flowControl = false;
+        return 0;
+    }
+    if (strcmp(flowControlArg, "rtscts") == 0)
+    {
+        *flowControl = true;
+        return 0;
+    }
+    DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "unknown flow control \'%s\'", flowControlArg);
+    return -1;
+}
+
+/** Capture loop of all started boards. The frames are passed through the
+ * merger, which writes them in timestamp order. A board is only decoded as
+ * long as the merger can hold its frames, otherwise the data stays within
+ * the queue of its reader until the other boards caught up. */
+static int captureBoards(size_t boardCount,
+                         PipeHandleType fifoPipe)
+{
+    int captureRv = 0;
+    while (mTerminateFlag == false)
+    {
+        bool dataReceived = false;
+        for (size_t i=0; i<boardCount; i++)
+        {
+            LocalBoardType* board = &mBoards[i];
+            const uint8_t* rcvData = NULL;
+            size_t bytesRead = 0;
+            if (CRDR_GetReadSpan(&board->reader, &rcvData, &bytesRead) != 0)
+            {
+                DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "error reading from serial port %s!", board->comPort);
+                return -1;
+            }
+            size_t maxBytes = CMRG_GetFreeSlots(&mMerger, i) * CDEC_MIN_PAYLOAD_FRAME_LENGTH;
+            if (bytesRead > maxBytes)
+            {
+                bytesRead = maxBytes;
+            }
+            if (bytesRead == 0)
+            {
+                continue;
+            }
+            dataReceived = true;
+            timelineStartBatch(&board->timeline);
+            int fcnRt = CDEC_Feed(&board->decoder, rcvData, bytesRead);
+            CRDR_CommitRead(&board->reader, bytesRead);
+            timelineEndBatch(&board->timeline);
+            if (fcnRt != CDEC_OK)
+            {
+                DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "decoding the data of %s failed with %d", board->comPort, fcnRt);
+                if (fcnRt == CDEC_HARDWARE_ERROR)
+                {
+                    CNSL_WriteErr("Internal error in the CAPTURino hardware. Capture process stopped!",
+                                  STATIC_STRLEN("Internal error in the CAPTURino hardware. Capture process stopped!"));
+                }
+                mTerminateFlag = true;
+            }
+        }
+
+        uint64_t nowNanos = getHostNanos();
+        uint64_t nextDueNanos = CMRG_NOTHING_DUE;
+        CMRG_Emit(&mMerger, nowNanos, &nextDueNanos);
+
+        unsigned long waitTimeoutMS;
+        if (PCAP_FlushIfDue(fifoPipe, &waitTimeoutMS) != 0)
+        {
+            DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error writing to the fifo!");
+            captureRv = -1;
+            break;
+        }
+        if (dataReceived == true)
+        {
+            continue;
+        }
+
+        /* block until new data arrives, the oldest frame held back by the
+           merger or the buffered packet records are due */
+        if (nextDueNanos != CMRG_NOTHING_DUE)
+        {
+            uint64_t mergerWaitMS = (nextDueNanos > nowNanos) ? ((nextDueNanos - nowNanos + 999999) / 1000000) : 0;
+            if (mergerWaitMS < waitTimeoutMS)
+            {
+                waitTimeoutMS = (unsigned long)mergerWaitMS;
+            }
+        }
+        if (waitTimeoutMS > IDLE_WAIT_TIMEOUT_MS)
+        {
+            waitTimeoutMS = IDLE_WAIT_TIMEOUT_MS;
+        }
+        /* all readers wake up the same event loop. Data held back for a
+           full merger queue must not end the wait early, thus the readers'
+           queues are not checked */
+        EVLP_WaitResultType waitResult;
+        if (EVLP_Wait(mEventLoop, waitTimeoutMS, &waitResult) != 0)
+        {
+            DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error waiting for data from the reader threads!");
+            captureRv = -1;
+            break;
+        }
+    }
+    return captureRv;
+}
+
+/** Captures several boards at once into a single pcapng stream with an
+ * interface per board. */
+static int captureMultipleBoardsWithOpenFifo(const CaptureOutputType* output,
+                                             long baudrate,
+                                             bool flowControl,
+                                             SERH_LinkProfileType linkProfile,
+                                             size_t boardCount,
+                                             unsigned long reorderWindowMS,
+                                             int argc,
+                                             char *argv[])
+{
+    int fcnRt = 0;
+
+    for (size_t i=0; i<boardCount; i++)
+    {
+        LocalBoardType* board = &mBoards[i];
+        board->output = *output;
+        board->index = i;
+        board->framesReceived = 0;
+        board->framesDropped = 0;
+        board->readerStarted = false;
+        board->session = (CCON_SessionType)CCON_SESSION_INITIALIZER;
+        /* the first interface comes along with the section header */
+        fcnRt = (i == 0) ? captureWriteHeader(&board->output, board->dltValue, 512, board->comPort)
+                         : captureAddInterface(&board->output, board->dltValue, 512, board->comPort);
+        if (fcnRt != 0)
+        {
+            DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to write pcapng header!");
+            return -1;
+        }
+    }
+
+    if (CMRG_Init(&mMerger, boardCount, (uint64_t)reorderWindowMS * 1000000ULL, onMergedFrame, NULL) != 0)
+    {
+        return -1;
+    }
+
+    fcnRt = EVLP_Open(&mEventLoop);
+    if (fcnRt != 0)
+    {
+        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "Unable to create the event loop!");
+        return -1;
+    }
+
+    int captureRv = 0;
+    size_t openedBoards = 0;
+    for (; (openedBoards < boardCount) && (mTerminateFlag == false); openedBoards++)
+    {
+        LocalBoardType* board = &mBoards[openedBoards];
+        fcnRt = CCON_Open(&board->session, board->comPort, baudrate);
+        if (fcnRt != 0)
+        {
+            DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "Unable to open serial communication to CAPTURino at %s!", board->comPort);
+            captureRv = -1;
+            break;
+        }
+        DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "Opened communication to CAPTURino at %s successfully", board->comPort);
+        if ((flowControl == true) && (CCON_SetHardwareFlowControl(&board->session, true) != 0))
+        {
+            CCON_Close(&board->session);
+            captureRv = -1;
+            break;
+        }
+        CCON_SetLinkProfile(&board->session, linkProfile);
+
+        CapturinoTimeSyncType sync;
+        fcnRt = startCapture(&board->session, board->dltValue, argc, argv, &sync);
+        if (fcnRt != 0)
+        {
+            DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to start the capture process at %s!", board->comPort);
+            openedBoards++;
+            captureRv = -1;
+            break;
+        }
+        timelineInit(&board->timeline, &sync);
+        CDEC_Init(&board->decoder, onBoardFrame, onBoardNullFrame, board);
+
+        /* the boards started before are drained by their reader threads in
+           the meantime */
+        fcnRt = CRDR_Start(&board->reader, &board->session, mEventLoop);
+        if (fcnRt != 0)
+        {
+            DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to start the reader thread!");
+            openedBoards++;
+            captureRv = -1;
+            break;
+        }
+        board->readerStarted = true;
+    }
+
+    if ((captureRv == 0) && (openedBoards == boardCount))
+    {
+        captureRv = captureBoards(boardCount, output->fifoPipe);
+    }
+
+    /* everything received has been passed to the merger, release the frames
+       still held back */
+    CMRG_Drain(&mMerger);
+    if (mMerger.framesOutOfOrder > 0)
+    {
+        DIAG_LogMsgArg(DIAG_WARNING, MODULE_NAME, __func__, "%llu frames arrived too late to be written in timestamp order. Consider increasing the reorder window",
+                       (unsigned long long)mMerger.framesOutOfOrder);
+    }
+
+    for (size_t i=0; i<openedBoards; i++)
+    {
+        LocalBoardType* board = &mBoards[i];
+        if (board->readerStarted == true)
+        {
+            CRDR_Stop(&board->reader);
+        }
+        DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "%s: %llu frames received, %llu frames dropped, clock skew %lld ppb", board->comPort,
+                       (unsigned long long)board->framesReceived, (unsigned long long)board->framesDropped,
+                       (long long)DRFT_GetSkewPpb(&board->timeline.drift));
+        writeStatistics(&board->output, board->framesReceived, board->framesDropped, board->timeline.syncErrorBoundMicros);
+
+        /* terminate a possible running capture command */
+        bool noTerminateFlag = false;
+        CCON_Exec(&board->session, "\x03", 1, 50, &noTerminateFlag);
+        DIAG_LogMsgArg(DIAG_INFO, MODULE_NAME, __func__, "closing serial port %s", board->comPort);
+        CCON_Close(&board->session);
+    }
+
+    /* write the records still held back in the write buffer */
+    PCAP_Flush(output->fifoPipe);
+
+    EventLoopHandleType eventLoop = mEventLoop;
+    mEventLoop = INVALID_EVENTLOOP_HANDLE;
+    EVLP_Close(eventLoop);
+
+    return captureRv;
+}
+
 static int capturinoExtcapDlts(int argc, char *argv[])
 {
     DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
@@ -409,13 +943,83 @@ static int capturinoExtcapCapture(int argc, char *argv[])
     long baudrate = -1;
     fcnRt  = ARGP_getLongOfArgs(argc, argv, "--baudrate", &baudrate);
 
-    char* comPort = NULL;
-    fcnRt += ARGP_getP2StringOfArgs(argc, argv, "--port", &comPort);
+    /* optional argument, captures several boards instead of the one given
+       by --port and --dlts */
+    char* boardsArg = NULL;
+    size_t boardCount = 0;
+    if ((ARGP_getP2StringOfArgs(argc, argv, "--boards", &boardsArg) == 0) && (boardsArg[0] != '\0'))
+    {
+        fcnRt += parseBoards(boardsArg, &boardCount);
+    }
+
+    unsigned long reorderWindowMS = CMRG_DEFAULT_REORDER_WINDOW_MS;
+    if (ARGP_getUnsignedLongOfArgs(argc, argv, "--reorderwindow", &reorderWindowMS) != 0)
+    {
+        reorderWindowMS = CMRG_DEFAULT_REORDER_WINDOW_MS;
+    }
 
+    char* comPort = "";
     unsigned long dltValue = 0;
-    fcnRt += ARGP_getUnsignedLongOfArgs(argc, argv, "--dlts", &dltValue);
+    if (boardCount == 0)
+    {
+        fcnRt += ARGP_getP2StringOfArgs(argc, argv, "--port", &comPort);
+        fcnRt += ARGP_getUnsignedLongOfArgs(argc, argv, "--dlts", &dltValue);
+    }
 
-    fcnRt += capturinoCommonValidateParameters(comPort, baudrate, fifopath, dltValue);
+    /* optional argument, the default latency is used if not specified */
+    unsigned long flushLatencyMS = PCAP_DEFAULT_FLUSH_LATENCY_MS;
+    if (ARGP_getUnsignedLongOfArgs(argc, argv, "--flushlatency", &flushLatencyMS) != 0)
+    {
+        flushLatencyMS = PCAP_DEFAULT_FLUSH_LATENCY_MS;
+    }
+    PCAP_SetFlushLatency(flushLatencyMS);
+
+    /* optional argument, classic pcap is written if not specified */
+    CaptureOutputType output = {
+        .fifoPipe = 0,
+        .format = CAPT_FORMAT_PCAP,
+        .interfaceId = 0
+    };
+    char* formatArg = NULL;
+    if (ARGP_getP2StringOfArgs(argc, argv, "--format", &formatArg) == 0)
+    {
+        fcnRt += captureParseFormat(formatArg, &output.format);
+    }
+
+    /* optional argument, the converter is tuned for low latency if not
+       specified */
+    SERH_LinkProfileType linkProfile = SERH_LINK_PROFILE_LATENCY;
+    char* linkProfileArg = NULL;
+    if (ARGP_getP2StringOfArgs(argc, argv, "--linkprofile", &linkProfileArg) == 0)
+    {
+        fcnRt += parseLinkProfile(linkProfileArg, &linkProfile);
+    }
+
+    /* optional argument, no flow control is used if not specified */
+    bool flowControl = false;
+    char* flowControlArg = NULL;
+    if (ARGP_getP2StringOfArgs(argc, argv, "--flowcontrol", &flowControlArg) == 0)
+    {
+        fcnRt += parseFlowControl(flowControlArg, &flowControl);
+    }
+
+    if (boardCount == 0)
+    {
+        fcnRt += capturinoCommonValidateParameters(comPort, baudrate, fifopath, dltValue);
+    }
+    else
+    {
+        for (size_t i=0; i<boardCount; i++)
+        {
+            fcnRt += capturinoCommonValidateParameters(mBoards[i].comPort, baudrate, fifopath, mBoards[i].dltValue);
+        }
+        /* the pcap format knows a single interface only */
+        if (output.format != CAPT_FORMAT_PCAPNG)
+        {
+            DIAG_LogMsg(DIAG_WARNING, MODULE_NAME, __func__, "capturing several boards requires the pcapng format, which is used instead");
+            output.format = CAPT_FORMAT_PCAPNG;
+        }
+    }
     if (fcnRt == 0)
     {
         DIAG_LogMsgArg(DIAG_DEBUG, MODULE_NAME, __func__, "parsed arguments: baudrate=%ld, comPort=%s, fifoPath=%s, dltValue=%lu",
@@ -437,12 +1041,29 @@ static int capturinoExtcapCapture(int argc, char *argv[])
         return -1;
     }
     
-    fcnRt = captureWithOpenFifo(fifoPipe,
-                                baudrate,
-                                comPort,
-                                dltValue,
-                                argc,
-                                argv);
+    output.fifoPipe = fifoPipe;
+    if (boardCount == 0)
+    {
+        fcnRt = captureWithOpenFifo(&output,
+                                    baudrate,
+                                    flowControl,
+                                    linkProfile,
+                                    comPort,
+                                    dltValue,
+                                    argc,
+                                    argv);
+    }
+    else
+    {
+        fcnRt = captureMultipleBoardsWithOpenFifo(&output,
+                                                  baudrate,
+                                                  flowControl,
+                                                  linkProfile,
+                                                  boardCount,
+                                                  reorderWindowMS,
+                                                  argc,
+                                                  argv);
+    }
 
     if (fcnRt != 0)
     {
@@ -467,6 +1088,8 @@ static int capturinoExtcapTerminateCb()
 {
     DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
     mTerminateFlag = true;
+    /* unblock a possibly waiting capture loop */
+    EVLP_Wakeup(mEventLoop);
     return 0;
 }
 
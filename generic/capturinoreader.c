@@ -0,0 +1,274 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup capturinoreader
+ * \brief Module draining the serial connection to the CAPTURino device within
+ *        a dedicated thread.
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "capturinoconn.h"
+#include "diagnosis.h"
+#include "eventloop.h"
+#include "spscqueue.h"
+#include "systemutils.h"
+#include "threading.h"
+
+/* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
+#include "capturinoreader.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+/** maximum time the reader thread blocks on the serial port */
+#define READER_IDLE_TIMEOUT_MS      (500)
+/** time to wait for the consumer to free space in the full queue */
+#define READER_QUEUE_FULL_WAIT_MS   (1)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
+
+/* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
+static const char* MODULE_NAME = "CRDR";
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * * */
+
+/* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static int allocQueue(CRDR_ReaderType* reader)
+{
+    if (SYSU_AllocMirrored(CRDR_QUEUE_SIZE, &reader->queueStorage) == 0)
+    {
+        reader->queueStorageIsMirrored = true;
+        return SPSC_initMirrored(&reader->queue, reader->queueStorage, CRDR_QUEUE_SIZE);
+    }
+
+    /* still works, but frames wrapping around the end of the storage must be
+       assembled by the decoder */
+    DIAG_LogMsg(DIAG_WARNING, MODULE_NAME, __func__, "mirrored memory not available, falling back to a plain queue");
+    reader->queueStorageIsMirrored = false;
+    reader->queueStorage = malloc(CRDR_QUEUE_SIZE);
+    if (reader->queueStorage == NULL)
+    {
+        return -1;
+    }
+    return SPSC_init(&reader->queue, reader->queueStorage, CRDR_QUEUE_SIZE);
+}
+
+static void freeQueue(CRDR_ReaderType* reader)
+{
+    if (reader->queueStorageIsMirrored == true)
+    {
+        SYSU_FreeMirrored(reader->queueStorage, CRDR_QUEUE_SIZE);
+    }
+    else
+    {
+        free(reader->queueStorage);
+    }
+    reader->queueStorage = NULL;
+}
+
+static int readerThread(void* arg)
+{
+    CRDR_ReaderType* reader = (CRDR_ReaderType*)arg;
+    bool queueFullReported = false;
+
+    while (atomic_load(&reader->stopRequested) == false)
+    {
+        void* span;
+        size_t spanLen = SPSC_getWriteSpan(&reader->queue, &span);
+        if (spanLen == 0)
+        {
+            /* the consumer is stalled, e.g. by the Wireshark fifo. The
+               serial port is not drained until space is available again */
+            if (queueFullReported == false)
+            {
+                DIAG_LogMsg(DIAG_WARNING, MODULE_NAME, __func__, "queue is full, serial data might get lost!");
+                queueFullReported = true;
+            }
+            EVLP_WaitResultType waitResult;
+            EVLP_Wait(reader->readerEventLoop, READER_QUEUE_FULL_WAIT_MS, &waitResult);
+            continue;
+        }
+        queueFullReported = false;
+
+        size_t bytesRead = 0;
+        if (CCON_Read(reader->session, span, spanLen, &bytesRead) != 0)
+        {
+            DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error reading from serial port!");
+            atomic_store(&reader->readerFailed, true);
+            EVLP_Wakeup(reader->consumerEventLoop);
+            return -1;
+        }
+
+        if (bytesRead > 0)
+        {
+            SPSC_commitWrite(&reader->queue, bytesRead);
+            EVLP_Wakeup(reader->consumerEventLoop);
+        }
+        else
+        {
+            EVLP_WaitResultType waitResult;
+            if (CCON_WaitForData(reader->session, reader->readerEventLoop, READER_IDLE_TIMEOUT_MS, &waitResult) != 0)
+            {
+                DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error waiting for data from serial port!");
+                atomic_store(&reader->readerFailed, true);
+                EVLP_Wakeup(reader->consumerEventLoop);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int CRDR_Start(CRDR_ReaderType*    reader,
+               CCON_SessionType*   session,
+               EventLoopHandleType consumerEventLoop)
+{
+    DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
+
+    if (allocQueue(reader) != 0)
+    {
+        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to allocate memory for the queue");
+        return -1;
+    }
+    atomic_init(&reader->stopRequested, false);
+    atomic_init(&reader->readerFailed, false);
+    reader->session = session;
+    reader->consumerEventLoop = consumerEventLoop;
+
+    if (EVLP_Open(&reader->readerEventLoop) != 0)
+    {
+        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to create the event loop of the reader thread");
+        freeQueue(reader);
+        return -1;
+    }
+
+    if (THRD_Create(&reader->thread, readerThread, reader) != 0)
+    {
+        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to create the reader thread");
+        EVLP_Close(reader->readerEventLoop);
+        freeQueue(reader);
+        return -1;
+    }
+    return 0;
+}
+
+int CRDR_GetReadSpan(CRDR_ReaderType* reader,
+                     const uint8_t**  span,
+                     size_t*          spanLen)
+{
+    const void* queueSpan;
+    *spanLen = SPSC_getReadSpan(&reader->queue, &queueSpan);
+    *span = (const uint8_t*)queueSpan;
+    if (   (*spanLen == 0)
+        && (atomic_load(&reader->readerFailed) == true)
+        && (SPSC_getCount(&reader->queue) == 0))
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int CRDR_CommitRead(CRDR_ReaderType* reader,
+                    size_t           count)
+{
+    return SPSC_commitRead(&reader->queue, count);
+}
+
+int CRDR_WaitForData(CRDR_ReaderType* reader,
+                     unsigned long    timeoutMS)
+{
+    if (   (SPSC_getCount(&reader->queue) > 0)
+        || (atomic_load(&reader->readerFailed) == true))
+    {
+        return 0;
+    }
+
+    EVLP_WaitResultType waitResult;
+    return EVLP_Wait(reader->consumerEventLoop, timeoutMS, &waitResult);
+}
+
+int CRDR_Stop(CRDR_ReaderType* reader)
+{
+    DIAG_LogMsg(DIAG_DEBUG, MODULE_NAME, __func__, "function entered");
+
+    atomic_store(&reader->stopRequested, true);
+    EVLP_Wakeup(reader->readerEventLoop);
+
+    int threadRv = 0;
+    int rv = THRD_Join(reader->thread, &threadRv);
+    if ((rv == 0) && (threadRv != 0))
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "reader thread returned %d", threadRv);
+    }
+
+    EVLP_Close(reader->readerEventLoop);
+    freeQueue(reader);
+    return rv;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
@@ -0,0 +1,193 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup capturinoreader
+ * \brief Module draining the serial connection to the CAPTURino device within
+ *        a dedicated thread.
+ *
+ * The reader thread only copies the received bytes into a lock-free queue, so
+ * that a consumer blocked by the Wireshark fifo does not stop the serial port
+ * from being drained. The storage of the queue is mapped twice whenever the
+ * platform supports it, so that the serial port is read into all free space
+ * at once and the consumer decodes all received bytes in place.
+ *
+ * @{
+ */
+/* ************************************************************************* */
+
+#ifndef CAPTURINOREADER_H_INCLUDED
+#define CAPTURINOREADER_H_INCLUDED
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "capturinoconn.h"
+#include "eventloop.h"
+#include "spscqueue.h"
+#include "threading.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+/** size of the queue between the reader and the consumer thread. Must be a
+    power of two and a multiple of SYSU_GetMirrorGranularity(). 1 MiB holds
+    several seconds of data at 3 MBaud. */
+#define CRDR_QUEUE_SIZE     (1UL << 20)
+
+/* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * */
+typedef struct
+{
+    SpscQueueType       queue;              /**< received bytes, produced by
+                                                 the reader thread */
+    void*               queueStorage;
+    bool                queueStorageIsMirrored;
+    CCON_SessionType*   session;            /**< connection drained by the
+                                                 reader thread */
+    EventLoopHandleType readerEventLoop;    /**< used by the reader thread to
+                                                 wait for the serial port */
+    EventLoopHandleType consumerEventLoop;  /**< woken up whenever new data
+                                                 has been queued */
+    ThreadHandleType    thread;
+    atomic_bool         stopRequested;
+    atomic_bool         readerFailed;
+} CRDR_ReaderType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E C L A R A T I O N S * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * */
+/** Starts the reader thread draining an opened CAPTURino connection.
+ *
+ * \warning As long as the reader thread is running, no other function of the
+ *          capturinoconn module must read from the connection.
+ *
+ * \param[out] reader the reader instance to be started.
+ * \param[in] session the connection to be drained. Must stay valid until
+ *                    the reader is stopped.
+ * \param[in] consumerEventLoop event loop of the consumer, which is woken up
+ *                              whenever new data has been queued.
+ *
+ * \returns 0: if the reader thread has been started successfully.
+ * \returns -1: if the function failed.
+ */
+int CRDR_Start      (CRDR_ReaderType*    reader,
+                     CCON_SessionType*   session,
+                     EventLoopHandleType consumerEventLoop);
+
+/** Retrieves the data received by the reader thread without copying it. The
+ * data stays valid until it is released by CRDR_CommitRead().
+ *
+ * \param[in] reader the reader instance to read from.
+ * \param[out] span the start of the received data.
+ * \param[out] spanLen number of bytes available at span. If the storage of
+ *                     the queue is mirrored, these are all received bytes.
+ *
+ * \returns 0: if data is available or no data is available.
+ * \returns -1: if the reader thread failed and all data has been read.
+ */
+int CRDR_GetReadSpan(CRDR_ReaderType*    reader,
+                     const uint8_t**     span,
+                     size_t*             spanLen);
+
+/** Releases data retrieved by CRDR_GetReadSpan() to the reader thread.
+ *
+ * \param[in] reader the reader instance read from.
+ * \param[in] count number of bytes processed.
+ *
+ * \returns 0: if the data has been released.
+ * \returns -1: if count exceeds the number of received bytes.
+ */
+int CRDR_CommitRead (CRDR_ReaderType*    reader,
+                     size_t              count);
+
+/** Blocks until data from the reader thread is available, the consumer event
+ * loop is woken up or the timeout expires.
+ *
+ * \param[in] reader the reader instance to wait for.
+ * \param[in] timeoutMS timeout in milliseconds.
+ *
+ * \returns 0: if the wait operation was successful.
+ * \returns -1: if the function failed.
+ */
+int CRDR_WaitForData(CRDR_ReaderType*    reader,
+                     unsigned long       timeoutMS);
+
+/** Stops the reader thread and releases all resources of the reader.
+ *
+ * \param[in] reader the reader instance to be stopped.
+ *
+ * \returns 0: if the reader thread has been stopped successfully.
+ * \returns -1: if the function failed.
+ */
+int CRDR_Stop       (CRDR_ReaderType*    reader);
+
+/* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAPTURINOREADER_H_INCLUDED */
+
+/**
+ * @}
+ */
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
@@ -32,10 +32,12 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
 #include "capturinoconn.h"
+#include "capturinodecoder.h"
 #include "console.h"
 #include "diagnosis.h"
 #include "genericutils.h"
@@ -45,7 +47,6 @@
 #include "serialhandling.h"
 #include "systemutils.h"
 #include "capturinocommonintfcfuncs.h"
-#include "ringbuf.h"
 
 /* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
 #include "capturinotestintfc.h"
@@ -55,6 +56,8 @@
  *************************************************************************** */
 
 /* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+/** number of bytes read from the serial port at once */
+#define RCV_CHUNK_SIZE          (256)
 
 /* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
 
@@ -70,6 +73,7 @@
 
 /* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
 static volatile bool mTerminateFlag = false;
+static CCON_SessionType mSession = CCON_SESSION_INITIALIZER;
 
 /* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
 static const char* MODULE_NAME = "CAPT_TEST";
@@ -110,6 +114,35 @@ const EXMG_IntfcType capturinoTestIntfc =
 /* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
 
 /* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+/** CDEC_FrameCbType reporting every received frame as debug message. */
+static int onDebugFrame(void* cbArg,
+                        uint32_t timestampMicros,
+                        const uint8_t* payload,
+                        size_t payloadLength)
+{
+    DIAG_LogMsgArg(DIAG_VERBOSE, MODULE_NAME, __func__, "frame received. Timestamp=%lu, Length=%lu", (unsigned long)timestampMicros, (unsigned long)payloadLength);
+    /* the message shows the first bytes of the payload */
+    char debugMsg[128];
+    int msgLength = snprintf(debugMsg, sizeof(debugMsg), "Frame received at %lu us, %lu bytes:",
+                             (unsigned long)timestampMicros, (unsigned long)payloadLength);
+    for (size_t i=0; (i<payloadLength) && (i<8) && (msgLength > 0) && ((size_t)msgLength < sizeof(debugMsg)); i++)
+    {
+        msgLength += snprintf(&debugMsg[msgLength], sizeof(debugMsg) - (size_t)msgLength, " %02X", payload[i]);
+    }
+    PCAP_147_CapturinoDebug_writeDebugMsg(*((PipeHandleType*)cbArg), debugMsg);
+    return 0;
+}
+
+/** CDEC_NullFrameCbType reporting every received null frame as debug message. */
+static int onDebugNullFrame(void* cbArg,
+                            uint32_t timestampMicros)
+{
+    char debugMsg[64];
+    snprintf(debugMsg, sizeof(debugMsg), "Null frame received at %lu us", (unsigned long)timestampMicros);
+    PCAP_147_CapturinoDebug_writeDebugMsg(*((PipeHandleType*)cbArg), debugMsg);
+    return 0;
+}
+
 static int captureWithOpenFifoAndComm(PipeHandleType fifoPipe,
                                       unsigned long dltValue,
                                       int argc,
@@ -117,7 +150,7 @@ static int captureWithOpenFifoAndComm(PipeHandleType fifoPipe,
 {
     int fcnRt = 0;
 
-    fcnRt = CCON_InitiateSession(5000, &mTerminateFlag);
+    fcnRt = CCON_InitiateSession(&mSession, 5000, &mTerminateFlag);
     if (fcnRt != 0)
     {
         DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "error waiting for CAPTURino response! Return value=%d", fcnRt);
@@ -127,22 +160,19 @@ static int captureWithOpenFifoAndComm(PipeHandleType fifoPipe,
     DIAG_LogMsg(DIAG_INFO, MODULE_NAME, __func__, "connected to CAPTURino ...");
     PCAP_147_CapturinoDebug_writeDebugMsg(fifoPipe, "CLI on CAPTURino started successfully");
     
-    /* get current time from the system ... */
-    unsigned long long hostUnixTime = 0;
-    unsigned long hostMicros = 0;
-    SYSU_GetCurrentTime(&hostUnixTime, &hostMicros);
-    /* ... get current millis from the device ... */
-    uint32_t capturinoMicros = 0;
-    fcnRt = CCON_GetBoardMicros(500, &mTerminateFlag, &capturinoMicros);
+    /* synchronize the time of the device with the system ... */
+    CapturinoTimeSyncType sync;
+    fcnRt = capturinoCommonSyncTime(&mSession, 500, &mTerminateFlag, &sync);
     if (fcnRt != 0)
     {
-        DIAG_LogMsgArg(DIAG_FAILURE, MODULE_NAME, __func__, "error waiting for CAPTURino response! Return value=%d", fcnRt);
+        DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "unable to synchronize the time of the CAPTURino device!");
         return -1;
     }
-    /* ... and calculate the base time to print the current timestamp within
-       wireshark */
-    capturinoCommonSetTimebase(hostUnixTime, hostMicros, capturinoMicros);
-    PCAP_147_CapturinoDebug_writeDebugMsg(fifoPipe, "Time offset calculated successfully");
+    /* ... and report its accuracy. The debug messages show the timestamps of
+       the device */
+    char syncMsg[64];
+    snprintf(syncMsg, sizeof(syncMsg), "Time offset calculated within +/-%lu us", sync.errorBoundMicros);
+    PCAP_147_CapturinoDebug_writeDebugMsg(fifoPipe, syncMsg);
 
     /** \warning the command length must not be greater than the CLI_INPUT_BUFFER_SIZE
      *           of the embedded software */
@@ -155,7 +185,7 @@ static int captureWithOpenFifoAndComm(PipeHandleType fifoPipe,
         return -1;
     }
 
-    fcnRt = CCON_Exec(captureCmd, cmdLen, 200, &mTerminateFlag);
+    fcnRt = CCON_Exec(&mSession, captureCmd, cmdLen, 200, &mTerminateFlag);
     if (fcnRt != 0)
     {
         DIAG_LogMsg(DIAG_FAILURE, MODULE_NAME, __func__, "error sending capture command!");
@@ -171,7 +201,7 @@ static int captureWithOpenFifoAndComm(PipeHandleType fifoPipe,
     {
         size_t bytesRead = 0;
         char rcvChar;
-        fcnRt = CCON_Read(&rcvChar, 1, &bytesRead);
+        fcnRt = CCON_Read(&mSession, &rcvChar, 1, &bytesRead);
         if (bytesRead > 0)
         {
             DIAG_LogMsgArg(DIAG_DEBUG, MODULE_NAME, __func__, "Received char: \'%c\'", rcvChar);
@@ -198,83 +228,38 @@ static int captureWithOpenFifoAndComm(PipeHandleType fifoPipe,
         }
     }
 
-    size_t bytesToReceive = 0;
-    char rcvBuffer[256];
-    RingBufType buffer = {
-        .head = 0,
-        .tail = 0,
-        .elementSize = 1,
-        .buffer = rcvBuffer,
-        .bufferSize = 256
-    };
+    int captureRv = 0;
+    uint8_t rcvBuffer[RCV_CHUNK_SIZE];
+    CDEC_DecoderType decoder;
+    CDEC_Init(&decoder, onDebugFrame, onDebugNullFrame, &fifoPipe);
 
     PCAP_147_CapturinoDebug_writeDebugMsg(fifoPipe, "Waiting for message frames ...");
     while (mTerminateFlag == false)
     {
         size_t bytesRead = 0;
-        fcnRt = CCON_Read(RingBuf_getHead(&buffer), RingBuf_getFreeElementsHead2End(&buffer), &bytesRead);
-        if (bytesRead > 0)
+        fcnRt = CCON_Read(&mSession, (char*)rcvBuffer, RCV_CHUNK_SIZE, &bytesRead);
+        if (bytesRead == 0)
         {
-            DIAG_LogMsgArg(DIAG_DEBUG, MODULE_NAME, __func__, "Received %d chars", bytesRead);
+            /* sleep for a little to avoid high CPU usage, but only if no character has been received */
+            SYSU_Sleep(1);
+            continue;
         }
-        RingBuf_increaseHeadMore(&buffer, bytesRead);
-        size_t bufferElements = RingBuf_getElementsCount(&buffer);
-        if (bytesToReceive == 0)
+        DIAG_LogMsgArg(DIAG_DEBUG, MODULE_NAME, __func__, "Received %d chars", bytesRead);
+
+        fcnRt = CDEC_Feed(&decoder, rcvBuffer, bytesRead);
+        if (fcnRt != CDEC_OK)
         {
-            if (bufferElements >= 5)
+            if (fcnRt == CDEC_HARDWARE_ERROR)
             {
-                DIAG_LogMsgArg(DIAG_VERBOSE, MODULE_NAME, __func__, "buffer has %d elements", bufferElements);
-                /* extract timestamp */
-                uint32_t timestamp = 0;
-                uint8_t tempByte;
-                for (size_t i=0; i<4; i++)
-                {
-                    tempByte = *((uint8_t*)RingBuf_getTailOffset(&buffer, i));
-                    timestamp <<= 8;
-                    timestamp += tempByte;
-                }
-                tempByte = *((uint8_t*)RingBuf_getTailOffset(&buffer, 4));
-                if (tempByte >= 0x80)
-                {
-                    /* MSB of PayloadLength1 is set, i.e. parts of the value are stored in PayloadLength2 */
-                    if (bufferElements >= 6)
-                    {
-                        bytesToReceive = (tempByte & 0x7F) << 8;
-                        bytesToReceive += *((uint8_t*)RingBuf_getTailOffset(&buffer, 5));
-                        DIAG_LogMsgArg(DIAG_VERBOSE, MODULE_NAME, __func__, "large frame received. Length=%d", bytesToReceive);
-                        RingBuf_increaseTailMore(&buffer, 6);
-                    }
-                }
-                else if (tempByte > 0)
-                {
-                    bytesToReceive = tempByte;
-                    DIAG_LogMsgArg(DIAG_VERBOSE, MODULE_NAME, __func__, "short frame received. Length=%d", bytesToReceive);
-                    RingBuf_increaseTailMore(&buffer, 5);
-                }    
-                else /* null frame received (used for resynchronisation) */
-                {
-                    bytesToReceive = 0;
-                    RingBuf_increaseTailMore(&buffer, 5);
-                    PCAP_147_CapturinoDebug_writeDebugMsg(fifoPipe, "Null frame received");
-                }
+                PCAP_147_CapturinoDebug_writeDebugMsg(fifoPipe, "Internal error in the CAPTURino hardware");
             }
+            else
+            {
+                PCAP_147_CapturinoDebug_writeDebugMsg(fifoPipe, "Malformed frame received");
+            }
+            captureRv = -1;
+            break;
         }
-        else if (bufferElements >= bytesToReceive)
-        {
-            /* write the received data to the fifo */
-            PCAP_147_CapturinoDebug_writeDebugMsg(fifoPipe, "Frame received");
-            /* shift the remaining received bytes to the beginning */
-            RingBuf_increaseTailMore(&buffer, bytesToReceive);
-            /* reset the variable to trigger a new detection of the next frame length */
-            bytesToReceive = 0;
-        }
-
-        /* for now this case shall lead to an error */
-        if (bufferElements >= 250)
-        {
-            return -1;
-        }
-        SYSU_Sleep(1);
 
         /** \todo in case of no captured data is available for a certain amount
                  of time, the CAPTURino control board shall send a null frame,
@@ -284,9 +269,9 @@ static int captureWithOpenFifoAndComm(PipeHandleType fifoPipe,
 
     /* terminate a possible running capture command */
     bool noTerminateFlag = false;
-    CCON_Exec("\x03", 1, 50, &noTerminateFlag);
+    CCON_Exec(&mSession, "\x03", 1, 50, &noTerminateFlag);
 
-    return 0;
+    return captureRv;
 }
 
 static int captureWithOpenFifo(PipeHandleType fifoPipe,
@@ -298,6 +283,10 @@ static int captureWithOpenFifo(PipeHandleType fifoPipe,
 {
     int fcnRt = 0;
 
+    /* debug messages are rare and shall show up immediately, thus they are
+       not held back in the write buffer of the pcap writer */
+    PCAP_SetFlushLatency(0);
+
     fcnRt = PCAP_WriteHeader(fifoPipe, 0, 512, PCAP_CAPTURINODEBUG, 0, 0, 0);
     if (fcnRt != 0)
     {
@@ -305,7 +294,7 @@ static int captureWithOpenFifo(PipeHandleType fifoPipe,
         return -1;
     }
 
-    fcnRt = CCON_Open(comPort, baudrate);
+    fcnRt = CCON_Open(&mSession, comPort, baudrate);
     while (fcnRt != 0)
     {
         PCAP_147_CapturinoDebug_writeDebugMsg(fifoPipe, "Unable to open serial communication to CAPTURino! Retrying in 5 seconds ...");
@@ -314,7 +303,7 @@ static int captureWithOpenFifo(PipeHandleType fifoPipe,
         {
             return 0;
         }
-        fcnRt = CCON_Open(comPort, baudrate);
+        fcnRt = CCON_Open(&mSession, comPort, baudrate);
     }
     PCAP_147_CapturinoDebug_writeDebugMsg(fifoPipe, "Serial port opened successfully");
     
@@ -325,7 +314,7 @@ static int captureWithOpenFifo(PipeHandleType fifoPipe,
     }
 
     DIAG_LogMsg(DIAG_INFO, MODULE_NAME, __func__, "closing serial port");
-    CCON_Close();
+    CCON_Close(&mSession);
 
     return 0;
 }
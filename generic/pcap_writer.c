@@ -30,7 +30,9 @@
 
 /* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
 #include "diagnosis.h"
@@ -47,6 +49,12 @@
 /* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
 #define PCAP_MAX_SNAP_LENGTH 65535
 
+/** size of the buffer collecting the packet records before they are written
+    to the pipe */
+#define PCAP_WRITE_BUFFER_SIZE          (64*1024)
+/** the buffer is written to the pipe as soon as it holds this many bytes */
+#define PCAP_FLUSH_THRESHOLD            (16*1024)
+
 /* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
 
 /* ***************************************************************************
@@ -60,6 +68,12 @@
 /* G L O B A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
 static uint32_t mCurrentSnapLength = 0;
 
+static uint8_t mWriteBuffer[PCAP_WRITE_BUFFER_SIZE];
+static size_t mWriteBufferFill = 0;
+/** time when the oldest record within the write buffer was added */
+static unsigned long mOldestRecordMillis = 0;
+static unsigned long mFlushLatencyMS = PCAP_DEFAULT_FLUSH_LATENCY_MS;
+
 /* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
 static const char* MODULE_NAME = "PCAP";
 
@@ -72,6 +86,23 @@ static const char* MODULE_NAME = "PCAP";
 /* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
 
 /* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+/** Writes the data to the pipe in parts the pipe layer accepts at once. */
+static int writeChunked(PipeHandleType hFile,
+                        const uint8_t* data,
+                        size_t length)
+{
+    while (length > 0)
+    {
+        size_t chunkLength = (length > PIPH_MAX_WRITE_SIZE) ? PIPH_MAX_WRITE_SIZE : length;
+        if (PIPH_Write(hFile, (const char*)data, chunkLength) != 0)
+        {
+            return -1;
+        }
+        data += chunkLength;
+        length -= chunkLength;
+    }
+    return 0;
+}
 
 /* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
 int PCAP_WriteHeader(PipeHandleType hFile,
@@ -120,6 +151,11 @@ int PCAP_WriteHeader(PipeHandleType hFile,
     /* NOTE: bits 16-25 are reserved */
     (*(uint32_t*)&pcapHeader[20]) |= (0x0000FFFF & (uint32_t)linkType);
 
+    /* the header must precede all packet records */
+    if (PCAP_Flush(hFile) != 0)
+    {
+        return -1;
+    }
     return PIPH_Write(hFile, (void*)pcapHeader, 24);
 }
 
@@ -146,5 +182,85 @@ int PCAP_WritePacketRecord(PipeHandleType hFile,
                            void* packetData)
 {
     uint32_t snapLength = ((uint32_t*)packetData)[2];
-    return PIPH_Write(hFile, (void*)packetData, snapLength + 16);
-}
\ No newline at end of file
+    return PCAP_WriteBuffered(hFile, packetData, (size_t)snapLength + 16);
+}
+
+int PCAP_WriteBuffered(PipeHandleType hFile,
+                       const void* data,
+                       size_t length)
+{
+    if (length > PCAP_WRITE_BUFFER_SIZE - mWriteBufferFill)
+    {
+        if (PCAP_Flush(hFile) != 0)
+        {
+            return -1;
+        }
+    }
+    if ((mFlushLatencyMS == 0) || (length > PCAP_WRITE_BUFFER_SIZE))
+    {
+        return writeChunked(hFile, (const uint8_t*)data, length);
+    }
+
+    if (mWriteBufferFill == 0)
+    {
+        SYSU_GetCurrentMillis(&mOldestRecordMillis);
+    }
+    memcpy(&mWriteBuffer[mWriteBufferFill], data, length);
+    mWriteBufferFill += length;
+
+    if (mWriteBufferFill >= PCAP_FLUSH_THRESHOLD)
+    {
+        return PCAP_Flush(hFile);
+    }
+    return 0;
+}
+
+int PCAP_SetFlushLatency(unsigned long latencyMS)
+{
+    DIAG_LogMsgArg(DIAG_DEBUG, MODULE_NAME, __func__, "flush latency set to %lu ms", latencyMS);
+    mFlushLatencyMS = latencyMS;
+    return 0;
+}
+
+int PCAP_Flush(PipeHandleType hFile)
+{
+    if (mWriteBufferFill == 0)
+    {
+        return 0;
+    }
+    size_t bytes2write = mWriteBufferFill;
+    mWriteBufferFill = 0;
+    int rv = writeChunked(hFile, mWriteBuffer, bytes2write);
+    if (rv != 0)
+    {
+        DIAG_LogMsgArg(DIAG_ERROR, MODULE_NAME, __func__, "writing %lu buffered bytes failed!", (unsigned long)bytes2write);
+        return -1;
+    }
+    return 0;
+}
+
+int PCAP_FlushIfDue(PipeHandleType hFile,
+                    unsigned long* timeUntilDueMS)
+{
+    unsigned long timeUntilDue = PCAP_NO_FLUSH_PENDING;
+    int rv = 0;
+    if (mWriteBufferFill != 0)
+    {
+        unsigned long currentMillis;
+        SYSU_GetCurrentMillis(&currentMillis);
+        unsigned long elapsedMS = currentMillis - mOldestRecordMillis;
+        if (elapsedMS >= mFlushLatencyMS)
+        {
+            rv = PCAP_Flush(hFile);
+        }
+        else
+        {
+            timeUntilDue = mFlushLatencyMS - elapsedMS;
+        }
+    }
+    if (timeUntilDueMS != NULL)
+    {
+        *timeUntilDueMS = timeUntilDue;
+    }
+    return rv;
+}
@@ -32,7 +32,9 @@
  *************************************************************************** */
 
 /* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <limits.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
@@ -43,6 +45,12 @@
  *************************************************************************** */
 
 /* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+/** maximum time a packet record is held back in the write buffer unless
+    changed by PCAP_SetFlushLatency() */
+#define PCAP_DEFAULT_FLUSH_LATENCY_MS   (5)
+
+/** reported by PCAP_FlushIfDue() if the write buffer is empty */
+#define PCAP_NO_FLUSH_PENDING           (ULONG_MAX)
 
 /* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
 
@@ -105,6 +113,60 @@ int PCAP_FillPacketRecordHeader(const PCAP_PacketRecordHeaderType* packetRecordH
 int PCAP_WritePacketRecord     (      PipeHandleType               hFile,
                                       void*                        packetData);
 
+/** Writes the given bytes to the pipe through the write buffer, i.e. in order
+ * with the packet records. Used for the blocks of the pcapng format.
+ *
+ * \param hFile Handle to the file to write the data to
+ * \param data The data to be written
+ * \param length The number of bytes in data
+ *
+ * \returns 0: if the data has been written or buffered successfully.
+ * \returns -1: if writing to the pipe failed.
+ */
+int PCAP_WriteBuffered         (      PipeHandleType               hFile,
+                                const void*                        data,
+                                      size_t                       length);
+
+/** Sets the maximum time a packet record is held back in the write buffer
+ * before it is written to the pipe.
+ *
+ * Packet records are collected in a write buffer, which is written to the
+ * pipe at once if it is filled up or if the oldest record within the buffer
+ * reaches this latency. A latency of 0 disables the write buffer, i.e. every
+ * packet record is written to the pipe immediately.
+ *
+ * \param latencyMS the maximum latency in milliseconds.
+ *
+ * \returns 0: everytime
+ */
+int PCAP_SetFlushLatency       (      unsigned long                latencyMS);
+
+/** Writes all buffered packet records to the pipe.
+ *
+ * \param hFile Handle to the file the packet records have been written to.
+ *
+ * \returns 0: if the buffered records have been written successfully or no
+ *             records were buffered.
+ * \returns -1: if writing to the pipe failed. The buffered records are
+ *              discarded in this case.
+ */
+int PCAP_Flush                 (      PipeHandleType               hFile);
+
+/** Writes all buffered packet records to the pipe if the oldest one reached
+ * the flush latency. Must be called periodically by the capture loop, as the
+ * deadline is not checked while writing packet records.
+ *
+ * \param hFile Handle to the file the packet records have been written to.
+ * \param timeUntilDueMS Receives the time in milliseconds until the buffered
+ *                       records are due to be written, PCAP_NO_FLUSH_PENDING
+ *                       if no records are buffered. May be NULL.
+ *
+ * \returns 0: if the function succeeded.
+ * \returns -1: if writing to the pipe failed.
+ */
+int PCAP_FlushIfDue            (      PipeHandleType               hFile,
+                                      unsigned long*               timeUntilDueMS);
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 #endif // PCAP_WRITER_H_INCLUDED
 
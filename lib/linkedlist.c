@@ -163,6 +163,7 @@ int LLST_remove_elem_with_id(LLST_ListEntryType* listStartEntry, LLST_ListEntryT
             prevEntry->next = currentEntry->next;
             return 0;
         }
+        prevEntry = currentEntry;
         currentEntry = currentEntry->next;
     }
     
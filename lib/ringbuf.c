@@ -42,6 +42,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <limits.h>
+#include <string.h>
 
 /* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
 #include "ringbuf.h"
@@ -79,6 +80,21 @@
 /* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
 
 /* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+/** Splits 'count' bytes starting at the free running position 'position' into
+ * the part up to the end of the buffer and the part from its start.
+ */
+static void getSegments(const RingBufP2Type* const context,
+                        size_t position,
+                        size_t count,
+                        RingBufSegmentType segments[2])
+{
+    size_t index = position & context->mask;
+    size_t bytes2End = context->mask + 1 - index;
+    segments[0].data = &context->buffer[index];
+    segments[0].length = (count < bytes2End) ? count : bytes2End;
+    segments[1].data = context->buffer;
+    segments[1].length = count - segments[0].length;
+}
 
 /* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
 bool RingBuf_isEmpty(const RingBufType* const context)
@@ -209,6 +225,12 @@ size_t RingBuf_getFreeElementsHead2End(const RingBufType* const context)
     {
         return context->tail - context->head - 1;
     }
+    else if (context->tail == 0)
+    {
+        /* one element must stay free, otherwise head would wrap onto tail
+           and the full buffer would be considered empty */
+        return context->bufferSize - context->head - 1;
+    }
     else /* if (context->head >= context->tail) */
     {
         return context->bufferSize - context->head;
@@ -239,6 +261,86 @@ size_t RingBuf_getElementsCount(const RingBufType* const context)
     }
 }
 
+int RingBufP2_init(RingBufP2Type* const context, void* buffer, size_t capacity)
+{
+    if ((capacity == 0) || ((capacity & (capacity - 1)) != 0))
+    {
+        return -1;
+    }
+    context->head = 0;
+    context->tail = 0;
+    context->buffer = (uint8_t*)buffer;
+    context->mask = capacity - 1;
+    return 0;
+}
+
+int RingBufP2_peek(const RingBufP2Type* const context, size_t offset, void* dest, size_t count)
+{
+    if (offset + count > RingBufP2_getCount(context))
+    {
+        return -1;
+    }
+    size_t index = (context->tail + offset) & context->mask;
+    if (index + count <= context->mask + 1)
+    {
+        /* fast path: the bytes do not wrap around */
+        memcpy(dest, &context->buffer[index], count);
+        return 0;
+    }
+    RingBufSegmentType segments[2];
+    getSegments(context, context->tail + offset, count, segments);
+    memcpy(dest, segments[0].data, segments[0].length);
+    memcpy((uint8_t*)dest + segments[0].length, segments[1].data, segments[1].length);
+    return 0;
+}
+
+int RingBufP2_read(RingBufP2Type* const context, void* dest, size_t count)
+{
+    if (RingBufP2_peek(context, 0, dest, count) != 0)
+    {
+        return -1;
+    }
+    context->tail += count;
+    return 0;
+}
+
+int RingBufP2_write(RingBufP2Type* const context, const void* src, size_t count)
+{
+    if (count > RingBufP2_getFree(context))
+    {
+        return -1;
+    }
+    size_t index = context->head & context->mask;
+    if (index + count <= context->mask + 1)
+    {
+        /* fast path: the bytes do not wrap around */
+        memcpy(&context->buffer[index], src, count);
+    }
+    else
+    {
+        RingBufSegmentType segments[2];
+        getSegments(context, context->head, count, segments);
+        memcpy(segments[0].data, src, segments[0].length);
+        memcpy(segments[1].data, (const uint8_t*)src + segments[0].length, segments[1].length);
+    }
+    context->head += count;
+    return 0;
+}
+
+size_t RingBufP2_getReadSegments(const RingBufP2Type* const context, RingBufSegmentType segments[2])
+{
+    size_t count = RingBufP2_getCount(context);
+    getSegments(context, context->tail, count, segments);
+    return count;
+}
+
+size_t RingBufP2_getWriteSegments(const RingBufP2Type* const context, RingBufSegmentType segments[2])
+{
+    size_t freeBytes = RingBufP2_getFree(context);
+    getSegments(context, context->head, freeBytes, segments);
+    return freeBytes;
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 /* ***************************************************************************
@@ -31,6 +31,15 @@
  * \file
  * \addtogroup ringbuf
  * 
+ * Two variants are available:
+ * - RingBufType stores elements of any size in a buffer of any size. One
+ *   element always stays free to distinguish a full from an empty buffer.
+ * - RingBufP2Type stores bytes in a buffer with a power of two capacity. Head
+ *   and tail are free running counters which are mapped into the buffer by
+ *   masking, so all bytes can be used and no division is necessary. The
+ *   accessors are inline functions, bulk operations copy across the wrap
+ *   around with at most two memcpy calls.
+ *
  * @{
  */
 /* ************************************************************************* */
@@ -43,8 +52,10 @@
  *************************************************************************** */
 
 /* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 /* ***************************************************************************
  * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
@@ -76,6 +87,23 @@ typedef struct
                                      buffer. */
 } RingBufType;
 
+typedef struct
+{
+    size_t   head;              /**< Number of bytes ever written. */
+    size_t   tail;              /**< Number of bytes ever read. */
+    uint8_t* buffer;            /**< Pointer to the buffer. */
+    size_t   mask;              /**< Capacity of the buffer minus one. The
+                                     capacity must be a power of two. */
+} RingBufP2Type;
+
+/** Contiguous part of a RingBufP2Type, see RingBufP2_getReadSegments() and
+    RingBufP2_getWriteSegments(). */
+typedef struct
+{
+    uint8_t* data;
+    size_t   length;
+} RingBufSegmentType;
+
 /* ***************************************************************************
  * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
  *************************************************************************** */
@@ -200,9 +228,182 @@ size_t RingBuf_getFullElementsTail2End(const RingBufType* const context);
  */
 size_t RingBuf_getElementsCount(const RingBufType* const context);
 
+/** Initializes an empty power of two ring buffer on the given storage.
+ * 
+ * \param[out] context The ring buffer to be initialized.
+ * \param[in] buffer The storage of the ring buffer.
+ * \param[in] capacity The size of the storage in bytes. Must be a power of
+ *                     two.
+ * 
+ * \returns 0: if the ring buffer has been initialized.
+ * \returns -1: if the capacity is not a power of two.
+ */
+int RingBufP2_init(RingBufP2Type* const context, void* buffer, size_t capacity);
+
+/** Copies 'count' bytes starting 'offset' bytes behind the tail to the given
+ * destination without removing them from the ring buffer.
+ * 
+ * \param[in] context The ring buffer to read from.
+ * \param[in] offset The offset to the tail.
+ * \param[out] dest The destination of the data.
+ * \param[in] count The number of bytes to copy.
+ * 
+ * \returns 0: if the bytes have been copied.
+ * \returns -1: if the ring buffer contains less than offset+count bytes.
+ */
+int RingBufP2_peek(const RingBufP2Type* const context, size_t offset, void* dest, size_t count);
+
+/** Copies 'count' bytes from the tail to the given destination and removes
+ * them from the ring buffer.
+ * 
+ * \param[in] context The ring buffer to read from.
+ * \param[out] dest The destination of the data.
+ * \param[in] count The number of bytes to read.
+ * 
+ * \returns 0: if the bytes have been read.
+ * \returns -1: if the ring buffer contains less than count bytes.
+ */
+int RingBufP2_read(RingBufP2Type* const context, void* dest, size_t count);
+
+/** Appends 'count' bytes to the ring buffer.
+ * 
+ * \param[in] context The ring buffer to write to.
+ * \param[in] src The data to be written.
+ * \param[in] count The number of bytes to write.
+ * 
+ * \returns 0: if the bytes have been written.
+ * \returns -1: if less than count bytes are free.
+ */
+int RingBufP2_write(RingBufP2Type* const context, const void* src, size_t count);
+
+/** Retrieves all stored bytes as up to two contiguous segments, e.g. for a
+ * writev() like function. Segments which are not necessary have a length of
+ * 0.
+ * 
+ * \param[in] context The ring buffer to be checked.
+ * \param[out] segments The stored bytes in order.
+ * 
+ * \returns The total number of stored bytes.
+ */
+size_t RingBufP2_getReadSegments(const RingBufP2Type* const context, RingBufSegmentType segments[2]);
+
+/** Retrieves the free space as up to two contiguous segments, e.g. for a
+ * readv() like function. The written bytes must be published with
+ * RingBufP2_increaseHeadMore() afterwards.
+ * 
+ * \param[in] context The ring buffer to be checked.
+ * \param[out] segments The free space in order.
+ * 
+ * \returns The total number of free bytes.
+ */
+size_t RingBufP2_getWriteSegments(const RingBufP2Type* const context, RingBufSegmentType segments[2]);
+
 /* G L O B A L   E X T E R N A L   F U N C T I O N   P R O T O T Y P E S * * */
 
 /* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
+/** Retrieves the capacity of the ring buffer in bytes. */
+static inline size_t RingBufP2_getCapacity(const RingBufP2Type* const context)
+{
+    return context->mask + 1;
+}
+
+/** Retrieves the number of bytes stored in the ring buffer. */
+static inline size_t RingBufP2_getCount(const RingBufP2Type* const context)
+{
+    return context->head - context->tail;
+}
+
+/** Retrieves the number of free bytes in the ring buffer. */
+static inline size_t RingBufP2_getFree(const RingBufP2Type* const context)
+{
+    return context->mask + 1 - (context->head - context->tail);
+}
+
+static inline bool RingBufP2_isEmpty(const RingBufP2Type* const context)
+{
+    return context->head == context->tail;
+}
+
+static inline bool RingBufP2_isFull(const RingBufP2Type* const context)
+{
+    return RingBufP2_getFree(context) == 0;
+}
+
+/** Retrieves the pointer to the byte 'offset' bytes behind the tail.
+ * 
+ * \returns a valid address if the buffer contains more than 'offset' bytes.
+ * \returns NULL if the requested position does not contain valid data.
+ */
+static inline uint8_t* RingBufP2_getTailOffset(const RingBufP2Type* const context, size_t offset)
+{
+    if (offset >= RingBufP2_getCount(context))
+    {
+        return NULL;
+    }
+    return &context->buffer[(context->tail + offset) & context->mask];
+}
+
+/** Retrieves the contiguous stored bytes at the tail.
+ * 
+ * \param[in] context The ring buffer to be checked.
+ * \param[out] span The address of the tail.
+ * 
+ * \returns The number of bytes that can be read from span.
+ */
+static inline size_t RingBufP2_getReadSpan(const RingBufP2Type* const context, const uint8_t** span)
+{
+    size_t tailIndex = context->tail & context->mask;
+    size_t bytes2End = context->mask + 1 - tailIndex;
+    size_t count = RingBufP2_getCount(context);
+    *span = &context->buffer[tailIndex];
+    return (count < bytes2End) ? count : bytes2End;
+}
+
+/** Retrieves the contiguous free space at the head.
+ * 
+ * \param[in] context The ring buffer to be checked.
+ * \param[out] span The address of the head.
+ * 
+ * \returns The number of bytes that can be written to span.
+ */
+static inline size_t RingBufP2_getWriteSpan(const RingBufP2Type* const context, uint8_t** span)
+{
+    size_t headIndex = context->head & context->mask;
+    size_t bytes2End = context->mask + 1 - headIndex;
+    size_t freeBytes = RingBufP2_getFree(context);
+    *span = &context->buffer[headIndex];
+    return (freeBytes < bytes2End) ? freeBytes : bytes2End;
+}
+
+/** Removes 'more' bytes from the tail.
+ * 
+ * \returns 0: if the operation was successful.
+ * \returns -1: if the buffer contains less than 'more' bytes.
+ */
+static inline int RingBufP2_increaseTailMore(RingBufP2Type* const context, size_t more)
+{
+    if (more > RingBufP2_getCount(context))
+    {
+        return -1;
+    }
+    context->tail += more;
+    return 0;
+}
+
+/** Publishes 'more' bytes written to the head.
+ * 
+ * \returns 0: if the operation was successful.
+ * \returns -1: if less than 'more' bytes are free.
+ */
+static inline int RingBufP2_increaseHeadMore(RingBufP2Type* const context, size_t more)
+{
+    if (more > RingBufP2_getFree(context))
+    {
+        return -1;
+    }
+    context->head += more;
+    return 0;
+}
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 #ifdef __cplusplus
@@ -0,0 +1,204 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup spscqueue
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* M O D U L E   H E A D E R   I N C L U D E * * * * * * * * * * * * * * * * */
+#include "spscqueue.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * */
+
+/* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * * */
+
+/* L O C A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * * */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int SPSC_init(SpscQueueType* const context, void* buffer, size_t capacity)
+{
+    if ((capacity == 0) || ((capacity & (capacity - 1)) != 0))
+    {
+        return -1;
+    }
+    context->buffer = (uint8_t*)buffer;
+    context->capacity = capacity;
+    context->isMirrored = false;
+    atomic_init(&context->head, 0);
+    atomic_init(&context->tail, 0);
+    return 0;
+}
+
+int SPSC_initMirrored(SpscQueueType* const context, void* buffer, size_t capacity)
+{
+    if (SPSC_init(context, buffer, capacity) != 0)
+    {
+        return -1;
+    }
+    context->isMirrored = true;
+    return 0;
+}
+
+size_t SPSC_getCount(SpscQueueType* const context)
+{
+    size_t tail = atomic_load_explicit(&context->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&context->head, memory_order_acquire);
+    return head - tail;
+}
+
+size_t SPSC_getWriteSpan(SpscQueueType* const context, void** span)
+{
+    /* the head is only modified by the calling thread itself */
+    size_t head = atomic_load_explicit(&context->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&context->tail, memory_order_acquire);
+    size_t freeBytes = context->capacity - (head - tail);
+    size_t headIndex = head & (context->capacity - 1);
+    size_t bytes2End = context->capacity - headIndex;
+
+    *span = &context->buffer[headIndex];
+    if (context->isMirrored == true)
+    {
+        /* the bytes behind the end are the mirror of the start */
+        return freeBytes;
+    }
+    return (freeBytes < bytes2End) ? freeBytes : bytes2End;
+}
+
+int SPSC_commitWrite(SpscQueueType* const context, size_t count)
+{
+    size_t head = atomic_load_explicit(&context->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&context->tail, memory_order_acquire);
+    if (count > context->capacity - (head - tail))
+    {
+        return -1;
+    }
+    /* release: the written data becomes visible before the new head */
+    atomic_store_explicit(&context->head, head + count, memory_order_release);
+    return 0;
+}
+
+size_t SPSC_getReadSpan(SpscQueueType* const context, const void** span)
+{
+    /* the tail is only modified by the calling thread itself */
+    size_t tail = atomic_load_explicit(&context->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&context->head, memory_order_acquire);
+    size_t storedBytes = head - tail;
+    size_t tailIndex = tail & (context->capacity - 1);
+    size_t bytes2End = context->capacity - tailIndex;
+
+    *span = &context->buffer[tailIndex];
+    if (context->isMirrored == true)
+    {
+        return storedBytes;
+    }
+    return (storedBytes < bytes2End) ? storedBytes : bytes2End;
+}
+
+int SPSC_commitRead(SpscQueueType* const context, size_t count)
+{
+    size_t tail = atomic_load_explicit(&context->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&context->head, memory_order_acquire);
+    if (count > head - tail)
+    {
+        return -1;
+    }
+    /* release: the data has been read before the producer may overwrite it */
+    atomic_store_explicit(&context->tail, tail + count, memory_order_release);
+    return 0;
+}
+
+size_t SPSC_read(SpscQueueType* const context, void* dest, size_t maxBytes)
+{
+    size_t totalBytesRead = 0;
+    /* at most two spans are necessary, one to the end of the storage and one
+       from the start of the storage */
+    for (size_t i=0; (i<2) && (totalBytesRead < maxBytes); i++)
+    {
+        const void* span;
+        size_t spanLen = SPSC_getReadSpan(context, &span);
+        if (spanLen == 0)
+        {
+            break;
+        }
+        if (spanLen > maxBytes - totalBytesRead)
+        {
+            spanLen = maxBytes - totalBytesRead;
+        }
+        memcpy((uint8_t*)dest + totalBytesRead, span, spanLen);
+        SPSC_commitRead(context, spanLen);
+        totalBytesRead += spanLen;
+    }
+    return totalBytesRead;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
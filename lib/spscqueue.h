@@ -0,0 +1,218 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \addtogroup spscqueue
+ * \brief Lock-free byte queue for exactly one producer and one consumer
+ *        thread.
+ *
+ * The producer only modifies the head, the consumer only modifies the tail.
+ * Both are free running counters, which are mapped into the buffer by masking
+ * them with the capacity. Hence the capacity must be a power of two.
+ *
+ * If the storage is mapped twice into consecutive addresses (see
+ * SYSU_AllocMirrored()), the queue hands out all free and all stored bytes as
+ * one contiguous span, even across the end of the storage.
+ *
+ * @{
+ */
+/* ************************************************************************* */
+
+#ifndef SPSCQUEUE_H_INCLUDED
+#define SPSCQUEUE_H_INCLUDED
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* G L O B A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * */
+/** Assumed size of a cache line, used to keep the head and the tail counter
+    apart from each other */
+#define SPSC_CACHE_LINE_SIZE    (64)
+
+/* G L O B A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * */
+typedef struct
+{
+    uint8_t*      buffer;       /**< Pointer to the storage of the queue. */
+    size_t        capacity;     /**< Size of the storage in bytes, must be a
+                                     power of two. */
+    bool          isMirrored;   /**< The storage is followed by a second
+                                     mapping of itself. */
+    atomic_size_t head;         /**< Number of bytes ever written, modified by
+                                     the producer only. */
+    char          padding[SPSC_CACHE_LINE_SIZE];
+    atomic_size_t tail;         /**< Number of bytes ever read, modified by
+                                     the consumer only. */
+} SpscQueueType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   C O N S T A N T S   D E C L A R A T I O N S * * * * * * * * */
+
+/* G L O B A L   V A R I A B L E   D E C L A R A T I O N S * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* G L O B A L   F U N C T I O N   P R O T O T Y P E S * * * * * * * * * * * */
+/** Initializes an empty queue on the given storage.
+ *
+ * \param[out] context The queue to be initialized.
+ * \param[in] buffer The storage of the queue.
+ * \param[in] capacity The size of the storage in bytes. Must be a power of
+ *                     two.
+ *
+ * \returns 0: if the queue has been initialized.
+ * \returns -1: if the capacity is not a power of two.
+ */
+int SPSC_init(SpscQueueType* const context, void* buffer, size_t capacity);
+
+/** Initializes an empty queue on mirrored storage, i.e. the address range
+ * buffer .. buffer+2*capacity-1 maps the storage twice.
+ *
+ * \param[out] context The queue to be initialized.
+ * \param[in] buffer The mirrored storage of the queue.
+ * \param[in] capacity The size of the storage in bytes. Must be a power of
+ *                     two.
+ *
+ * \returns 0: if the queue has been initialized.
+ * \returns -1: if the capacity is not a power of two.
+ */
+int SPSC_initMirrored(SpscQueueType* const context, void* buffer, size_t capacity);
+
+/** Retrieves the number of bytes currently stored in the queue.
+ *
+ * \note May be called from the producer and the consumer thread. The returned
+ *       value might already be outdated when the function returns.
+ *
+ * \param[in] context The queue to be checked.
+ *
+ * \returns The number of bytes stored in the queue.
+ */
+size_t SPSC_getCount(SpscQueueType* const context);
+
+/** Retrieves the contiguous free space at the head of the queue. Producer
+ * only.
+ *
+ * \param[in] context The queue to write to.
+ * \param[out] span The address where the free space starts.
+ *
+ * \returns The number of bytes that can be written to span. 0 if the queue is
+ *          full. All free bytes if the storage is mirrored.
+ */
+size_t SPSC_getWriteSpan(SpscQueueType* const context, void** span);
+
+/** Publishes 'count' bytes written to the span returned by
+ * SPSC_getWriteSpan() to the consumer. Producer only.
+ *
+ * \param[in] context The queue written to.
+ * \param[in] count The number of bytes written.
+ *
+ * \returns 0: if the operation was successful.
+ * \returns -1: if count exceeds the free space of the queue.
+ */
+int SPSC_commitWrite(SpscQueueType* const context, size_t count);
+
+/** Retrieves the contiguous stored data at the tail of the queue. Consumer
+ * only.
+ *
+ * \param[in] context The queue to read from.
+ * \param[out] span The address where the stored data starts.
+ *
+ * \returns The number of bytes that can be read from span. 0 if the queue is
+ *          empty. All stored bytes if the storage is mirrored.
+ */
+size_t SPSC_getReadSpan(SpscQueueType* const context, const void** span);
+
+/** Releases 'count' bytes at the tail of the queue to the producer. Consumer
+ * only.
+ *
+ * \param[in] context The queue read from.
+ * \param[in] count The number of bytes consumed.
+ *
+ * \returns 0: if the operation was successful.
+ * \returns -1: if count exceeds the number of stored bytes.
+ */
+int SPSC_commitRead(SpscQueueType* const context, size_t count);
+
+/** Copies up to 'maxBytes' bytes from the queue to the given destination and
+ * releases them, wrapping around the end of the storage if necessary.
+ * Consumer only.
+ *
+ * \param[in] context The queue to read from.
+ * \param[out] dest The destination of the data.
+ * \param[in] maxBytes The size of the destination in bytes.
+ *
+ * \returns The number of bytes copied to dest.
+ */
+size_t SPSC_read(SpscQueueType* const context, void* dest, size_t maxBytes);
+
+/* G L O B A L   E X T E R N A L   F U N C T I O N   P R O T O T Y P E S * * */
+
+/* G L O B A L   I N L I N E   F U N C T I O N   D E F I N I T I O N S * * * */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPSCQUEUE_H_INCLUDED */
+
+/**
+ * @}
+ */
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
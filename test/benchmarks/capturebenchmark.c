@@ -0,0 +1,744 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \brief End-to-end benchmark of the capture path. Runs CapturinoPlugin
+ *        against the device simulator and reads the pcap stream from the
+ *        output FIFO.
+ *
+ * For every traffic profile the throughput, the latency from the arrival of
+ * a frame at the serial port to its write to the FIFO, the CPU time and the
+ * system calls of the plugin are measured. The system calls are counted in a
+ * separate run of the profile, in which the plugin is traced by ptrace() and
+ * thus slowed down. The count starts once the first record arrived, so the
+ * system calls of the start of the plugin, which depend on the host, are
+ * excluded, and is divided by the records read from then on. If the plugin
+ * cannot be traced, e.g. due to the kernel.yama.ptrace_scope setting, "n/a"
+ * is reported. The latency is the
+ * time a record is read from the FIFO minus its timestamp, which the plugin
+ * maps from the device clock onto the host clock. As the simulator stamps a
+ * frame when it is written to the pseudo-terminal, this covers the serial
+ * transfer, the decoding, the buffering of the pcap writer and the FIFO. The
+ * error of the time synchronization is logged by the plugin and usually
+ * below 20 us.
+ *
+ * Profiles with a rate of 0 are sent as fast as the plugin reads them, they
+ * measure the sustained throughput. Their latency includes the queueing in
+ * the pseudo-terminal and is only meaningful in comparison.
+ *
+ * Options: --frames=<n> overrides the frames of every profile,
+ * --profile=<name> runs a single profile. Arguments after "--" are passed to
+ * the plugin, e.g. "-- --linkprofile throughput --flushlatency 0".
+ *
+ * With --baseline=<file> the results are compared to a baseline and the
+ * benchmark fails if a metric regressed beyond its tolerance. Every line of
+ * the file holds a profile, a metric, its baseline value and the tolerance
+ * in percent. The metrics are "frames/s", "syscalls/frame" and "rss_kB", the
+ * peak resident set size of the plugin. Lines starting with '#' are comments.
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/ptrace.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "argparser.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+#define MAX_PLUGIN_ARGS         (64)
+#define READ_BUFFER_SIZE        (65536)
+#define PCAP_HEADER_SIZE        (24)
+#define PCAP_RECORD_HEADER_SIZE (16)
+/** the benchmark is aborted if no record arrives for this time */
+#define STALL_TIMEOUT_MS        (10000)
+#define MAX_BASELINE_LINE       (256)
+/** reported if the system calls of the plugin could not be counted */
+#define SYSCALLS_UNKNOWN        (ULLONG_MAX)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+#define ARRAY_LENGTH(a)         (sizeof(a) / sizeof((a)[0]))
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+typedef struct
+{
+    const char*   name;
+    unsigned int  dlt;
+    const char*   sizes;
+    unsigned long rate;         /**< frames per second, 0: as fast as read */
+    unsigned long burst;
+    unsigned long extendedPercent;
+    unsigned long frames;
+} ProfileType;
+
+typedef struct
+{
+    unsigned long frames;
+    unsigned long long bytes;   /**< captured bytes of the records */
+    double        seconds;      /**< first to last record */
+    long long*    latenciesNs;
+    double        cpuSeconds;
+    unsigned long long syscalls;
+    unsigned long syscallFrames;    /**< records read while the system calls
+                                         were counted */
+    long          contextSwitches;
+    long          peakRssKB;
+} ResultType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+static volatile sig_atomic_t mTracerTerminate = 0;
+static volatile sig_atomic_t mTracerRestart = 0;
+
+/* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
+static const ProfileType PROFILES[] = {
+    { .name = "148-8B-max",     .dlt = 148, .sizes = "8",    .rate = 0,     .burst = 1,   .extendedPercent = 0,  .frames = 200000 },
+    { .name = "148-mixed-max",  .dlt = 148, .sizes = "1-64", .rate = 0,     .burst = 1,   .extendedPercent = 0,  .frames = 100000 },
+    { .name = "148-8B-5k",      .dlt = 148, .sizes = "8",    .rate = 5000,  .burst = 1,   .extendedPercent = 0,  .frames = 15000  },
+    { .name = "148-burst-5k",   .dlt = 148, .sizes = "1-64", .rate = 5000,  .burst = 100, .extendedPercent = 0,  .frames = 15000  },
+    { .name = "227-std-max",    .dlt = 227, .sizes = "0-8",  .rate = 0,     .burst = 1,   .extendedPercent = 0,  .frames = 200000 },
+    { .name = "227-mixed-5k",   .dlt = 227, .sizes = "0-8",  .rate = 5000,  .burst = 1,   .extendedPercent = 50, .frames = 15000  },
+    { .name = "227-burst-5k",   .dlt = 227, .sizes = "8",    .rate = 5000,  .burst = 50,  .extendedPercent = 50, .frames = 15000  }
+};
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static long long getRealtimeNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static uint32_t readLittleEndian32(const uint8_t* data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8)
+         | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static int compareLongLongs(const void* a,
+                            const void* b)
+{
+    long long valA = *((const long long*)a);
+    long long valB = *((const long long*)b);
+    return (valA > valB) - (valA < valB);
+}
+
+/** Starts the simulator and reads the path of its pseudo-terminal. */
+static pid_t startSimulator(const ProfileType* profile,
+                            unsigned long frames,
+                            char* portPath,
+                            size_t portPathSize)
+{
+    char rateArg[32], framesArg[32], burstArg[32], sizesArg[64], extendedArg[32];
+    snprintf(rateArg, sizeof(rateArg), "--rate=%lu", profile->rate);
+    snprintf(framesArg, sizeof(framesArg), "--frames=%lu", frames);
+    snprintf(burstArg, sizeof(burstArg), "--burst=%lu", profile->burst);
+    snprintf(sizesArg, sizeof(sizesArg), "--sizes=%s", profile->sizes);
+    snprintf(extendedArg, sizeof(extendedArg), "--extended=%lu", profile->extendedPercent);
+    char* argv[] = { SIMULATOR_PATH, rateArg, framesArg, burstArg, sizesArg, extendedArg, NULL };
+
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0)
+    {
+        perror("pipe");
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        /* the statistics of the simulator would clutter the results */
+        int nullFd = open("/dev/null", O_WRONLY);
+        dup2(pipeFds[1], STDOUT_FILENO);
+        dup2(nullFd, STDERR_FILENO);
+        close(nullFd);
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+        execv(argv[0], argv);
+        perror(argv[0]);
+        _exit(127);
+    }
+    close(pipeFds[1]);
+    FILE* simOut = fdopen(pipeFds[0], "r");
+    if ((pid < 0) || (simOut == NULL) || (fgets(portPath, (int)portPathSize, simOut) == NULL))
+    {
+        fprintf(stderr, "the simulator did not report its port\n");
+        if (simOut != NULL)
+        {
+            fclose(simOut);
+        }
+        return -1;
+    }
+    fclose(simOut);
+    portPath[strcspn(portPath, "\n")] = '\0';
+    return pid;
+}
+
+static void onTracerSignal(int sig)
+{
+    if (sig == SIGUSR1)
+    {
+        mTracerRestart = 1;
+    }
+    else
+    {
+        mTracerTerminate = 1;
+    }
+}
+
+/** Runs the plugin traced by this process and counts the system calls of all
+    its threads. SIGUSR1 restarts the count. SIGTERM is forwarded to the
+    plugin, the count until then is written to countFd. Does not return. */
+static void traceSyscalls(char* argv[],
+                          int countFd)
+{
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onTracerSignal;
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGUSR1, &sa, NULL);
+
+    pid_t plugin = fork();
+    if (plugin == 0)
+    {
+        ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+        execv(argv[0], argv);
+        perror(argv[0]);
+        _exit(127);
+    }
+    unsigned long long syscalls = 0;
+    bool traced = false;
+    bool reported = false;
+    int exitCode = 1;
+    while (plugin > 0)
+    {
+        if (mTracerRestart != 0)
+        {
+            mTracerRestart = 0;
+            syscalls = 0;
+        }
+        if ((mTracerTerminate != 0) && (reported == false))
+        {
+            unsigned long long count = (traced == true) ? syscalls : SYSCALLS_UNKNOWN;
+            reported = (write(countFd, &count, sizeof(count)) == (ssize_t)sizeof(count));
+            kill(plugin, SIGTERM);
+        }
+        int status;
+        pid_t tid = waitpid(-1, &status, __WALL);
+        if (tid < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            /* the plugin and all its threads have exited */
+            break;
+        }
+        if ((WIFEXITED(status)) || (WIFSIGNALED(status)))
+        {
+            if (tid == plugin)
+            {
+                exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : (128 + WTERMSIG(status));
+            }
+            continue;
+        }
+        int sig = 0;
+        if (WSTOPSIG(status) == (SIGTRAP | 0x80))
+        {
+            struct __ptrace_syscall_info info;
+            if ((ptrace(PTRACE_GET_SYSCALL_INFO, tid, (void*)sizeof(info), &info) > 0)
+                && (info.op == PTRACE_SYSCALL_INFO_ENTRY))
+            {
+                syscalls++;
+            }
+        }
+        else if ((WSTOPSIG(status) == SIGTRAP) && (traced == false))
+        {
+            /* the stop after the execve(), the following threads are traced
+               as well */
+            traced = (ptrace(PTRACE_SETOPTIONS, tid, NULL,
+                             (void*)(PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE | PTRACE_O_EXITKILL)) == 0);
+        }
+        else if ((WSTOPSIG(status) != SIGTRAP) && (WSTOPSIG(status) != SIGSTOP))
+        {
+            /* neither a clone event nor the start of a new thread */
+            sig = WSTOPSIG(status);
+        }
+        ptrace(PTRACE_SYSCALL, tid, NULL, (void*)(intptr_t)sig);
+    }
+    if (reported == false)
+    {
+        unsigned long long count = (traced == true) ? syscalls : SYSCALLS_UNKNOWN;
+        if (write(countFd, &count, sizeof(count)) != (ssize_t)sizeof(count))
+        {
+            exitCode = 1;
+        }
+    }
+    _exit(exitCode);
+}
+
+/** Starts the plugin. If countFd is valid, the plugin is started by a tracer
+    counting its system calls, whose pid is returned instead. */
+static pid_t startPlugin(const ProfileType* profile,
+                         char* portPath,
+                         char* fifoPath,
+                         int extraArgc,
+                         char* extraArgv[],
+                         int countFd)
+{
+    char dltArg[16];
+    snprintf(dltArg, sizeof(dltArg), "%u", profile->dlt);
+    char* argv[MAX_PLUGIN_ARGS] = {
+        PLUGIN_PATH, "--extcap-interface", "CAPTURino", "--capture",
+        "--fifo", fifoPath, "--port", portPath, "--dlts", dltArg,
+        "--baudrate", "115200", "--serialbaudrate", "115200", "--serialdatabits", "8",
+        "--serialparity", "0", "--serialstopps", "1", "--serialtimeout", "10",
+        "--canbaudrate", "500000", "--cansamplepoint", "75"
+    };
+    size_t argc = 0;
+    while (argv[argc] != NULL)
+    {
+        argc++;
+    }
+    for (int i=0; (i<extraArgc) && (argc < (MAX_PLUGIN_ARGS - 1)); i++)
+    {
+        argv[argc++] = extraArgv[i];
+    }
+    argv[argc] = NULL;
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        if (countFd >= 0)
+        {
+            traceSyscalls(argv, countFd);
+        }
+        execv(argv[0], argv);
+        perror(argv[0]);
+        _exit(127);
+    }
+    return pid;
+}
+
+/** Reads the pcap stream until the expected number of records arrived. If
+    counter is valid, the count of the system calls is restarted by SIGUSR1
+    once the first records arrived. */
+static int readRecords(int fifoFd,
+                       unsigned long frames,
+                       pid_t counter,
+                       ResultType* result)
+{
+    static uint8_t buffer[READ_BUFFER_SIZE];
+    size_t length = 0;
+    bool headerRead = false;
+    long long nanosPerUnit = 1000;
+    long long firstNs = 0;
+    long long lastNs = 0;
+    unsigned long countStartFrames = 0;
+
+    while (result->frames < frames)
+    {
+        struct pollfd pfd = { .fd = fifoFd, .events = POLLIN };
+        if (poll(&pfd, 1, STALL_TIMEOUT_MS) <= 0)
+        {
+            fprintf(stderr, "stalled after %lu of %lu records\n", result->frames, frames);
+            return -1;
+        }
+        ssize_t received = read(fifoFd, &buffer[length], sizeof(buffer) - length);
+        if (received <= 0)
+        {
+            fprintf(stderr, "the plugin closed the FIFO after %lu of %lu records\n", result->frames, frames);
+            return -1;
+        }
+        long long nowNs = getRealtimeNanos();
+        length += (size_t)received;
+
+        size_t pos = 0;
+        if ((headerRead == false) && (length >= PCAP_HEADER_SIZE))
+        {
+            /* the magic number tells the precision of the timestamps */
+            nanosPerUnit = (readLittleEndian32(buffer) == 0xa1b23c4d) ? 1 : 1000;
+            pos = PCAP_HEADER_SIZE;
+            headerRead = true;
+        }
+        while ((headerRead == true) && ((length - pos) >= PCAP_RECORD_HEADER_SIZE))
+        {
+            uint32_t capturedLength = readLittleEndian32(&buffer[pos + 8]);
+            if ((length - pos) < (PCAP_RECORD_HEADER_SIZE + capturedLength))
+            {
+                break;
+            }
+            long long timestampNs = (long long)readLittleEndian32(&buffer[pos]) * 1000000000LL
+                                  + (long long)readLittleEndian32(&buffer[pos + 4]) * nanosPerUnit;
+            if (result->frames < frames)
+            {
+                result->latenciesNs[result->frames++] = nowNs - timestampNs;
+                result->bytes += capturedLength;
+            }
+            pos += PCAP_RECORD_HEADER_SIZE + capturedLength;
+        }
+        memmove(buffer, &buffer[pos], length - pos);
+        length -= pos;
+
+        if ((counter > 0) && (countStartFrames == 0) && (result->frames > 0))
+        {
+            kill(counter, SIGUSR1);
+            countStartFrames = result->frames;
+        }
+
+        if (firstNs == 0)
+        {
+            firstNs = nowNs;
+        }
+        lastNs = nowNs;
+    }
+    result->seconds = (double)(lastNs - firstNs) / 1e9;
+    result->syscallFrames = frames - countStartFrames;
+    return 0;
+}
+
+/** Runs a profile. If countSyscalls is set, only the system calls of the
+    plugin are valid results. */
+static int runProfile(const ProfileType* profile,
+                      unsigned long frames,
+                      const char* fifoPath,
+                      int extraArgc,
+                      char* extraArgv[],
+                      bool countSyscalls,
+                      ResultType* result)
+{
+    char portPath[128];
+    char fifoPathArg[256];
+    snprintf(fifoPathArg, sizeof(fifoPathArg), "%s", fifoPath);
+    unlink(fifoPath);
+    if (mkfifo(fifoPath, 0600) != 0)
+    {
+        perror(fifoPath);
+        return -1;
+    }
+    pid_t simulator = startSimulator(profile, frames, portPath, sizeof(portPath));
+    if (simulator < 0)
+    {
+        return -1;
+    }
+    int countFds[2] = { -1, -1 };
+    if ((countSyscalls == true) && (pipe(countFds) != 0))
+    {
+        perror("pipe");
+        countFds[0] = -1;
+        countFds[1] = -1;
+    }
+    pid_t plugin = startPlugin(profile, portPath, fifoPathArg, extraArgc, extraArgv, countFds[1]);
+    if (countFds[1] >= 0)
+    {
+        close(countFds[1]);
+    }
+    int rv = -1;
+    if (plugin > 0)
+    {
+        int fifoFd = open(fifoPath, O_RDONLY);
+        if (fifoFd >= 0)
+        {
+            rv = readRecords(fifoFd, frames, (countFds[0] >= 0) ? plugin : -1, result);
+            kill(plugin, SIGTERM);
+            result->syscalls = SYSCALLS_UNKNOWN;
+            if ((countFds[0] >= 0)
+                && (read(countFds[0], &result->syscalls, sizeof(result->syscalls)) != (ssize_t)sizeof(result->syscalls)))
+            {
+                result->syscalls = SYSCALLS_UNKNOWN;
+            }
+
+            int status;
+            struct rusage usage;
+            wait4(plugin, &status, 0, &usage);
+            close(fifoFd);
+            result->cpuSeconds = (double)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+                               + (double)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+            result->contextSwitches = usage.ru_nvcsw + usage.ru_nivcsw;
+            result->peakRssKB = usage.ru_maxrss;
+        }
+        else
+        {
+            perror(fifoPath);
+            kill(plugin, SIGTERM);
+            waitpid(plugin, NULL, 0);
+        }
+    }
+    if (countFds[0] >= 0)
+    {
+        close(countFds[0]);
+    }
+    kill(simulator, SIGTERM);
+    waitpid(simulator, NULL, 0);
+    unlink(fifoPath);
+    return rv;
+}
+
+static void printResult(const ProfileType* profile,
+                        ResultType* result)
+{
+    qsort(result->latenciesNs, result->frames, sizeof(long long), compareLongLongs);
+    double frames = (double)result->frames;
+    double seconds = (result->seconds > 0.0) ? result->seconds : 1e-9;
+    char syscalls[16] = "n/a";
+    if ((result->syscalls != SYSCALLS_UNKNOWN) && (result->syscallFrames > 0))
+    {
+        snprintf(syscalls, sizeof(syscalls), "%.3f", (double)result->syscalls / (double)result->syscallFrames);
+    }
+    printf("%-14s %7lu %9.0f %7.3f %8.1f %8.1f %8.1f %8.3f %8s %8.3f %7ld\n",
+           profile->name,
+           result->frames,
+           frames / seconds,
+           (double)result->bytes / seconds / 1e6,
+           (double)result->latenciesNs[(size_t)(0.5 * (frames - 1))] / 1e3,
+           (double)result->latenciesNs[(size_t)(0.99 * (frames - 1))] / 1e3,
+           (double)result->latenciesNs[(size_t)(0.999 * (frames - 1))] / 1e3,
+           result->cpuSeconds * 1e6 / frames,
+           syscalls,
+           (double)result->contextSwitches / frames,
+           result->peakRssKB);
+}
+
+/** Gets the value of a metric of the baseline file.
+ *
+ * \returns 0: on success.
+ * \returns -1: if the metric is unknown.
+ * \returns -2: if the metric has not been measured.
+ */
+static int getMetric(const ResultType* result,
+                     const char* metric,
+                     double* value,
+                     bool* higherIsBetter)
+{
+    double frames = (double)result->frames;
+    if (strcmp(metric, "frames/s") == 0)
+    {
+        *value = frames / ((result->seconds > 0.0) ? result->seconds : 1e-9);
+        *higherIsBetter = true;
+        return 0;
+    }
+    if (strcmp(metric, "syscalls/frame") == 0)
+    {
+        if ((result->syscalls == SYSCALLS_UNKNOWN) || (result->syscallFrames == 0))
+        {
+            return -2;
+        }
+        *value = (double)result->syscalls / (double)result->syscallFrames;
+        *higherIsBetter = false;
+        return 0;
+    }
+    if (strcmp(metric, "rss_kB") == 0)
+    {
+        *value = (double)result->peakRssKB;
+        *higherIsBetter = false;
+        return 0;
+    }
+    return -1;
+}
+
+/** Compares the result of a profile to the baseline.
+ *
+ * \returns the number of regressed metrics, or -1 if the baseline is invalid
+ *          or holds no metric of the profile.
+ */
+static int checkBaseline(const char* path,
+                         const ProfileType* profile,
+                         const ResultType* result)
+{
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    int regressions = 0;
+    int checked = 0;
+    char line[MAX_BASELINE_LINE];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char name[64];
+        char metric[32];
+        double baseline;
+        double tolerancePercent;
+        if ((line[0] == '#') || (sscanf(line, "%63s %31s %lf %lf", name, metric, &baseline, &tolerancePercent) != 4)
+            || (strcmp(name, profile->name) != 0))
+        {
+            continue;
+        }
+        double value;
+        bool higherIsBetter;
+        int rv = getMetric(result, metric, &value, &higherIsBetter);
+        if (rv == -2)
+        {
+            printf("%-14s %-14s not measured, not checked\n", profile->name, metric);
+            continue;
+        }
+        if (rv != 0)
+        {
+            fprintf(stderr, "unknown metric '%s' in %s\n", metric, path);
+            fclose(file);
+            return -1;
+        }
+        double limit = higherIsBetter ? (baseline * (1.0 - tolerancePercent / 100.0))
+                                      : (baseline * (1.0 + tolerancePercent / 100.0));
+        bool regressed = higherIsBetter ? (value < limit) : (value > limit);
+        printf("%-14s %-14s %12.3f baseline %12.3f limit %12.3f %s\n",
+               profile->name, metric, value, baseline, limit, regressed ? "REGRESSION" : "ok");
+        regressions += regressed ? 1 : 0;
+        checked++;
+    }
+    fclose(file);
+    if (checked == 0)
+    {
+        fprintf(stderr, "no baseline of profile %s in %s\n", profile->name, path);
+        return -1;
+    }
+    return regressions;
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int main(int argc, char* argv[])
+{
+    /* the options end at "--", the rest is passed to the plugin */
+    int optionCount = argc;
+    for (int i=1; i<argc; i++)
+    {
+        if (strcmp(argv[i], "--") == 0)
+        {
+            optionCount = i;
+            break;
+        }
+    }
+    int extraArgc = (optionCount < argc) ? (argc - optionCount - 1) : 0;
+    char** extraArgv = &argv[(optionCount < argc) ? (optionCount + 1) : argc];
+
+    unsigned long framesOverride = 0;
+    ARGP_getUnsignedLongOfArgs(optionCount, argv, "--frames", &framesOverride);
+    char* profileName = NULL;
+    ARGP_getP2StringOfArgs(optionCount, argv, "--profile", &profileName);
+    char* baselinePath = NULL;
+    ARGP_getP2StringOfArgs(optionCount, argv, "--baseline", &baselinePath);
+
+    char tempDir[] = "/tmp/capturebenchmark.XXXXXX";
+    if (mkdtemp(tempDir) == NULL)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    char fifoPath[sizeof(tempDir) + 16];
+    snprintf(fifoPath, sizeof(fifoPath), "%s/capture.fifo", tempDir);
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("%-14s %7s %9s %7s %8s %8s %8s %8s %8s %8s %7s\n",
+           "profile", "frames", "frames/s", "MB/s", "p50 us", "p99 us", "p999 us",
+           "CPU us/f", "sc/f", "cs/f", "RSS kB");
+    int failed = 0;
+    for (size_t i=0; i<ARRAY_LENGTH(PROFILES); i++)
+    {
+        const ProfileType* profile = &PROFILES[i];
+        if ((profileName != NULL) && (strcmp(profileName, profile->name) != 0))
+        {
+            continue;
+        }
+        unsigned long frames = (framesOverride > 0) ? framesOverride : profile->frames;
+        ResultType result;
+        memset(&result, 0, sizeof(result));
+        result.latenciesNs = malloc(frames * sizeof(long long));
+        if (result.latenciesNs == NULL)
+        {
+            failed++;
+            continue;
+        }
+        /* the counting run shares the buffer of the latencies, which are
+           overwritten by the timed run */
+        ResultType counted = result;
+        if ((runProfile(profile, frames, fifoPath, extraArgc, extraArgv, true, &counted) == 0)
+            && (runProfile(profile, frames, fifoPath, extraArgc, extraArgv, false, &result) == 0))
+        {
+            result.syscalls = counted.syscalls;
+            result.syscallFrames = counted.syscallFrames;
+            printResult(profile, &result);
+            if ((baselinePath != NULL) && (checkBaseline(baselinePath, profile, &result) != 0))
+            {
+                failed++;
+            }
+        }
+        else
+        {
+            printf("%-14s failed\n", profile->name);
+            failed++;
+        }
+        fflush(stdout);
+        free(result.latenciesNs);
+    }
+    rmdir(tempDir);
+    return (failed == 0) ? 0 : 1;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
@@ -0,0 +1,512 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \brief Micro-benchmarks of the functions called per byte or per frame on
+ *        the capture path: the ring buffers, the pcap writer, the capture
+ *        adapter, the frame decoder and the timestamp conversion.
+ *
+ * Every benchmark reports the time per operation and, if the perf counters
+ * of the kernel are accessible, the instructions retired per operation. The
+ * counters are unavailable e.g. in containers or with a restrictive
+ * kernel.perf_event_paranoid setting, "n/a" is reported then.
+ *
+ * The frames are written to /dev/null, to measure the cost of the system
+ * calls, and to a FIFO drained by a child process, which adds the cost of
+ * waking up the reader. "wrapped" frames are split across two chunks passed
+ * to the decoder, like frames crossing the end of the receive buffer, and
+ * thus copied by it; "unwrapped" frames are decoded in place.
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "capturino2pcapadptr.h"
+#include "capturinodecoder.h"
+#include "driftestimator.h"
+#include "pcap_writer.h"
+#include "pipehandling.h"
+#include "ringbuf.h"
+#include "timestampunwrapper.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+#define BUFFER_SIZE             (4096)
+/** a DLT 148 frame: timestamp, length and 8 bytes of payload */
+#define FRAME_SIZE              (13)
+#define PAYLOAD_SIZE            (8)
+/** frames decoded per call to CDEC_Feed() */
+#define FRAMES_PER_CHUNK        (64)
+#define PCAP_RECORD_HEADER_SIZE (16)
+#define ITERATIONS              (2000000)
+/** iterations of benchmarks doing a system call per operation */
+#define SYSCALL_ITERATIONS      (200000)
+/** first timestamp of the device, the counter wraps during the benchmarks */
+#define START_MICROS            (0xFFF00000UL)
+/** host time at START_MICROS */
+#define START_HOST_NANOS        (1700000000000000000ULL)
+/** the device clock runs slower than the host clock by 20 ppm */
+#define DEVICE_SKEW_PPM         (20)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+/** Runs the benchmarked operation the given number of times. */
+typedef void (*BenchmarkFnType)(size_t iterations);
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+static const uint8_t mFrame[FRAME_SIZE] = { 0x00, 0x01, 0x02, 0x03, PAYLOAD_SIZE, 'C', 'A', 'P', 'T', 'U', 'R', 'i', 'n' };
+/** standard CAN frame: identifier 0x123, DLC 8 and the data */
+static const uint8_t mStandardCanFrame[] = { 0x01, 0x23, 8, 1, 2, 3, 4, 5, 6, 7, 8 };
+/** extended CAN frame: identifier 0x12345678, DLC 8 and the data */
+static const uint8_t mExtendedCanFrame[] = { 0x92, 0x34, 0x56, 0x78, 8, 1, 2, 3, 4, 5, 6, 7, 8 };
+static uint8_t mStorage[BUFFER_SIZE];
+static uint8_t mChunk[FRAMES_PER_CHUNK * FRAME_SIZE];
+static uint8_t mRecord[PCAP_RECORD_HEADER_SIZE + PAYLOAD_SIZE];
+/** destination of the benchmarks writing frames */
+static CaptureOutputType mOutput;
+/** timeline of the device, as kept by the capture interface */
+static TSUW_UnwrapperType mUnwrapper;
+static DRFT_EstimatorType mDrift;
+static uint32_t mDeviceMicros;
+/** prevents the compiler from optimizing the benchmarked code away */
+static volatile uint32_t mSink;
+static int mInstructionCounter = -1;
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static double getSeconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/** Opens a counter of the instructions retired by this process. The
+    instructions in kernel space are only counted if permitted. */
+static int openInstructionCounter(void)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd < 0)
+    {
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+static void startInstructionCounter(void)
+{
+#ifdef __linux__
+    if (mInstructionCounter >= 0)
+    {
+        ioctl(mInstructionCounter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(mInstructionCounter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+/** \returns the instructions since startInstructionCounter() or -1 */
+static long long stopInstructionCounter(void)
+{
+#ifdef __linux__
+    long long count;
+    if ((mInstructionCounter >= 0)
+        && (ioctl(mInstructionCounter, PERF_EVENT_IOC_DISABLE, 0) == 0)
+        && (read(mInstructionCounter, &count, sizeof(count)) == (ssize_t)sizeof(count)))
+    {
+        return count;
+    }
+#endif
+    return -1;
+}
+
+static void runBenchmark(const char* name,
+                         BenchmarkFnType fn,
+                         size_t iterations)
+{
+    /* warm up the caches and the branch predictors */
+    fn(iterations / 10);
+
+    startInstructionCounter();
+    double start = getSeconds();
+    fn(iterations);
+    double seconds = getSeconds() - start;
+    long long instructions = stopInstructionCounter();
+
+    if (instructions >= 0)
+    {
+        printf("%-40s %9.2f ns/op %9.1f instructions/op\n",
+               name, seconds * 1e9 / (double)iterations, (double)instructions / (double)iterations);
+    }
+    else
+    {
+        printf("%-40s %9.2f ns/op %9s instructions/op\n",
+               name, seconds * 1e9 / (double)iterations, "n/a");
+    }
+}
+
+static void benchmarkRingBufHeadTail(size_t iterations)
+{
+    RingBufType ringBuf = {
+        .head = 0,
+        .tail = 0,
+        .elementSize = 1,
+        .buffer = mStorage,
+        .bufferSize = BUFFER_SIZE
+    };
+    for (size_t i=0; i<iterations; i++)
+    {
+        *((uint8_t*)RingBuf_getHead(&ringBuf)) = (uint8_t)i;
+        RingBuf_increaseHead(&ringBuf);
+        mSink = *((uint8_t*)RingBuf_getTail(&ringBuf));
+        RingBuf_increaseTail(&ringBuf);
+    }
+}
+
+static void benchmarkRingBufTailOffset(size_t iterations)
+{
+    RingBufType ringBuf = {
+        .head = BUFFER_SIZE - 1,
+        .tail = BUFFER_SIZE / 2,
+        .elementSize = 1,
+        .buffer = mStorage,
+        .bufferSize = BUFFER_SIZE
+    };
+    for (size_t i=0; i<iterations; i++)
+    {
+        mSink = *((uint8_t*)RingBuf_getTailOffset(&ringBuf, i % 64));
+    }
+}
+
+static void benchmarkRingBufP2WriteRead(size_t iterations)
+{
+    RingBufP2Type ringBuf;
+    uint8_t frame[FRAME_SIZE];
+    RingBufP2_init(&ringBuf, mStorage, BUFFER_SIZE);
+    for (size_t i=0; i<iterations; i++)
+    {
+        RingBufP2_write(&ringBuf, mFrame, FRAME_SIZE);
+        RingBufP2_read(&ringBuf, frame, FRAME_SIZE);
+        mSink = frame[FRAME_SIZE - 1];
+    }
+}
+
+/** Starts the timeline and feeds the drift estimation until it has an
+    estimate of the skew. */
+static void initTimeline(void)
+{
+    mDeviceMicros = START_MICROS;
+    TSUW_Init(&mUnwrapper, mDeviceMicros, 0);
+    DRFT_Init(&mDrift, mDeviceMicros, START_HOST_NANOS);
+    for (uint64_t micros=0; micros<=(DRFT_MIN_FIT_SAMPLES + 1) * DRFT_BUCKET_MICROS; micros+=100000)
+    {
+        DRFT_AddSample(&mDrift, START_MICROS + micros,
+                       START_HOST_NANOS + micros * 1000 + micros * DEVICE_SKEW_PPM / 1000);
+    }
+}
+
+/** Converts the next timestamp of the device like the capture interface,
+    one microsecond after the previous one. */
+static uint64_t nextHostNanos(void)
+{
+    mDeviceMicros++;
+    uint64_t extendedMicros = TSUW_Unwrap(&mUnwrapper, mDeviceMicros,
+                                          (uint32_t)((mDeviceMicros - START_MICROS) / 1000));
+    return DRFT_ToHostNanos(&mDrift, extendedMicros);
+}
+
+static void benchmarkTimestampConversion(size_t iterations)
+{
+    initTimeline();
+    for (size_t i=0; i<iterations; i++)
+    {
+        mSink = (uint32_t)nextHostNanos();
+    }
+}
+
+static void benchmarkFillPacketRecordHeader(size_t iterations)
+{
+    PCAP_PacketRecordHeaderType header = {
+        .timestampSeconds = 1700000000,
+        .timestampMicrosOrNanos = 0,
+        .protocolPayloadLength = PAYLOAD_SIZE
+    };
+    for (size_t i=0; i<iterations; i++)
+    {
+        header.timestampMicrosOrNanos = (uint32_t)i;
+        PCAP_FillPacketRecordHeader(&header, mRecord);
+        mSink = mRecord[4];
+    }
+}
+
+static void benchmarkWritePacketRecord(size_t iterations)
+{
+    PCAP_PacketRecordHeaderType header = {
+        .timestampSeconds = 1700000000,
+        .timestampMicrosOrNanos = 0,
+        .protocolPayloadLength = PAYLOAD_SIZE
+    };
+    PCAP_FillPacketRecordHeader(&header, mRecord);
+    for (size_t i=0; i<iterations; i++)
+    {
+        PCAP_WritePacketRecord(mOutput.fifoPipe, mRecord);
+    }
+    PCAP_Flush(mOutput.fifoPipe);
+}
+
+static void benchmarkCaptureDataFrame(size_t iterations)
+{
+    initTimeline();
+    for (size_t i=0; i<iterations; i++)
+    {
+        captureDataFrameAt(&mOutput, PCAP_USER1UART, nextHostNanos(), &mFrame[5], PAYLOAD_SIZE);
+    }
+    PCAP_Flush(mOutput.fifoPipe);
+}
+
+static void benchmarkCaptureStandardCan(size_t iterations)
+{
+    for (size_t i=0; i<iterations; i++)
+    {
+        captureDataFrameAt(&mOutput, PCAP_SOCKETCAN, (uint64_t)i * 1000ULL,
+                           mStandardCanFrame, sizeof(mStandardCanFrame));
+    }
+    PCAP_Flush(mOutput.fifoPipe);
+}
+
+static void benchmarkCaptureExtendedCan(size_t iterations)
+{
+    for (size_t i=0; i<iterations; i++)
+    {
+        captureDataFrameAt(&mOutput, PCAP_SOCKETCAN, (uint64_t)i * 1000ULL,
+                           mExtendedCanFrame, sizeof(mExtendedCanFrame));
+    }
+    PCAP_Flush(mOutput.fifoPipe);
+}
+
+static int onFrame(void* cbArg,
+                   uint32_t timestampMicros,
+                   const uint8_t* payload,
+                   size_t payloadLength)
+{
+    (void)cbArg;
+    (void)timestampMicros;
+    /* the timestamps of the chunk repeat, the conversion takes the next one */
+    return captureDataFrameAt(&mOutput, PCAP_USER1UART, nextHostNanos(), payload, payloadLength);
+}
+
+/** Decodes chunks of FRAMES_PER_CHUNK frames and writes them. The chunks are
+    shifted by the given offset, so every frame at the border is split. */
+static void decodeChunks(size_t iterations,
+                         size_t offset)
+{
+    CDEC_DecoderType decoder;
+    CDEC_Init(&decoder, onFrame, NULL, NULL);
+    initTimeline();
+    if (offset > 0)
+    {
+        CDEC_Feed(&decoder, mChunk, offset);
+    }
+    for (size_t i=0; i<iterations; i+=FRAMES_PER_CHUNK)
+    {
+        CDEC_Feed(&decoder, &mChunk[offset], sizeof(mChunk) - offset);
+        CDEC_Feed(&decoder, mChunk, offset);
+    }
+    PCAP_Flush(mOutput.fifoPipe);
+}
+
+static void benchmarkDecodeUnwrapped(size_t iterations)
+{
+    decodeChunks(iterations, 0);
+}
+
+static void benchmarkDecodeWrapped(size_t iterations)
+{
+    /* within the header of the first frame */
+    decodeChunks(iterations, 3);
+}
+
+/** Opens a FIFO whose content is discarded by a child process. */
+static pid_t openDrainedFifo(const char* path,
+                             PipeHandleType* pipeHandle)
+{
+    unlink(path);
+    if (mkfifo(path, 0600) != 0)
+    {
+        perror(path);
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        static uint8_t buffer[65536];
+        int fd = open(path, O_RDONLY);
+        while ((fd >= 0) && (read(fd, buffer, sizeof(buffer)) > 0))
+        {
+        }
+        _exit(0);
+    }
+    if ((pid < 0) || (PIPH_Open(path, pipeHandle) != 0))
+    {
+        fprintf(stderr, "opening the FIFO %s failed\n", path);
+        return -1;
+    }
+    return pid;
+}
+
+/** Runs the benchmarks writing frames, once without and once with the write
+    buffer of the pcap writer. */
+static void runWriteBenchmarks(const char* target)
+{
+    static const struct
+    {
+        const char*     name;
+        BenchmarkFnType fn;
+    } BENCHMARKS[] = {
+        { "PCAP_WritePacketRecord",        benchmarkWritePacketRecord },
+        { "captureDataFrameAt 148",        benchmarkCaptureDataFrame },
+        { "captureDataFrameAt 227 std",    benchmarkCaptureStandardCan },
+        { "captureDataFrameAt 227 ext",    benchmarkCaptureExtendedCan },
+        { "CDEC_Feed+capture unwrapped",   benchmarkDecodeUnwrapped },
+        { "CDEC_Feed+capture wrapped",     benchmarkDecodeWrapped }
+    };
+    for (size_t buffered=0; buffered<2; buffered++)
+    {
+        PCAP_SetFlushLatency((buffered == 1) ? PCAP_DEFAULT_FLUSH_LATENCY_MS : 0);
+        for (size_t i=0; i<(sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0])); i++)
+        {
+            char name[64];
+            snprintf(name, sizeof(name), "%s %s%s", BENCHMARKS[i].name, target,
+                     (buffered == 1) ? " buf" : "");
+            runBenchmark(name, BENCHMARKS[i].fn, (buffered == 1) ? ITERATIONS : SYSCALL_ITERATIONS);
+        }
+    }
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int main(void)
+{
+    for (size_t i=0; i<FRAMES_PER_CHUNK; i++)
+    {
+        memcpy(&mChunk[i * FRAME_SIZE], mFrame, FRAME_SIZE);
+    }
+    mInstructionCounter = openInstructionCounter();
+    if (mInstructionCounter < 0)
+    {
+        printf("perf counters are not available, instructions are not counted\n");
+    }
+
+    runBenchmark("RingBuf_increaseHead/Tail",       benchmarkRingBufHeadTail, ITERATIONS);
+    runBenchmark("RingBuf_getTailOffset",           benchmarkRingBufTailOffset, ITERATIONS);
+    runBenchmark("RingBufP2_write/read 13 B",       benchmarkRingBufP2WriteRead, ITERATIONS);
+    runBenchmark("PCAP_FillPacketRecordHeader",     benchmarkFillPacketRecordHeader, ITERATIONS);
+    runBenchmark("TSUW_Unwrap+DRFT_ToHostNanos",    benchmarkTimestampConversion, ITERATIONS);
+
+    mOutput.format = CAPT_FORMAT_PCAP;
+    mOutput.interfaceId = 0;
+    if (PIPH_Open("/dev/null", &mOutput.fifoPipe) == 0)
+    {
+        runWriteBenchmarks("null");
+        PIPH_Close(mOutput.fifoPipe);
+    }
+
+    char fifoPath[] = "/tmp/capturepathbenchmark.XXXXXX";
+    if (mkdtemp(fifoPath) == NULL)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    char path[sizeof(fifoPath) + 16];
+    snprintf(path, sizeof(path), "%s/fifo", fifoPath);
+    pid_t drain = openDrainedFifo(path, &mOutput.fifoPipe);
+    if (drain > 0)
+    {
+        runWriteBenchmarks("pipe");
+        PIPH_Close(mOutput.fifoPipe);
+        waitpid(drain, NULL, 0);
+    }
+    unlink(path);
+    rmdir(fifoPath);
+    return 0;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
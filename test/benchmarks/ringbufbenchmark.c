@@ -0,0 +1,255 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \brief Micro-benchmark of the ring buffer variants. Measures the cost per
+ *        byte of parsing frame headers out of the buffer and of copying
+ *        frames through the buffer, once with RingBufType and once with
+ *        RingBufP2Type.
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "ringbuf.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+#define BUFFER_SIZE         (4096)
+/** a DLT 148 frame: timestamp, length and 8 bytes of payload */
+#define FRAME_SIZE          (13)
+#define PAYLOAD_SIZE        (8)
+#define FRAMES_PER_ROUND    (256)
+#define ROUNDS              (20000)
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+static uint8_t mFrame[FRAME_SIZE] = { 0x00, 0x01, 0x02, 0x03, PAYLOAD_SIZE, 'C', 'A', 'P', 'T', 'U', 'R', 'i', 'n' };
+static uint8_t mLegacyStorage[BUFFER_SIZE];
+static uint8_t mP2Storage[BUFFER_SIZE];
+/** prevents the compiler from optimizing the benchmarked code away */
+static volatile uint32_t mSink;
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static double getSeconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void legacyWrite(RingBufType* ringBuf, const uint8_t* data, size_t length)
+{
+    size_t freeBytesAtOnce = RingBuf_getFreeElementsHead2End(ringBuf);
+    if (freeBytesAtOnce >= length)
+    {
+        memcpy(RingBuf_getHead(ringBuf), data, length);
+        RingBuf_increaseHeadMore(ringBuf, length);
+    }
+    else
+    {
+        memcpy(RingBuf_getHead(ringBuf), data, freeBytesAtOnce);
+        RingBuf_increaseHeadMore(ringBuf, freeBytesAtOnce);
+        memcpy(RingBuf_getHead(ringBuf), data + freeBytesAtOnce, length - freeBytesAtOnce);
+        RingBuf_increaseHeadMore(ringBuf, length - freeBytesAtOnce);
+    }
+}
+
+/** Parses the frames like the capture loop did before the decoder module:
+    one RingBuf_getTailOffset() call per header byte. */
+static double benchmarkLegacyParse(void)
+{
+    RingBufType ringBuf = {
+        .head = 0,
+        .tail = 0,
+        .elementSize = 1,
+        .buffer = mLegacyStorage,
+        .bufferSize = BUFFER_SIZE
+    };
+    uint8_t payload[PAYLOAD_SIZE];
+    double start = getSeconds();
+    for (size_t round=0; round<ROUNDS; round++)
+    {
+        for (size_t i=0; i<FRAMES_PER_ROUND; i++)
+        {
+            legacyWrite(&ringBuf, mFrame, FRAME_SIZE);
+
+            uint32_t timestamp = 0;
+            for (size_t j=0; j<4; j++)
+            {
+                timestamp <<= 8;
+                timestamp += *((uint8_t*)RingBuf_getTailOffset(&ringBuf, j));
+            }
+            size_t length = *((uint8_t*)RingBuf_getTailOffset(&ringBuf, 4));
+            RingBuf_increaseTailMore(&ringBuf, 5);
+            size_t bytes2End = RingBuf_getFullElementsTail2End(&ringBuf);
+            if (bytes2End >= length)
+            {
+                memcpy(payload, RingBuf_getTail(&ringBuf), length);
+            }
+            else
+            {
+                memcpy(payload, RingBuf_getTail(&ringBuf), bytes2End);
+                memcpy(&payload[bytes2End], mLegacyStorage, length - bytes2End);
+            }
+            RingBuf_increaseTailMore(&ringBuf, length);
+            mSink = timestamp + payload[length - 1];
+        }
+    }
+    return getSeconds() - start;
+}
+
+static double benchmarkP2Parse(void)
+{
+    RingBufP2Type ringBuf;
+    RingBufP2_init(&ringBuf, mP2Storage, BUFFER_SIZE);
+    uint8_t payload[PAYLOAD_SIZE];
+    double start = getSeconds();
+    for (size_t round=0; round<ROUNDS; round++)
+    {
+        for (size_t i=0; i<FRAMES_PER_ROUND; i++)
+        {
+            RingBufP2_write(&ringBuf, mFrame, FRAME_SIZE);
+
+            uint8_t header[5];
+            RingBufP2_read(&ringBuf, header, sizeof(header));
+            uint32_t timestamp = ((uint32_t)header[0] << 24) | ((uint32_t)header[1] << 16)
+                               | ((uint32_t)header[2] <<  8) |  (uint32_t)header[3];
+            size_t length = header[4];
+            RingBufP2_read(&ringBuf, payload, length);
+            mSink = timestamp + payload[length - 1];
+        }
+    }
+    return getSeconds() - start;
+}
+
+/** Copies frames through the buffer in bulk, one round fills the buffer
+    partially and drains it again. */
+static double benchmarkLegacyCopy(void)
+{
+    RingBufType ringBuf = {
+        .head = 0,
+        .tail = 0,
+        .elementSize = 1,
+        .buffer = mLegacyStorage,
+        .bufferSize = BUFFER_SIZE
+    };
+    uint8_t frame[FRAME_SIZE];
+    double start = getSeconds();
+    for (size_t round=0; round<ROUNDS; round++)
+    {
+        for (size_t i=0; i<FRAMES_PER_ROUND; i++)
+        {
+            legacyWrite(&ringBuf, mFrame, FRAME_SIZE);
+        }
+        for (size_t i=0; i<FRAMES_PER_ROUND; i++)
+        {
+            size_t bytes2End = RingBuf_getFullElementsTail2End(&ringBuf);
+            if (bytes2End >= FRAME_SIZE)
+            {
+                memcpy(frame, RingBuf_getTail(&ringBuf), FRAME_SIZE);
+            }
+            else
+            {
+                memcpy(frame, RingBuf_getTail(&ringBuf), bytes2End);
+                memcpy(&frame[bytes2End], mLegacyStorage, FRAME_SIZE - bytes2End);
+            }
+            RingBuf_increaseTailMore(&ringBuf, FRAME_SIZE);
+            mSink = frame[FRAME_SIZE - 1];
+        }
+    }
+    return getSeconds() - start;
+}
+
+static double benchmarkP2Copy(void)
+{
+    RingBufP2Type ringBuf;
+    RingBufP2_init(&ringBuf, mP2Storage, BUFFER_SIZE);
+    uint8_t frame[FRAME_SIZE];
+    double start = getSeconds();
+    for (size_t round=0; round<ROUNDS; round++)
+    {
+        for (size_t i=0; i<FRAMES_PER_ROUND; i++)
+        {
+            RingBufP2_write(&ringBuf, mFrame, FRAME_SIZE);
+        }
+        for (size_t i=0; i<FRAMES_PER_ROUND; i++)
+        {
+            RingBufP2_read(&ringBuf, frame, FRAME_SIZE);
+            mSink = frame[FRAME_SIZE - 1];
+        }
+    }
+    return getSeconds() - start;
+}
+
+static void printResult(const char* name, double legacySeconds, double p2Seconds)
+{
+    const double bytes = (double)ROUNDS * FRAMES_PER_ROUND * FRAME_SIZE;
+    printf("%-8s RingBuf: %6.3f ns/byte   RingBufP2: %6.3f ns/byte   speedup: %5.2fx\n",
+           name,
+           legacySeconds * 1e9 / bytes,
+           p2Seconds * 1e9 / bytes,
+           legacySeconds / p2Seconds);
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int main(void)
+{
+    printResult("parse", benchmarkLegacyParse(), benchmarkP2Parse());
+    printResult("copy", benchmarkLegacyCopy(), benchmarkP2Copy());
+    return 0;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
@@ -0,0 +1,273 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \brief Unit tests of the capturinodecoder module. Every test feeds a byte
+ *        stream in different chunkings and compares the reported frames.
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "capturinodecoder.h"
+#include "testcheck.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+#define MAX_RECORDED_FRAMES     (16)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+typedef struct
+{
+    uint32_t       timestampMicros;
+    size_t         payloadLength;   /**< 0 for null frames */
+    const uint8_t* payloadPtr;
+    uint8_t        payload[CDEC_MAX_PAYLOAD_LENGTH];
+} RecordedFrameType;
+
+typedef struct
+{
+    size_t            count;
+    size_t            abortAfter;   /**< 0 to never abort */
+    RecordedFrameType frames[MAX_RECORDED_FRAMES];
+} RecorderType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N S T A N T   D E F I N I T I O N S * * * * * * * * * * * */
+/** short frame, extended length frame, null frame and a maximum size frame */
+static const uint8_t STREAM[] =
+{
+    0x00, 0x00, 0x00, 0x10,  0x03,  0x41, 0x42, 0x43,
+    0x00, 0x00, 0x01, 0x00,  0x80, 0x02,  0x55, 0xAA,
+    0x12, 0x34, 0x56, 0x78,  0x00,
+    0xFF, 0xFF, 0xFF, 0xFF,  0x40,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F,
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F
+};
+#define STREAM_FRAME_COUNT  (4)
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static int recordFrame(void* cbArg,
+                       uint32_t timestampMicros,
+                       const uint8_t* payload,
+                       size_t payloadLength)
+{
+    RecorderType* recorder = (RecorderType*)cbArg;
+    if (recorder->count < MAX_RECORDED_FRAMES)
+    {
+        RecordedFrameType* frame = &recorder->frames[recorder->count];
+        frame->timestampMicros = timestampMicros;
+        frame->payloadLength = payloadLength;
+        frame->payloadPtr = payload;
+        memcpy(frame->payload, payload, payloadLength);
+    }
+    recorder->count++;
+    return ((recorder->abortAfter != 0) && (recorder->count >= recorder->abortAfter)) ? 1 : 0;
+}
+
+static int recordNullFrame(void* cbArg,
+                           uint32_t timestampMicros)
+{
+    RecorderType* recorder = (RecorderType*)cbArg;
+    if (recorder->count < MAX_RECORDED_FRAMES)
+    {
+        recorder->frames[recorder->count].timestampMicros = timestampMicros;
+        recorder->frames[recorder->count].payloadLength = 0;
+        recorder->frames[recorder->count].payloadPtr = NULL;
+    }
+    recorder->count++;
+    return 0;
+}
+
+static int checkStreamFrames(const RecorderType* recorder)
+{
+    CHECK(recorder->count == STREAM_FRAME_COUNT);
+
+    CHECK(recorder->frames[0].timestampMicros == 0x10);
+    CHECK(recorder->frames[0].payloadLength == 3);
+    CHECK(memcmp(recorder->frames[0].payload, "ABC", 3) == 0);
+
+    CHECK(recorder->frames[1].timestampMicros == 0x100);
+    CHECK(recorder->frames[1].payloadLength == 2);
+    CHECK(recorder->frames[1].payload[0] == 0x55);
+    CHECK(recorder->frames[1].payload[1] == 0xAA);
+
+    CHECK(recorder->frames[2].timestampMicros == 0x12345678);
+    CHECK(recorder->frames[2].payloadLength == 0);
+
+    CHECK(recorder->frames[3].timestampMicros == 0xFFFFFFFF);
+    CHECK(recorder->frames[3].payloadLength == CDEC_MAX_PAYLOAD_LENGTH);
+    for (size_t i=0; i<CDEC_MAX_PAYLOAD_LENGTH; i++)
+    {
+        CHECK(recorder->frames[3].payload[i] == i);
+    }
+    return 0;
+}
+
+static int testWholeStreamIsNotCopied(void)
+{
+    RecorderType recorder = { 0 };
+    CDEC_DecoderType decoder;
+    CDEC_Init(&decoder, recordFrame, recordNullFrame, &recorder);
+
+    CHECK(CDEC_Feed(&decoder, STREAM, sizeof(STREAM)) == CDEC_OK);
+    CHECK(checkStreamFrames(&recorder) == 0);
+    /* complete frames must be passed on directly from the input */
+    CHECK(recorder.frames[0].payloadPtr == &STREAM[5]);
+    CHECK(recorder.frames[1].payloadPtr == &STREAM[14]);
+    CHECK(decoder.pendingLength == 0);
+    return 0;
+}
+
+static int testBytewiseFeed(void)
+{
+    RecorderType recorder = { 0 };
+    CDEC_DecoderType decoder;
+    CDEC_Init(&decoder, recordFrame, recordNullFrame, &recorder);
+
+    for (size_t i=0; i<sizeof(STREAM); i++)
+    {
+        CHECK(CDEC_Feed(&decoder, &STREAM[i], 1) == CDEC_OK);
+    }
+    return checkStreamFrames(&recorder);
+}
+
+static int testAllSplitPoints(void)
+{
+    for (size_t split=0; split<=sizeof(STREAM); split++)
+    {
+        RecorderType recorder = { 0 };
+        CDEC_DecoderType decoder;
+        CDEC_Init(&decoder, recordFrame, recordNullFrame, &recorder);
+
+        CHECK(CDEC_Feed(&decoder, STREAM, split) == CDEC_OK);
+        CHECK(CDEC_Feed(&decoder, &STREAM[split], sizeof(STREAM) - split) == CDEC_OK);
+        if (checkStreamFrames(&recorder) != 0)
+        {
+            printf("%s: failed with split at %lu\n", __func__, (unsigned long)split);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int testMalformedFrame(void)
+{
+    static const uint8_t malformed[] = { 0x00, 0x00, 0x00, 0x01,  0x80, CDEC_MAX_PAYLOAD_LENGTH + 1 };
+    RecorderType recorder = { 0 };
+    CDEC_DecoderType decoder;
+
+    /* detected as soon as the length is known, without waiting for the payload */
+    CDEC_Init(&decoder, recordFrame, recordNullFrame, &recorder);
+    CHECK(CDEC_Feed(&decoder, malformed, sizeof(malformed)) == CDEC_MALFORMED_FRAME);
+
+    CDEC_Init(&decoder, recordFrame, recordNullFrame, &recorder);
+    CHECK(CDEC_Feed(&decoder, malformed, 5) == CDEC_OK);
+    CHECK(CDEC_Feed(&decoder, &malformed[5], 1) == CDEC_MALFORMED_FRAME);
+    CHECK(recorder.count == 0);
+    return 0;
+}
+
+static int testHardwareError(void)
+{
+    static const uint8_t allNull[] = { 0x00, 0x00, 0x00, 0x00,  0x00 };
+    static const uint8_t nullFrame[] = { 0x00, 0x00, 0x00, 0x01,  0x00 };
+    RecorderType recorder = { 0 };
+    CDEC_DecoderType decoder;
+    CDEC_Init(&decoder, recordFrame, recordNullFrame, &recorder);
+
+    /* a single all null frame is a valid null frame */
+    CHECK(CDEC_Feed(&decoder, allNull, sizeof(allNull)) == CDEC_OK);
+    CHECK(CDEC_Feed(&decoder, nullFrame, sizeof(nullFrame)) == CDEC_OK);
+    CHECK(CDEC_Feed(&decoder, allNull, sizeof(allNull)) == CDEC_OK);
+    CHECK(recorder.count == 3);
+    /* two consecutive ones indicate an error of the device */
+    CHECK(CDEC_Feed(&decoder, allNull, sizeof(allNull)) == CDEC_HARDWARE_ERROR);
+    return 0;
+}
+
+static int testAbortByCallback(void)
+{
+    RecorderType recorder = { .count = 0, .abortAfter = 1 };
+    CDEC_DecoderType decoder;
+    CDEC_Init(&decoder, recordFrame, NULL, &recorder);
+
+    CHECK(CDEC_Feed(&decoder, STREAM, sizeof(STREAM)) == CDEC_ABORTED);
+    CHECK(recorder.count == 1);
+    return 0;
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int main(void)
+{
+    static const TEST_FunctionType TESTS[] = {
+        testWholeStreamIsNotCopied,
+        testBytewiseFeed,
+        testAllSplitPoints,
+        testMalformedFrame,
+        testHardwareError,
+        testAbortByCallback
+    };
+    return TEST_RUN_ALL(TESTS);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
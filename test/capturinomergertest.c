@@ -0,0 +1,275 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \brief Unit tests of the capturinomerger module. Every test pushes the
+ *        frames of several sources and compares the order they are released
+ *        in.
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "capturinomerger.h"
+#include "testcheck.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+#define MAX_RECORDED_FRAMES     (CMRG_QUEUE_LENGTH + 16)
+#define WINDOW_NANOS            (1000)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+typedef struct
+{
+    size_t   source;
+    uint64_t timestampNanos;
+    uint8_t  firstByte;
+} RecordedFrameType;
+
+typedef struct
+{
+    size_t            count;
+    RecordedFrameType frames[MAX_RECORDED_FRAMES];
+} RecorderType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+/** too large for the stack of every test */
+static CMRG_MergerType mMerger;
+static RecorderType mRecorder;
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static int recordFrame(void* cbArg,
+                       size_t source,
+                       const CMRG_FrameType* frame)
+{
+    RecorderType* recorder = (RecorderType*)cbArg;
+    if (recorder->count < MAX_RECORDED_FRAMES)
+    {
+        RecordedFrameType* recorded = &recorder->frames[recorder->count];
+        recorded->source = source;
+        recorded->timestampNanos = frame->timestampNanos;
+        recorded->firstByte = (frame->length > 0) ? frame->payload[0] : 0;
+    }
+    recorder->count++;
+    return 0;
+}
+
+static int failOnFrame(void* cbArg,
+                       size_t source,
+                       const CMRG_FrameType* frame)
+{
+    (void)cbArg;
+    (void)source;
+    (void)frame;
+    return -5;
+}
+
+static int push(size_t source, uint64_t timestampNanos, uint8_t firstByte)
+{
+    uint8_t payload[2] = { firstByte, 0x55 };
+    return CMRG_Push(&mMerger, source, timestampNanos, payload, sizeof(payload));
+}
+
+static void setUp(size_t sourceCount)
+{
+    memset(&mRecorder, 0, sizeof(mRecorder));
+    CMRG_Init(&mMerger, sourceCount, WINDOW_NANOS, recordFrame, &mRecorder);
+}
+
+static int testInterleavedSources(void)
+{
+    setUp(2);
+    CHECK(push(0, 100, 'a') == 0);
+    CHECK(push(0, 300, 'c') == 0);
+    /* source 1 has not delivered anything yet, nothing is certain */
+    uint64_t nextDueNanos = 0;
+    CHECK(CMRG_Emit(&mMerger, 0, &nextDueNanos) == 0);
+    CHECK(mRecorder.count == 0);
+    CHECK(nextDueNanos == 100 + WINDOW_NANOS);
+
+    CHECK(push(1, 200, 'b') == 0);
+    CHECK(push(1, 400, 'd') == 0);
+    CHECK(CMRG_Emit(&mMerger, 0, &nextDueNanos) == 0);
+    /* 400 is held back until source 0 reached it */
+    CHECK(mRecorder.count == 3);
+    CHECK(nextDueNanos == 400 + WINDOW_NANOS);
+    CHECK(mRecorder.frames[0].timestampNanos == 100);
+    CHECK(mRecorder.frames[0].source == 0);
+    CHECK(mRecorder.frames[0].firstByte == 'a');
+    CHECK(mRecorder.frames[1].timestampNanos == 200);
+    CHECK(mRecorder.frames[1].source == 1);
+    CHECK(mRecorder.frames[2].timestampNanos == 300);
+
+    CHECK(CMRG_Drain(&mMerger) == 0);
+    CHECK(mRecorder.count == 4);
+    CHECK(mRecorder.frames[3].firstByte == 'd');
+    CHECK(mMerger.framesOutOfOrder == 0);
+    return 0;
+}
+
+static int testNullFrameReleasesFrames(void)
+{
+    setUp(3);
+    CHECK(push(0, 500, 'a') == 0);
+    CHECK(CMRG_AdvanceSource(&mMerger, 1, 600) == 0);
+    CHECK(CMRG_Emit(&mMerger, 0, NULL) == 0);
+    CHECK(mRecorder.count == 0);
+    /* the reached time must not be older than the frame */
+    CHECK(CMRG_AdvanceSource(&mMerger, 2, 499) == 0);
+    CHECK(CMRG_Emit(&mMerger, 0, NULL) == 0);
+    CHECK(mRecorder.count == 0);
+    CHECK(CMRG_AdvanceSource(&mMerger, 2, 500) == 0);
+    CHECK(CMRG_Emit(&mMerger, 0, NULL) == 0);
+    CHECK(mRecorder.count == 1);
+    return 0;
+}
+
+static int testSilentSourceWindowExpires(void)
+{
+    setUp(2);
+    CHECK(push(0, 1000, 'a') == 0);
+    CHECK(push(0, 1500, 'b') == 0);
+    CHECK(CMRG_Emit(&mMerger, 1000 + WINDOW_NANOS - 1, NULL) == 0);
+    CHECK(mRecorder.count == 0);
+    uint64_t nextDueNanos = 0;
+    CHECK(CMRG_Emit(&mMerger, 1000 + WINDOW_NANOS, &nextDueNanos) == 0);
+    CHECK(mRecorder.count == 1);
+    CHECK(nextDueNanos == 1500 + WINDOW_NANOS);
+    CHECK(CMRG_Emit(&mMerger, 1500 + WINDOW_NANOS, &nextDueNanos) == 0);
+    CHECK(mRecorder.count == 2);
+    CHECK(nextDueNanos == CMRG_NOTHING_DUE);
+
+    /* a frame arriving after its window expired is still written */
+    CHECK(push(1, 1200, 'c') == 0);
+    CHECK(CMRG_Emit(&mMerger, 1500 + WINDOW_NANOS, NULL) == 0);
+    CHECK(mRecorder.count == 3);
+    CHECK(mMerger.framesOutOfOrder == 1);
+    return 0;
+}
+
+static int testEqualTimestamps(void)
+{
+    setUp(2);
+    CHECK(push(1, 700, 'b') == 0);
+    CHECK(push(0, 700, 'a') == 0);
+    CHECK(CMRG_Emit(&mMerger, 0, NULL) == 0);
+    CHECK(mRecorder.count == 2);
+    CHECK(mRecorder.frames[0].source == 0);
+    CHECK(mRecorder.frames[1].source == 1);
+    return 0;
+}
+
+static int testFullQueue(void)
+{
+    setUp(2);
+    for (size_t i=0; i<CMRG_QUEUE_LENGTH; i++)
+    {
+        CHECK(push(0, 10 + i, (uint8_t)i) == 0);
+    }
+    CHECK(mRecorder.count == 0);
+    /* no frame is lost, the oldest one is released instead */
+    CHECK(push(0, 10 + CMRG_QUEUE_LENGTH, 0xFF) == 0);
+    CHECK(mRecorder.count == 1);
+    CHECK(mRecorder.frames[0].timestampNanos == 10);
+    CHECK(CMRG_Drain(&mMerger) == 0);
+    CHECK(mRecorder.count == CMRG_QUEUE_LENGTH + 1);
+    for (size_t i=1; i<mRecorder.count; i++)
+    {
+        CHECK(mRecorder.frames[i].timestampNanos > mRecorder.frames[i-1].timestampNanos);
+    }
+    return 0;
+}
+
+static int testInvalidArguments(void)
+{
+    uint8_t payload[CDEC_MAX_PAYLOAD_LENGTH + 1] = { 0 };
+    CHECK(CMRG_Init(&mMerger, 0, WINDOW_NANOS, recordFrame, &mRecorder) != 0);
+    CHECK(CMRG_Init(&mMerger, CMRG_MAX_SOURCES + 1, WINDOW_NANOS, recordFrame, &mRecorder) != 0);
+    setUp(2);
+    CHECK(CMRG_Push(&mMerger, 2, 0, payload, 1) != 0);
+    CHECK(CMRG_Push(&mMerger, 0, 0, payload, sizeof(payload)) != 0);
+    CHECK(CMRG_AdvanceSource(&mMerger, 2, 0) != 0);
+    return 0;
+}
+
+static int testCallbackError(void)
+{
+    CMRG_Init(&mMerger, 1, WINDOW_NANOS, failOnFrame, NULL);
+    CHECK(push(0, 1, 'a') == 0);
+    CHECK(CMRG_Emit(&mMerger, 0, NULL) == -5);
+    return 0;
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int main(void)
+{
+    static const TEST_FunctionType TESTS[] = {
+        testInterleavedSources,
+        testNullFrameReleasesFrames,
+        testSilentSourceWindowExpires,
+        testEqualTimestamps,
+        testFullQueue,
+        testInvalidArguments,
+        testCallbackError
+    };
+    return TEST_RUN_ALL(TESTS);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
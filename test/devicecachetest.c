@@ -0,0 +1,276 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \brief Unit tests of the devicecache module. The cache file is written to
+ *        the working directory of the test.
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "devicecache.h"
+#include "systemutils.h"
+#include "testcheck.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+#define CACHE_FILE      "devicecachetest.cache"
+#define NOW             (1750000000ULL)
+#define TTL             (3600ULL)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+static DVCC_CacheType mCache;
+static DVCC_CacheType mLoadedCache;
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static DVCC_EntryType makeEntry(const char* portPath,
+                                const char* serialNumber,
+                                uint64_t validatedUnixTime)
+{
+    DVCC_EntryType entry;
+    memset(&entry, 0, sizeof(entry));
+    strcpy(entry.identity.portPath, portPath);
+    strcpy(entry.identity.serialNumber, serialNumber);
+    entry.identity.deviceId = 0xBC00ULL;
+    entry.identity.nodeId = 1234;
+    entry.identity.changeTime = NOW - 100000;
+    entry.validatedUnixTime = validatedUnixTime;
+    entry.boardId = 0x80000001;
+    entry.dlts[0] = 148;
+    entry.dlts[1] = 227;
+    entry.dltsCount = 2;
+    return entry;
+}
+
+static int testLookup(void)
+{
+    DVCC_Init(&mCache);
+    DVCC_EntryType entry = makeEntry("/dev/ttyUSB0", "A10K2X", NOW);
+    CHECK(DVCC_Lookup(&mCache, &entry.identity, NOW, TTL) == NULL);
+    CHECK(DVCC_Store(&mCache, &entry) == 0);
+
+    const DVCC_EntryType* found = DVCC_Lookup(&mCache, &entry.identity, NOW + 10, TTL);
+    CHECK(found != NULL);
+    CHECK(found->boardId == 0x80000001);
+    CHECK((found->dltsCount == 2) && (found->dlts[1] == 227));
+
+    DVCC_IdentityType otherPort = entry.identity;
+    strcpy(otherPort.portPath, "/dev/ttyUSB1");
+    CHECK(DVCC_Lookup(&mCache, &otherPort, NOW, TTL) == NULL);
+    return 0;
+}
+
+static int testIdentityChanged(void)
+{
+    DVCC_Init(&mCache);
+    DVCC_EntryType entry = makeEntry("/dev/ttyACM0", "0001", NOW);
+    CHECK(DVCC_Store(&mCache, &entry) == 0);
+
+    DVCC_IdentityType identity = entry.identity;
+    strcpy(identity.serialNumber, "0002");
+    CHECK(DVCC_Lookup(&mCache, &identity, NOW, TTL) == NULL);
+    /* the device node was created again on reconnecting the device */
+    identity = entry.identity;
+    identity.nodeId++;
+    CHECK(DVCC_Lookup(&mCache, &identity, NOW, TTL) == NULL);
+    identity = entry.identity;
+    identity.changeTime++;
+    CHECK(DVCC_Lookup(&mCache, &identity, NOW, TTL) == NULL);
+    return 0;
+}
+
+static int testExpiry(void)
+{
+    DVCC_Init(&mCache);
+    DVCC_EntryType entry = makeEntry("COM3", "", NOW);
+    CHECK(DVCC_Store(&mCache, &entry) == 0);
+    CHECK(DVCC_Lookup(&mCache, &entry.identity, NOW + TTL - 1, TTL) != NULL);
+    CHECK(DVCC_Lookup(&mCache, &entry.identity, NOW + TTL, TTL) == NULL);
+    /* the clock of the host was set back */
+    CHECK(DVCC_Lookup(&mCache, &entry.identity, NOW - 1, TTL) == NULL);
+
+    /* revalidating the entry replaces it */
+    entry.validatedUnixTime = NOW + TTL;
+    CHECK(DVCC_Store(&mCache, &entry) == 0);
+    CHECK(mCache.count == 1);
+    CHECK(DVCC_Lookup(&mCache, &entry.identity, NOW + TTL, TTL) != NULL);
+    return 0;
+}
+
+static int testEviction(void)
+{
+    DVCC_Init(&mCache);
+    char portPath[DVCC_MAX_PORT_LENGTH];
+    for (size_t i=0; i<DVCC_MAX_ENTRIES; i++)
+    {
+        snprintf(portPath, sizeof(portPath), "/dev/ttyUSB%lu", (unsigned long)i);
+        /* ttyUSB5 was validated at the earliest */
+        DVCC_EntryType entry = makeEntry(portPath, "S", NOW - ((i == 5) ? 100 : i));
+        CHECK(DVCC_Store(&mCache, &entry) == 0);
+    }
+    CHECK(mCache.count == DVCC_MAX_ENTRIES);
+
+    DVCC_EntryType entry = makeEntry("/dev/ttyACM0", "S", NOW);
+    CHECK(DVCC_Store(&mCache, &entry) == 0);
+    CHECK(mCache.count == DVCC_MAX_ENTRIES);
+    CHECK(DVCC_Lookup(&mCache, &entry.identity, NOW, TTL) != NULL);
+    DVCC_EntryType evicted = makeEntry("/dev/ttyUSB5", "S", NOW);
+    CHECK(DVCC_Lookup(&mCache, &evicted.identity, NOW, TTL) == NULL);
+
+    DVCC_EntryType unstorable = makeEntry("/dev/tty\tUSB", "S", NOW);
+    CHECK(DVCC_Store(&mCache, &unstorable) == -1);
+    return 0;
+}
+
+static int testSaveAndLoad(void)
+{
+    DVCC_Init(&mCache);
+    DVCC_EntryType first = makeEntry("/dev/ttyUSB0", "A10K2X", NOW);
+    DVCC_EntryType second = makeEntry("/dev/serial/by-id/usb-CAPTURino", "", NOW - 5);
+    second.boardId = 0x00000001;
+    second.dltsCount = 0;
+    CHECK(DVCC_Store(&mCache, &first) == 0);
+    CHECK(DVCC_Store(&mCache, &second) == 0);
+
+    remove(CACHE_FILE);
+    CHECK(DVCC_Load(&mLoadedCache, CACHE_FILE) == 0);
+    CHECK(mLoadedCache.count == 0);
+
+    CHECK(DVCC_Save(&mCache, CACHE_FILE) == 0);
+    CHECK(DVCC_Load(&mLoadedCache, CACHE_FILE) == 0);
+    CHECK(mLoadedCache.count == 2);
+    const DVCC_EntryType* found = DVCC_Lookup(&mLoadedCache, &first.identity, NOW, TTL);
+    CHECK(found != NULL);
+    CHECK(memcmp(found->dlts, first.dlts, sizeof(uint32_t) * first.dltsCount) == 0);
+    found = DVCC_Lookup(&mLoadedCache, &second.identity, NOW, TTL);
+    CHECK(found != NULL);
+    CHECK((found->boardId == 0x00000001) && (found->dltsCount == 0));
+    remove(CACHE_FILE);
+    return 0;
+}
+
+static int testConcurrentSave(void)
+{
+    DVCC_Init(&mCache);
+    DVCC_EntryType entry = makeEntry("/dev/ttyUSB0", "A10K2X", NOW);
+    CHECK(DVCC_Store(&mCache, &entry) == 0);
+
+    /* another instance is in the middle of writing its temporary file */
+    const char* otherTempPath = CACHE_FILE ".1.tmp";
+    FILE* otherFile = fopen(otherTempPath, "w");
+    CHECK(otherFile != NULL);
+    CHECK(fputs("partial", otherFile) >= 0);
+
+    CHECK(DVCC_Save(&mCache, CACHE_FILE) == 0);
+    CHECK(fputs(" entry", otherFile) >= 0);
+    fclose(otherFile);
+    CHECK(DVCC_Load(&mLoadedCache, CACHE_FILE) == 0);
+    CHECK(DVCC_Lookup(&mLoadedCache, &entry.identity, NOW, TTL) != NULL);
+
+    /* the temporary file of this process is gone, the other one untouched */
+    unsigned long processId;
+    SYSU_GetProcessId(&processId);
+    char ownTempPath[64];
+    snprintf(ownTempPath, sizeof(ownTempPath), "%s.%lu.tmp", CACHE_FILE, processId);
+    FILE* file = fopen(ownTempPath, "r");
+    CHECK(file == NULL);
+    char content[32] = {0};
+    file = fopen(otherTempPath, "r");
+    CHECK(file != NULL);
+    CHECK(fgets(content, sizeof(content), file) != NULL);
+    fclose(file);
+    CHECK(strcmp(content, "partial entry") == 0);
+    remove(otherTempPath);
+    remove(CACHE_FILE);
+    return 0;
+}
+
+static int testCorruptedFile(void)
+{
+    FILE* file = fopen(CACHE_FILE, "w");
+    CHECK(file != NULL);
+    fputs("# CAPTURino device cache, format 1\n", file);
+    fputs("/dev/ttyUSB0\tX\t1\t2\t3\t1750000000\t80000001\t148,227\n", file);
+    fputs("/dev/ttyUSB1\tX\t1\t2\t3\n", file);
+    fputs("/dev/ttyUSB2\tX\t1\t2\tthree\t1750000000\t80000001\t148\n", file);
+    fputs("/dev/ttyUSB3\tX\t1\t2\t3\t1750000000\t80000001\t148,,227\n", file);
+    fputs("/dev/ttyUSB4\tX\t1\t2\t3\t1750000000\t80000001\t148\textra\n", file);
+    fputs("garbage", file);
+    fclose(file);
+
+    CHECK(DVCC_Load(&mLoadedCache, CACHE_FILE) == 0);
+    CHECK(mLoadedCache.count == 1);
+    CHECK(strcmp(mLoadedCache.entries[0].identity.portPath, "/dev/ttyUSB0") == 0);
+    remove(CACHE_FILE);
+    return 0;
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int main(void)
+{
+    static const TEST_FunctionType TESTS[] = {
+        testLookup,
+        testIdentityChanged,
+        testExpiry,
+        testEviction,
+        testSaveAndLoad,
+        testConcurrentSave,
+        testCorruptedFile
+    };
+    return TEST_RUN_ALL(TESTS);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
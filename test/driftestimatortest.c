@@ -0,0 +1,185 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \brief Unit tests of the driftestimator module. Every test simulates a
+ *        device whose clock runs at a known rate, feeds the timestamps of
+ *        the frames together with their delayed reception time and compares
+ *        the estimate to the exact host time.
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "driftestimator.h"
+#include "testcheck.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+/** host time at the start of the session */
+#define HOST_START_NANOS        (1700000000000000000ULL)
+#define FRAME_INTERVAL_MICROS   (10000ULL)
+#define ONE_HOUR_MICROS         (3600000000ULL)
+#define MIN_LATENCY_NANOS       (200000ULL)
+#define MAX_JITTER_NANOS        (5000000ULL)
+/** accepted deviation of the estimate from the exact host time */
+#define MAX_ERROR_NANOS         (10000LL)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+static DRFT_EstimatorType mEstimator;
+static uint32_t mRandomState;
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+/** deterministic pseudo random numbers, so a failing test is reproducible */
+static uint32_t nextRandom(void)
+{
+    mRandomState = mRandomState * 1664525u + 1013904223u;
+    return mRandomState >> 8;
+}
+
+/** Gets the exact host time of a device timestamp, for a device clock that is
+ * slower than the host clock by skewPpm. */
+static uint64_t exactHostNanos(uint64_t deviceMicros,
+                               uint64_t skewPpm)
+{
+    return HOST_START_NANOS + deviceMicros * 1000ULL + (deviceMicros * skewPpm) / 1000ULL;
+}
+
+static int64_t estimateError(uint64_t deviceMicros,
+                             uint64_t skewPpm)
+{
+    return (int64_t)(DRFT_ToHostNanos(&mEstimator, deviceMicros) - exactHostNanos(deviceMicros, skewPpm));
+}
+
+/** Simulates the reception of the frames of one hour. Every outlierInterval-th
+ * frame is received before it was sent, as if the host clock was stepped. */
+static void receiveFrames(uint64_t skewPpm,
+                          uint64_t outlierInterval)
+{
+    mRandomState = 1;
+    DRFT_Init(&mEstimator, 0, HOST_START_NANOS);
+    for (uint64_t i=1; i<=ONE_HOUR_MICROS/FRAME_INTERVAL_MICROS; i++)
+    {
+        uint64_t deviceMicros = i * FRAME_INTERVAL_MICROS;
+        uint64_t hostNanos = exactHostNanos(deviceMicros, skewPpm) + MIN_LATENCY_NANOS
+                           + (nextRandom() % MAX_JITTER_NANOS);
+        if ((outlierInterval != 0) && ((i % outlierInterval) == 0))
+        {
+            hostNanos -= 3000000ULL;
+        }
+        DRFT_AddSample(&mEstimator, deviceMicros, hostNanos);
+    }
+}
+
+static int testTimebaseBeforeFirstFit(void)
+{
+    DRFT_Init(&mEstimator, 5000, HOST_START_NANOS);
+    CHECK(DRFT_ToHostNanos(&mEstimator, 5000) == HOST_START_NANOS);
+    CHECK(DRFT_ToHostNanos(&mEstimator, 6000) == HOST_START_NANOS + 1000000ULL);
+    /* a single bucket is not enough for a fit */
+    DRFT_AddSample(&mEstimator, 7000, HOST_START_NANOS + 2300000ULL);
+    DRFT_AddSample(&mEstimator, 7000 + DRFT_BUCKET_MICROS, HOST_START_NANOS + 2300000ULL + DRFT_BUCKET_MICROS * 1000ULL);
+    CHECK(DRFT_ToHostNanos(&mEstimator, 6000) == HOST_START_NANOS + 1000000ULL);
+    CHECK(DRFT_GetSkewPpb(&mEstimator) == 0);
+    return 0;
+}
+
+static int testNoDrift(void)
+{
+    receiveFrames(0, 0);
+    CHECK(DRFT_GetSkewPpb(&mEstimator) > -100);
+    CHECK(DRFT_GetSkewPpb(&mEstimator) < 100);
+    int64_t error = estimateError(ONE_HOUR_MICROS, 0);
+    CHECK((error > -MAX_ERROR_NANOS) && (error < MAX_ERROR_NANOS));
+    return 0;
+}
+
+static int testDrift(void)
+{
+    receiveFrames(50, 0);
+    CHECK(DRFT_GetSkewPpb(&mEstimator) > 49900);
+    CHECK(DRFT_GetSkewPpb(&mEstimator) < 50100);
+    /* without the estimate the error would be 180 ms after an hour */
+    int64_t error = estimateError(ONE_HOUR_MICROS, 50);
+    CHECK((error > -MAX_ERROR_NANOS) && (error < MAX_ERROR_NANOS));
+    error = estimateError(ONE_HOUR_MICROS - 2*DRFT_BUCKET_MICROS, 50);
+    CHECK((error > -MAX_ERROR_NANOS) && (error < MAX_ERROR_NANOS));
+    return 0;
+}
+
+static int testOutliers(void)
+{
+    /* one outlier in roughly every fourth bucket */
+    receiveFrames(50, 1601);
+    CHECK(DRFT_GetSkewPpb(&mEstimator) > 49900);
+    CHECK(DRFT_GetSkewPpb(&mEstimator) < 50100);
+    int64_t error = estimateError(ONE_HOUR_MICROS, 50);
+    CHECK((error > -MAX_ERROR_NANOS) && (error < MAX_ERROR_NANOS));
+    return 0;
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int main(void)
+{
+    static const TEST_FunctionType TESTS[] = {
+        testTimebaseBeforeFirstFit,
+        testNoDrift,
+        testDrift,
+        testOutliers
+    };
+    return TEST_RUN_ALL(TESTS);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
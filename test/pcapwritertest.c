@@ -0,0 +1,193 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \brief Unit tests of the buffered pcap writer. The records are written
+ *        through PIPH_Write() to a file, which is read back and compared to
+ *        the records.
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "pcap_writer.h"
+#include "pipehandling.h"
+#include "testcheck.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+/** created in the working directory of the test */
+#define OUTPUT_FILE_NAME        "pcapwritertest.pcap"
+#define FILE_HEADER_SIZE        (24)
+#define RECORD_HEADER_SIZE      (16)
+/** larger than the whole write buffer of the pcap writer */
+#define MAX_OUTPUT_SIZE         (256*1024)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+static uint8_t mExpected[MAX_OUTPUT_SIZE];
+static size_t mExpectedLength;
+static uint8_t mOutput[MAX_OUTPUT_SIZE];
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static int openOutput(PipeHandleType* pipe)
+{
+    /* the Windows pipe layer opens existing files only */
+    FILE* file = fopen(OUTPUT_FILE_NAME, "wb");
+    CHECK(file != NULL);
+    fclose(file);
+    CHECK(PIPH_Open(OUTPUT_FILE_NAME, pipe) == 0);
+    CHECK(PCAP_WriteHeader(*pipe, false, 65535, PCAP_USER1UART, 0, 0, 0) == 0);
+    mExpectedLength = FILE_HEADER_SIZE;
+    return 0;
+}
+
+/** Writes a record with a payload of the given length and remembers it. */
+static int writeRecord(PipeHandleType pipe,
+                       uint32_t payloadLength)
+{
+    static uint8_t record[RECORD_HEADER_SIZE + 65535];
+    PCAP_PacketRecordHeaderType header = {
+        .timestampSeconds = 1700000000,
+        .timestampMicrosOrNanos = payloadLength,
+        .protocolPayloadLength = payloadLength
+    };
+    PCAP_FillPacketRecordHeader(&header, record);
+    for (uint32_t i=0; i<payloadLength; i++)
+    {
+        record[RECORD_HEADER_SIZE + i] = (uint8_t)(i + payloadLength);
+    }
+    size_t recordLength = RECORD_HEADER_SIZE + payloadLength;
+    CHECK(mExpectedLength + recordLength <= sizeof(mExpected));
+    memcpy(&mExpected[mExpectedLength], record, recordLength);
+    mExpectedLength += recordLength;
+    CHECK(PCAP_WritePacketRecord(pipe, record) == 0);
+    return 0;
+}
+
+/** Closes the output and compares it to the records written. */
+static int checkOutput(PipeHandleType pipe)
+{
+    CHECK(PCAP_Flush(pipe) == 0);
+    CHECK(PIPH_Close(pipe) == 0);
+    FILE* file = fopen(OUTPUT_FILE_NAME, "rb");
+    CHECK(file != NULL);
+    size_t outputLength = fread(mOutput, 1, sizeof(mOutput), file);
+    fclose(file);
+    remove(OUTPUT_FILE_NAME);
+    CHECK(outputLength == mExpectedLength);
+    /* the file header precedes the records */
+    const uint32_t magic = 0xa1b2c3d4;
+    CHECK(memcmp(mOutput, &magic, sizeof(magic)) == 0);
+    CHECK(memcmp(&mOutput[FILE_HEADER_SIZE], &mExpected[FILE_HEADER_SIZE], mExpectedLength - FILE_HEADER_SIZE) == 0);
+    return 0;
+}
+
+static int testBufferedFlush(void)
+{
+    PipeHandleType pipe;
+    CHECK(PCAP_SetFlushLatency(PCAP_DEFAULT_FLUSH_LATENCY_MS) == 0);
+    CHECK(openOutput(&pipe) == 0);
+    /* the flushes triggered by the fill level and the final one each write
+       more than 4 KiB at once */
+    for (uint32_t i=0; i<3000; i++)
+    {
+        CHECK(writeRecord(pipe, 1 + (i % 64)) == 0);
+    }
+    CHECK(checkOutput(pipe) == 0);
+    return 0;
+}
+
+static int testRecordsLargerThanPipeWrite(void)
+{
+    PipeHandleType pipe;
+    CHECK(PCAP_SetFlushLatency(PCAP_DEFAULT_FLUSH_LATENCY_MS) == 0);
+    CHECK(openOutput(&pipe) == 0);
+    /* 16000 bytes stay below the flush threshold, the following record fills
+       the write buffer to 64 KiB, more than a single write of the pipe
+       layer takes */
+    for (uint32_t i=0; i<1000; i++)
+    {
+        CHECK(writeRecord(pipe, 0) == 0);
+    }
+    CHECK(writeRecord(pipe, 65536 - 16000 - RECORD_HEADER_SIZE) == 0);
+    /* a record of the maximum snap length does not fit into the buffer */
+    CHECK(writeRecord(pipe, 65535) == 0);
+    CHECK(checkOutput(pipe) == 0);
+    return 0;
+}
+
+static int testUnbuffered(void)
+{
+    PipeHandleType pipe;
+    CHECK(PCAP_SetFlushLatency(0) == 0);
+    CHECK(openOutput(&pipe) == 0);
+    CHECK(writeRecord(pipe, 8) == 0);
+    CHECK(writeRecord(pipe, 65535) == 0);
+    CHECK(checkOutput(pipe) == 0);
+    return 0;
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int main(void)
+{
+    static const TEST_FunctionType TESTS[] = {
+        testBufferedFlush,
+        testRecordsLargerThanPipeWrite,
+        testUnbuffered
+    };
+    return TEST_RUN_ALL(TESTS);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
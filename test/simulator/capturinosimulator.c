@@ -0,0 +1,952 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \brief Simulates a CAPTURino device on a pseudo-terminal, so the capture
+ *        path can be tested and benchmarked without hardware.
+ *
+ * The simulator implements the command line interface of the device (^C,
+ * idfcn, time, dlts, bauds, baud and capture) and streams frames in the wire
+ * format of the device once a capture is started. The frame rate, the mix of
+ * payload sizes, the burst pattern and the behaviour of the device clock are
+ * configurable, e.g. to provoke wraps of the 32 bit timestamps. Above a
+ * given baudrate the line can be garbled, to test the fallback of the
+ * baudrate negotiation.
+ *
+ * Without a command the path of the pseudo-terminal is printed and the
+ * simulator runs until SIGINT or SIGTERM. A command given after "--" is run
+ * with every "@PORT@" argument replaced by the path of the pseudo-terminal,
+ * the simulator exits with its exit status. The statistics are printed to
+ * stderr on exit.
+ *
+ * Example:
+ *     CapturinoSimulator --rate 10000 --sizes 8,1-64 -- CapturinoPlugin
+ *         --extcap-interface CAPTURino --capture --port @PORT@ ...
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "argparser.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+#define PROMPT                  "CAPTURino>"
+#define PORT_PLACEHOLDER        "@PORT@"
+/** bytes buffered for the pseudo-terminal. The frames are generated only if
+    the buffer has room, i.e. a slow host throttles the simulated device. */
+#define OUTPUT_BUFFER_SIZE      (65536)
+#define INPUT_BUFFER_SIZE       (256)
+/** payload of DLT 148 frames sent by the device at most */
+#define MAX_PAYLOAD_LENGTH      (64)
+/** timestamp, length and payload */
+#define MAX_FRAME_LENGTH        (4 + 2 + MAX_PAYLOAD_LENGTH)
+#define MAX_CAN_DLC             (8)
+#define MAX_SIZE_RANGES         (16)
+#define MAX_BAUDRATES           (16)
+/** a new baudrate is kept only if a command is received at it in time */
+#define BAUDRATE_REVERT_MS      (1000)
+/** XORed to every byte sent or received at a garbled baudrate */
+#define GARBLE_PATTERN          (0x55)
+/** longest time the main loop sleeps, so signals and the child are noticed */
+#define MAX_SLEEP_NS            (10000000LL)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+#define STATIC_STRLEN(s)        (sizeof(s) - 1)
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+typedef struct
+{
+    unsigned long min;
+    unsigned long max;
+} SizeRangeType;
+
+typedef struct
+{
+    uint32_t      boardId;
+    unsigned long rate;             /**< frames per second, 0: as fast as
+                                         the host reads them */
+    unsigned long frames;           /**< frames per capture, 0: unlimited */
+    unsigned long burst;            /**< frames sent back to back */
+    SizeRangeType sizes[MAX_SIZE_RANGES];
+    size_t        sizeCount;
+    unsigned long extendedPercent;  /**< share of extended CAN identifiers */
+    uint32_t      clockStart;       /**< device clock at the start */
+    long          skewPpm;          /**< deviation of the device clock */
+    unsigned long nullPeriodMS;     /**< idle time after which a null frame
+                                         is sent, 0: never */
+    unsigned long hwErrorAfter;     /**< frames after which a hardware error
+                                         is reported, 0: never */
+    unsigned long bauds[MAX_BAUDRATES];
+    size_t        baudCount;        /**< 0: "bauds" is an unknown command */
+    bool          throttle;         /**< limit the output to the baudrate */
+    unsigned long garbleAbove;      /**< baudrate above which the line is
+                                         garbled, 0: never */
+    unsigned long durationS;        /**< 0: until terminated */
+    unsigned long seed;
+} SimConfigType;
+
+typedef struct
+{
+    unsigned long captures;
+    unsigned long frames;
+    unsigned long nullFrames;
+    unsigned long long payloadBytes;
+    unsigned long long bytes;
+    unsigned long lateBursts;       /**< bursts sent later than one period
+                                         behind the schedule */
+} SimStatsType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+static volatile sig_atomic_t mTerminate = 0;
+
+static SimConfigType mConfig = {
+    .boardId = 0x00000001,
+    .rate = 1000,
+    .frames = 0,
+    .burst = 1,
+    .sizes = { { .min = 8, .max = 8 } },
+    .sizeCount = 1,
+    .extendedPercent = 0,
+    .clockStart = 0,
+    .skewPpm = 0,
+    .nullPeriodMS = 0,
+    .hwErrorAfter = 0,
+    .baudCount = 0,
+    .throttle = false,
+    .garbleAbove = 0,
+    .durationS = 0,
+    .seed = 1
+};
+static SimStatsType mStats;
+
+static int mMasterFd = -1;
+static uint8_t mOutput[OUTPUT_BUFFER_SIZE];
+static size_t mOutputLength = 0;
+static char mInput[INPUT_BUFFER_SIZE];
+static size_t mInputLength = 0;
+
+static long long mStartNs;
+static uint32_t mRandomState;
+static unsigned long mBaudrate = 115200;
+static unsigned long mFormerBaudrate;
+static bool mBaudratePending = false;   /**< no command received yet at the
+                                             new baudrate */
+static long long mRevertNs;
+static long long mThrottleStartNs;
+static unsigned long long mThrottleBytes;
+
+static bool mCapturing = false;
+static unsigned int mCaptureDlt;
+static unsigned long mCaptureFrames;
+static long long mNextBurstNs;
+static long long mLastFrameNs;
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static long long getNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/** Gets the 32 bit microsecond clock of the simulated device. */
+static uint32_t getDeviceMicros(long long nowNs)
+{
+    long long elapsedMicros = (nowNs - mStartNs) / 1000;
+    elapsedMicros += (elapsedMicros * mConfig.skewPpm) / 1000000;
+    return (uint32_t)(mConfig.clockStart + (uint64_t)elapsedMicros);
+}
+
+/** xorshift32, reproducible with the same seed */
+static uint32_t getRandom(void)
+{
+    mRandomState ^= mRandomState << 13;
+    mRandomState ^= mRandomState >> 17;
+    mRandomState ^= mRandomState << 5;
+    return mRandomState;
+}
+
+static void onSignal(int sig)
+{
+    (void)sig;
+    mTerminate = 1;
+}
+
+static bool isGarbled(void)
+{
+    return (mConfig.garbleAbove > 0) && (mBaudrate > mConfig.garbleAbove);
+}
+
+/** Garbles the data like a line whose ends run at different baudrates. */
+static void garble(uint8_t* data, size_t length)
+{
+    for (size_t i=0; i<length; i++)
+    {
+        data[i] ^= GARBLE_PATTERN;
+    }
+}
+
+static void output(const void* data, size_t length)
+{
+    if (length > (OUTPUT_BUFFER_SIZE - mOutputLength))
+    {
+        /* the host does not read, the device loses the data */
+        length = OUTPUT_BUFFER_SIZE - mOutputLength;
+    }
+    memcpy(&mOutput[mOutputLength], data, length);
+    if (isGarbled() == true)
+    {
+        garble(&mOutput[mOutputLength], length);
+    }
+    mOutputLength += length;
+}
+
+static void outputString(const char* str)
+{
+    output(str, strlen(str));
+}
+
+/** Writes as much of the buffered output as the pseudo-terminal takes. */
+static void flushOutput(long long nowNs)
+{
+    size_t length = mOutputLength;
+    if (mConfig.throttle == true)
+    {
+        /* 8N1: ten bits per byte */
+        unsigned long long allowed = (unsigned long long)((nowNs - mThrottleStartNs) / 1000)
+                                   * mBaudrate / 10000000ULL;
+        if (allowed <= mThrottleBytes)
+        {
+            return;
+        }
+        if ((allowed - mThrottleBytes) < length)
+        {
+            length = (size_t)(allowed - mThrottleBytes);
+        }
+    }
+    if (length == 0)
+    {
+        return;
+    }
+    ssize_t written = write(mMasterFd, mOutput, length);
+    if (written <= 0)
+    {
+        return;
+    }
+    mThrottleBytes += (unsigned long long)written;
+    mStats.bytes += (unsigned long long)written;
+    memmove(mOutput, &mOutput[written], mOutputLength - (size_t)written);
+    mOutputLength -= (size_t)written;
+}
+
+static void restartThrottle(long long nowNs)
+{
+    mThrottleStartNs = nowNs;
+    mThrottleBytes = 0;
+}
+
+static size_t getPayloadSize(void)
+{
+    const SizeRangeType* range = &mConfig.sizes[getRandom() % mConfig.sizeCount];
+    return range->min + getRandom() % (range->max - range->min + 1);
+}
+
+/** Encodes a frame in the wire format: the timestamp in big endian order,
+    the length, with the most significant bit set if it is 15 bit long, and
+    the payload. */
+static size_t encodeFrame(uint8_t* frame,
+                          uint32_t timestamp,
+                          const uint8_t* payload,
+                          size_t length)
+{
+    size_t pos = 0;
+    frame[pos++] = (uint8_t)(timestamp >> 24);
+    frame[pos++] = (uint8_t)(timestamp >> 16);
+    frame[pos++] = (uint8_t)(timestamp >> 8);
+    frame[pos++] = (uint8_t)timestamp;
+    if (length > 0x7F)
+    {
+        frame[pos++] = (uint8_t)(0x80 | (length >> 8));
+    }
+    frame[pos++] = (uint8_t)length;
+    memcpy(&frame[pos], payload, length);
+    return pos + length;
+}
+
+/** Generates the payload of the next frame. The data bytes count up from the
+    frame number, so the receiver can check them. */
+static size_t generatePayload(uint8_t* payload)
+{
+    uint32_t frameNumber = (uint32_t)mCaptureFrames;
+    size_t size = getPayloadSize();
+    if (mCaptureDlt == 148)
+    {
+        /* an empty frame would be taken for a null frame */
+        size = (size == 0) ? 1 : size;
+        for (size_t i=0; i<size; i++)
+        {
+            payload[i] = (uint8_t)(frameNumber + i);
+        }
+        return size;
+    }
+
+    /* DLT 227: identifier, DLC and data */
+    size_t pos = 0;
+    size_t dlc = (size > MAX_CAN_DLC) ? MAX_CAN_DLC : size;
+    if ((getRandom() % 100) < mConfig.extendedPercent)
+    {
+        uint32_t id = frameNumber & 0x1FFFFFFF;
+        payload[pos++] = (uint8_t)(0x80 | (id >> 24));
+        payload[pos++] = (uint8_t)(id >> 16);
+        payload[pos++] = (uint8_t)(id >> 8);
+        payload[pos++] = (uint8_t)id;
+    }
+    else
+    {
+        uint32_t id = frameNumber & 0x7FF;
+        payload[pos++] = (uint8_t)(id >> 8);
+        payload[pos++] = (uint8_t)id;
+    }
+    payload[pos++] = (uint8_t)dlc;
+    for (size_t i=0; i<dlc; i++)
+    {
+        payload[pos++] = (uint8_t)(frameNumber + i);
+    }
+    return pos;
+}
+
+static void sendNullFrame(uint32_t timestamp)
+{
+    uint8_t frame[MAX_FRAME_LENGTH];
+    output(frame, encodeFrame(frame, timestamp, NULL, 0));
+    mStats.nullFrames++;
+}
+
+static void sendFrame(long long nowNs)
+{
+    uint8_t payload[MAX_PAYLOAD_LENGTH];
+    uint8_t frame[MAX_FRAME_LENGTH];
+    size_t length = generatePayload(payload);
+    output(frame, encodeFrame(frame, getDeviceMicros(nowNs), payload, length));
+    mCaptureFrames++;
+    mStats.frames++;
+    mStats.payloadBytes += length;
+    mLastFrameNs = nowNs;
+
+    if ((mConfig.hwErrorAfter > 0) && (mCaptureFrames == mConfig.hwErrorAfter))
+    {
+        /* two null frames without a timestamp signal a hardware error,
+           after which the device stops sending */
+        sendNullFrame(0);
+        sendNullFrame(0);
+        mCaptureFrames = ULONG_MAX;
+    }
+}
+
+static bool captureComplete(void)
+{
+    if (mCaptureFrames == ULONG_MAX)
+    {
+        return true;
+    }
+    return (mConfig.frames > 0) && (mCaptureFrames >= mConfig.frames);
+}
+
+/** Generates the frames which are due, as long as the output buffer has
+    room for them. */
+static void generateFrames(long long nowNs)
+{
+    if (mCapturing == false)
+    {
+        return;
+    }
+    while ((captureComplete() == false)
+           && ((OUTPUT_BUFFER_SIZE - mOutputLength) >= (mConfig.burst * MAX_FRAME_LENGTH))
+           && ((mConfig.rate == 0) || (nowNs >= mNextBurstNs)))
+    {
+        if (mConfig.rate > 0)
+        {
+            long long periodNs = (long long)(mConfig.burst * 1000000000ULL / mConfig.rate);
+            if ((nowNs - mNextBurstNs) > periodNs)
+            {
+                mStats.lateBursts++;
+            }
+            mNextBurstNs += periodNs;
+        }
+        for (unsigned long i=0; (i<mConfig.burst) && (captureComplete() == false); i++)
+        {
+            sendFrame(nowNs);
+        }
+    }
+    if ((mConfig.nullPeriodMS > 0)
+        && ((nowNs - mLastFrameNs) >= (long long)mConfig.nullPeriodMS * 1000000LL))
+    {
+        sendNullFrame(getDeviceMicros(nowNs));
+        mLastFrameNs = nowNs;
+    }
+}
+
+static bool isBaudrateSupported(unsigned long baudrate)
+{
+    for (size_t i=0; i<mConfig.baudCount; i++)
+    {
+        if (mConfig.bauds[i] == baudrate)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Executes a command line, which is echoed without its newline like the
+    device does. */
+static void executeCommand(const char* line, long long nowNs)
+{
+    char response[INPUT_BUFFER_SIZE + 32];
+    outputString(line);
+
+    if (strcmp(line, "idfcn") == 0)
+    {
+        snprintf(response, sizeof(response), "\r\n%08X\r\n" PROMPT, (unsigned int)mConfig.boardId);
+    }
+    else if (strcmp(line, "time") == 0)
+    {
+        snprintf(response, sizeof(response), "\r\n%lu\r\n" PROMPT, (unsigned long)getDeviceMicros(nowNs));
+    }
+    else if (strcmp(line, "dlts") == 0)
+    {
+        snprintf(response, sizeof(response), "\r\n148\r\n227\r\n" PROMPT);
+    }
+    else if ((strcmp(line, "bauds") == 0) && (mConfig.baudCount > 0))
+    {
+        size_t pos = 0;
+        for (size_t i=0; i<mConfig.baudCount; i++)
+        {
+            pos += (size_t)snprintf(&response[pos], sizeof(response) - pos, "\r\n%lu", mConfig.bauds[i]);
+        }
+        snprintf(&response[pos], sizeof(response) - pos, "\r\n" PROMPT);
+    }
+    else if ((strncmp(line, "baud ", STATIC_STRLEN("baud ")) == 0) && (mConfig.baudCount > 0))
+    {
+        unsigned long baudrate = strtoul(&line[STATIC_STRLEN("baud ")], NULL, 10);
+        if (isBaudrateSupported(baudrate) == true)
+        {
+            /* the prompt is still sent at the old baudrate */
+            outputString("\r\n" PROMPT);
+            flushOutput(nowNs);
+            mFormerBaudrate = mBaudrate;
+            mBaudratePending = true;
+            mRevertNs = nowNs + BAUDRATE_REVERT_MS * 1000000LL;
+            mBaudrate = baudrate;
+            restartThrottle(nowNs);
+            fprintf(stderr, "baudrate switched to %lu\n", baudrate);
+            return;
+        }
+        snprintf(response, sizeof(response), "\r\nunsupported baudrate\r\n" PROMPT);
+    }
+    else if (strncmp(line, "capture ", STATIC_STRLEN("capture ")) == 0)
+    {
+        unsigned long dlt = strtoul(&line[STATIC_STRLEN("capture ")], NULL, 10);
+        if ((dlt == 148) || (dlt == 227))
+        {
+            static const uint8_t ACK[] = { '\r', '\n', 0x06 };
+            output(ACK, sizeof(ACK));
+            mCapturing = true;
+            mCaptureDlt = (unsigned int)dlt;
+            mCaptureFrames = 0;
+            mNextBurstNs = nowNs;
+            mLastFrameNs = nowNs;
+            mStats.captures++;
+            return;
+        }
+        snprintf(response, sizeof(response), "\r\nunsupported dlt\r\n" PROMPT);
+    }
+    else
+    {
+        snprintf(response, sizeof(response), "\r\n" PROMPT);
+    }
+    outputString(response);
+}
+
+/** Processes the received characters. A ^C stops a running capture and is
+    answered by the prompt, all other input is ignored during a capture. */
+static void processInput(const uint8_t* data, size_t length, long long nowNs)
+{
+    for (size_t i=0; i<length; i++)
+    {
+        if (data[i] == 0x03)
+        {
+            if (mCapturing == true)
+            {
+                /* frames not yet sent are lost */
+                mCapturing = false;
+                mOutputLength = 0;
+            }
+            mInputLength = 0;
+            outputString("\r\n" PROMPT);
+        }
+        else if (mCapturing == true)
+        {
+            continue;
+        }
+        else if (data[i] == '\n')
+        {
+            if ((mInputLength > 0) && (mInput[mInputLength - 1] == '\r'))
+            {
+                mInputLength--;
+            }
+            mInput[mInputLength] = '\0';
+            /* the command confirms the new baudrate */
+            mBaudratePending = false;
+            executeCommand(mInput, nowNs);
+            mInputLength = 0;
+        }
+        else if (mInputLength < (INPUT_BUFFER_SIZE - 1))
+        {
+            mInput[mInputLength++] = (char)data[i];
+        }
+    }
+}
+
+/** Returns to the former baudrate if no command has been received at the new
+    one in time, like the device does. */
+static void revertBaudrateIfDue(long long nowNs)
+{
+    if ((mBaudratePending == true) && (nowNs >= mRevertNs))
+    {
+        mBaudratePending = false;
+        mBaudrate = mFormerBaudrate;
+        /* the garbage received at the new baudrate is discarded */
+        mInputLength = 0;
+        restartThrottle(nowNs);
+        fprintf(stderr, "baudrate reverted to %lu\n", mBaudrate);
+    }
+}
+
+/** Parses a list of sizes like "8,1-64". Every entry is drawn with the same
+    probability and a size uniformly out of the range of the entry. The sizes
+    of CAN frames are the data lengths, limited to 8. */
+static int parseSizes(const char* str)
+{
+    mConfig.sizeCount = 0;
+    while (*str != '\0')
+    {
+        char* end;
+        SizeRangeType range;
+        range.min = strtoul(str, &end, 10);
+        range.max = range.min;
+        if (*end == '-')
+        {
+            range.max = strtoul(end + 1, &end, 10);
+        }
+        if ((end == str) || (range.max < range.min)
+            || (range.max > MAX_PAYLOAD_LENGTH) || (mConfig.sizeCount == MAX_SIZE_RANGES))
+        {
+            return -1;
+        }
+        mConfig.sizes[mConfig.sizeCount++] = range;
+        if (*end == ',')
+        {
+            end++;
+        }
+        else if (*end != '\0')
+        {
+            return -1;
+        }
+        str = end;
+    }
+    return (mConfig.sizeCount > 0) ? 0 : -1;
+}
+
+static int parseBauds(const char* str)
+{
+    mConfig.baudCount = 0;
+    while (*str != '\0')
+    {
+        char* end;
+        unsigned long baudrate = strtoul(str, &end, 10);
+        if ((end == str) || (baudrate == 0) || (mConfig.baudCount == MAX_BAUDRATES))
+        {
+            return -1;
+        }
+        mConfig.bauds[mConfig.baudCount++] = baudrate;
+        if (*end == ',')
+        {
+            end++;
+        }
+        else if (*end != '\0')
+        {
+            return -1;
+        }
+        str = end;
+    }
+    return 0;
+}
+
+static void printUsage(const char* name)
+{
+    fprintf(stderr,
+            "usage: %s [options] [-- command [args]]\n"
+            "  --boardid=<hex>      board ID returned by idfcn (default 00000001)\n"
+            "  --rate=<n>           frames per second, 0: as fast as read (default 1000)\n"
+            "  --frames=<n>         frames per capture, 0: unlimited (default 0)\n"
+            "  --burst=<n>          frames sent back to back (default 1)\n"
+            "  --sizes=<list>       payload sizes, e.g. 8,1-64 (default 8)\n"
+            "  --extended=<n>       percentage of extended CAN identifiers (default 0)\n"
+            "  --clockstart=<n>     device clock at the start in us, e.g. 4294000000\n"
+            "                       to wrap the timestamps after about a second\n"
+            "  --skewppm=<n>        deviation of the device clock (default 0)\n"
+            "  --nullperiod=<ms>    idle time after which a null frame is sent\n"
+            "  --hwerror=<n>        report a hardware error after n frames\n"
+            "  --bauds=<list>       baudrates listed by the bauds command\n"
+            "  --throttle           limit the output to the current baudrate\n"
+            "  --garble=<baud>      garble the line above the given baudrate\n"
+            "  --duration=<s>       terminate after s seconds\n"
+            "  --seed=<n>           seed of the random generator (default 1)\n"
+            "Every argument \"" PORT_PLACEHOLDER "\" of the command is replaced by the path of the\n"
+            "pseudo-terminal.\n",
+            name);
+}
+
+static int parseArgs(int argc, char* argv[])
+{
+    char* str;
+    long value;
+    unsigned long uvalue;
+
+    if (ARGP_getP2StringOfArgs(argc, argv, "--boardid", &str) == 0)
+    {
+        mConfig.boardId = (uint32_t)strtoul(str, NULL, 16);
+    }
+    if (ARGP_getUnsignedLongOfArgs(argc, argv, "--rate", &uvalue) == 0)
+    {
+        mConfig.rate = uvalue;
+    }
+    if (ARGP_getUnsignedLongOfArgs(argc, argv, "--frames", &uvalue) == 0)
+    {
+        mConfig.frames = uvalue;
+    }
+    if (ARGP_getUnsignedLongOfArgs(argc, argv, "--burst", &uvalue) == 0)
+    {
+        if ((uvalue == 0) || (uvalue > (OUTPUT_BUFFER_SIZE / MAX_FRAME_LENGTH)))
+        {
+            fprintf(stderr, "invalid burst length %lu\n", uvalue);
+            return -1;
+        }
+        mConfig.burst = uvalue;
+    }
+    if ((ARGP_getP2StringOfArgs(argc, argv, "--sizes", &str) == 0) && (parseSizes(str) != 0))
+    {
+        fprintf(stderr, "invalid sizes '%s', expected a list of sizes or ranges of 0 to %d\n", str, MAX_PAYLOAD_LENGTH);
+        return -1;
+    }
+    if (ARGP_getUnsignedLongOfArgs(argc, argv, "--extended", &uvalue) == 0)
+    {
+        mConfig.extendedPercent = uvalue;
+    }
+    if (ARGP_getUnsignedLongOfArgs(argc, argv, "--clockstart", &uvalue) == 0)
+    {
+        mConfig.clockStart = (uint32_t)uvalue;
+    }
+    if (ARGP_getLongOfArgs(argc, argv, "--skewppm", &value) == 0)
+    {
+        mConfig.skewPpm = value;
+    }
+    if (ARGP_getUnsignedLongOfArgs(argc, argv, "--nullperiod", &uvalue) == 0)
+    {
+        mConfig.nullPeriodMS = uvalue;
+    }
+    if (ARGP_getUnsignedLongOfArgs(argc, argv, "--hwerror", &uvalue) == 0)
+    {
+        mConfig.hwErrorAfter = uvalue;
+    }
+    if ((ARGP_getP2StringOfArgs(argc, argv, "--bauds", &str) == 0) && (parseBauds(str) != 0))
+    {
+        fprintf(stderr, "invalid baudrates '%s'\n", str);
+        return -1;
+    }
+    ARGP_constainsKey(argc, argv, "--throttle", &mConfig.throttle);
+    if (ARGP_getUnsignedLongOfArgs(argc, argv, "--garble", &uvalue) == 0)
+    {
+        mConfig.garbleAbove = uvalue;
+    }
+    if (ARGP_getUnsignedLongOfArgs(argc, argv, "--duration", &uvalue) == 0)
+    {
+        mConfig.durationS = uvalue;
+    }
+    if (ARGP_getUnsignedLongOfArgs(argc, argv, "--seed", &uvalue) == 0)
+    {
+        mConfig.seed = uvalue;
+    }
+    return 0;
+}
+
+/** Opens the pseudo-terminal. The slave side is kept open by the simulator,
+    so the master does not hang up while the host reopens the port. */
+static int openPseudoTerminal(int* slaveFd, char* slavePath, size_t slavePathSize)
+{
+    mMasterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (mMasterFd < 0)
+    {
+        perror("posix_openpt");
+        return -1;
+    }
+    if ((grantpt(mMasterFd) != 0) || (unlockpt(mMasterFd) != 0)
+        || (ptsname_r(mMasterFd, slavePath, slavePathSize) != 0))
+    {
+        perror("grantpt");
+        return -1;
+    }
+    *slaveFd = open(slavePath, O_RDWR | O_NOCTTY);
+    if (*slaveFd < 0)
+    {
+        perror(slavePath);
+        return -1;
+    }
+    struct termios tio;
+    tcgetattr(*slaveFd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(*slaveFd, TCSANOW, &tio);
+    fcntl(mMasterFd, F_SETFL, fcntl(mMasterFd, F_GETFL) | O_NONBLOCK);
+    return 0;
+}
+
+static pid_t startCommand(char* argv[], char* slavePath)
+{
+    for (size_t i=0; argv[i] != NULL; i++)
+    {
+        if (strcmp(argv[i], PORT_PLACEHOLDER) == 0)
+        {
+            argv[i] = slavePath;
+        }
+    }
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(mMasterFd);
+        execvp(argv[0], argv);
+        perror(argv[0]);
+        _exit(127);
+    }
+    if (pid < 0)
+    {
+        perror("fork");
+    }
+    return pid;
+}
+
+static void printStats(long long nowNs)
+{
+    double seconds = (double)(nowNs - mStartNs) / 1e9;
+    fprintf(stderr,
+            "captures %lu, frames %lu, null frames %lu, payload bytes %llu, bytes %llu, "
+            "late bursts %lu, %.0f frames/s over %.3f s at %lu baud\n",
+            mStats.captures, mStats.frames, mStats.nullFrames, mStats.payloadBytes,
+            mStats.bytes, mStats.lateBursts,
+            (seconds > 0.0) ? ((double)mStats.frames / seconds) : 0.0, seconds, mBaudrate);
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int main(int argc, char* argv[])
+{
+    /* the options end at "--", the rest is the command */
+    int optionCount = argc;
+    char** command = NULL;
+    for (int i=1; i<argc; i++)
+    {
+        if (strcmp(argv[i], "--") == 0)
+        {
+            optionCount = i;
+            command = (i + 1 < argc) ? &argv[i + 1] : NULL;
+            break;
+        }
+    }
+    bool help;
+    ARGP_constainsKey(optionCount, argv, "--help", &help);
+    if (help == true)
+    {
+        printUsage(argv[0]);
+        return 0;
+    }
+    if (parseArgs(optionCount, argv) != 0)
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+    mRandomState = (mConfig.seed != 0) ? (uint32_t)mConfig.seed : 1;
+
+    int slaveFd;
+    char slavePath[128];
+    if (openPseudoTerminal(&slaveFd, slavePath, sizeof(slavePath)) != 0)
+    {
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    mStartNs = getNanos();
+    restartThrottle(mStartNs);
+    pid_t child = -1;
+    int exitCode = 0;
+    if (command != NULL)
+    {
+        child = startCommand(command, slavePath);
+        if (child < 0)
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        printf("%s\n", slavePath);
+        fflush(stdout);
+    }
+
+    bool childTerminated = false;
+    while (true)
+    {
+        long long nowNs = getNanos();
+        bool expired = (mConfig.durationS > 0)
+                    && ((nowNs - mStartNs) >= (long long)mConfig.durationS * 1000000000LL);
+        if (child > 0)
+        {
+            int status;
+            if (waitpid(child, &status, WNOHANG) == child)
+            {
+                exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : (128 + WTERMSIG(status));
+                break;
+            }
+            if (((expired == true) || (mTerminate != 0)) && (childTerminated == false))
+            {
+                kill(child, SIGTERM);
+                childTerminated = true;
+            }
+        }
+        else if ((expired == true) || (mTerminate != 0))
+        {
+            break;
+        }
+
+        revertBaudrateIfDue(nowNs);
+        generateFrames(nowNs);
+        flushOutput(nowNs);
+
+        long long sleepNs = MAX_SLEEP_NS;
+        if ((mCapturing == true) && (captureComplete() == false) && (mConfig.rate > 0))
+        {
+            long long untilBurstNs = mNextBurstNs - nowNs;
+            sleepNs = (untilBurstNs < sleepNs) ? untilBurstNs : sleepNs;
+            sleepNs = (sleepNs < 0) ? 0 : sleepNs;
+        }
+        if ((mConfig.throttle == true) && (mOutputLength > 0))
+        {
+            /* about the time of a few bytes on the line */
+            long long byteNs = 100000000000LL / (long long)mBaudrate;
+            sleepNs = (byteNs * 16 < sleepNs) ? (byteNs * 16) : sleepNs;
+        }
+        struct pollfd pfd = {
+            .fd = mMasterFd,
+            .events = POLLIN | (((mOutputLength > 0) && (mConfig.throttle == false)) ? POLLOUT : 0)
+        };
+        struct timespec timeout = {
+            .tv_sec = sleepNs / 1000000000LL,
+            .tv_nsec = sleepNs % 1000000000LL
+        };
+        if (ppoll(&pfd, 1, &timeout, NULL) > 0)
+        {
+            if ((pfd.revents & POLLIN) != 0)
+            {
+                uint8_t data[INPUT_BUFFER_SIZE];
+                ssize_t length = read(mMasterFd, data, sizeof(data));
+                if (length > 0)
+                {
+                    if (isGarbled() == true)
+                    {
+                        garble(data, (size_t)length);
+                    }
+                    processInput(data, (size_t)length, getNanos());
+                }
+            }
+        }
+    }
+
+    printStats(getNanos());
+    close(slaveFd);
+    close(mMasterFd);
+    return exitCode;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
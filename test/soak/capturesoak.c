@@ -0,0 +1,561 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \brief Soak test of the capture path. Runs CapturinoPlugin against the
+ *        device simulator for a long time and tracks the resources of the
+ *        plugin.
+ *
+ * The resident set size, the open file descriptors and the CPU load of the
+ * plugin as well as the output lag, i.e. the time between the timestamp of a
+ * record and its arrival at the FIFO, are sampled periodically. The test
+ * fails if the plugin exits, if no record arrives for the stall timeout or
+ * if one of the resources grows over the run. The growth is the slope of a
+ * line fitted through the samples after the warm-up, extrapolated over the
+ * duration of the run, so single outliers do not fail the test. The first
+ * pass through the receive buffer of the plugin touches its pages, so the
+ * resident set grows until the buffer wrapped once. This happens during the
+ * warm-up for runs of some minutes.
+ *
+ * The device clock of the simulator starts shortly before its 32 bit wrap by
+ * default, further wraps follow every 71.6 minutes.
+ *
+ * Arguments after "--" are passed to the plugin.
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "argparser.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+#define MAX_PLUGIN_ARGS         (64)
+#define MAX_SAMPLES             (65536)
+#define READ_BUFFER_SIZE        (65536)
+#define PCAP_HEADER_SIZE        (24)
+#define PCAP_RECORD_HEADER_SIZE (16)
+/** share of the samples taken during the warm-up, which are not part of the
+    trends */
+#define WARMUP_PERCENT          (20)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * T Y P E D E F   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   T Y P E D E F S * * * * * * * * * * * * * * * * * * * * * * * */
+typedef struct
+{
+    unsigned long durationS;
+    unsigned long intervalS;
+    unsigned long stallS;
+    unsigned long dlt;
+    unsigned long rate;
+    unsigned long burst;
+    char*         sizes;
+    unsigned long extendedPercent;
+    unsigned long clockStart;
+    unsigned long nullPeriodMS;
+    unsigned long maxRssGrowthKB;
+    unsigned long maxFdGrowth;
+    unsigned long maxLagGrowthMS;
+} SoakConfigType;
+
+typedef struct
+{
+    double        seconds;      /**< since the start of the capture */
+    double        rssKB;
+    double        fds;
+    double        cpuPercent;
+    double        maxLagMS;     /**< highest output lag of the interval */
+    unsigned long frames;       /**< frames received in the interval */
+} SampleType;
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+static SoakConfigType mConfig = {
+    .durationS = 60,
+    .intervalS = 5,
+    .stallS = 10,
+    .dlt = 227,
+    .rate = 2000,
+    .burst = 100,
+    .sizes = "0-8",
+    .extendedPercent = 50,
+    .clockStart = 4294967295UL - 20000000UL,
+    .nullPeriodMS = 20,
+    .maxRssGrowthKB = 1024,
+    .maxFdGrowth = 0,
+    .maxLagGrowthMS = 100
+};
+static SampleType mSamples[MAX_SAMPLES];
+static size_t mSampleCount = 0;
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static long long getRealtimeNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static uint32_t readLittleEndian32(const uint8_t* data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8)
+         | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static void parseArgs(int argc, char* argv[])
+{
+    ARGP_getUnsignedLongOfArgs(argc, argv, "--duration", &mConfig.durationS);
+    ARGP_getUnsignedLongOfArgs(argc, argv, "--interval", &mConfig.intervalS);
+    ARGP_getUnsignedLongOfArgs(argc, argv, "--stall", &mConfig.stallS);
+    ARGP_getUnsignedLongOfArgs(argc, argv, "--dlt", &mConfig.dlt);
+    ARGP_getUnsignedLongOfArgs(argc, argv, "--rate", &mConfig.rate);
+    ARGP_getUnsignedLongOfArgs(argc, argv, "--burst", &mConfig.burst);
+    ARGP_getP2StringOfArgs(argc, argv, "--sizes", &mConfig.sizes);
+    ARGP_getUnsignedLongOfArgs(argc, argv, "--extended", &mConfig.extendedPercent);
+    ARGP_getUnsignedLongOfArgs(argc, argv, "--clockstart", &mConfig.clockStart);
+    ARGP_getUnsignedLongOfArgs(argc, argv, "--nullperiod", &mConfig.nullPeriodMS);
+    ARGP_getUnsignedLongOfArgs(argc, argv, "--maxrssgrowth", &mConfig.maxRssGrowthKB);
+    ARGP_getUnsignedLongOfArgs(argc, argv, "--maxfdgrowth", &mConfig.maxFdGrowth);
+    ARGP_getUnsignedLongOfArgs(argc, argv, "--maxlaggrowth", &mConfig.maxLagGrowthMS);
+    mConfig.intervalS = (mConfig.intervalS == 0) ? 1 : mConfig.intervalS;
+}
+
+/** Starts the simulator and reads the path of its pseudo-terminal. */
+static pid_t startSimulator(char* portPath,
+                            size_t portPathSize)
+{
+    char rateArg[32], burstArg[32], sizesArg[64], extendedArg[32], clockArg[32], nullArg[32];
+    snprintf(rateArg, sizeof(rateArg), "--rate=%lu", mConfig.rate);
+    snprintf(burstArg, sizeof(burstArg), "--burst=%lu", mConfig.burst);
+    snprintf(sizesArg, sizeof(sizesArg), "--sizes=%s", mConfig.sizes);
+    snprintf(extendedArg, sizeof(extendedArg), "--extended=%lu", mConfig.extendedPercent);
+    snprintf(clockArg, sizeof(clockArg), "--clockstart=%lu", mConfig.clockStart);
+    snprintf(nullArg, sizeof(nullArg), "--nullperiod=%lu", mConfig.nullPeriodMS);
+    char* argv[] = { SIMULATOR_PATH, rateArg, burstArg, sizesArg, extendedArg, clockArg, nullArg, NULL };
+
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0)
+    {
+        perror("pipe");
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        dup2(pipeFds[1], STDOUT_FILENO);
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+        execv(argv[0], argv);
+        perror(argv[0]);
+        _exit(127);
+    }
+    close(pipeFds[1]);
+    FILE* simOut = fdopen(pipeFds[0], "r");
+    if ((pid < 0) || (simOut == NULL) || (fgets(portPath, (int)portPathSize, simOut) == NULL))
+    {
+        fprintf(stderr, "the simulator did not report its port\n");
+        if (simOut != NULL)
+        {
+            fclose(simOut);
+        }
+        return -1;
+    }
+    fclose(simOut);
+    portPath[strcspn(portPath, "\n")] = '\0';
+    return pid;
+}
+
+static pid_t startPlugin(char* portPath,
+                         char* fifoPath,
+                         int extraArgc,
+                         char* extraArgv[])
+{
+    char dltArg[16];
+    snprintf(dltArg, sizeof(dltArg), "%lu", mConfig.dlt);
+    char* argv[MAX_PLUGIN_ARGS] = {
+        PLUGIN_PATH, "--extcap-interface", "CAPTURino", "--capture",
+        "--fifo", fifoPath, "--port", portPath, "--dlts", dltArg,
+        "--baudrate", "115200", "--serialbaudrate", "115200", "--serialdatabits", "8",
+        "--serialparity", "0", "--serialstopps", "1", "--serialtimeout", "10",
+        "--canbaudrate", "500000", "--cansamplepoint", "75"
+    };
+    size_t argc = 0;
+    while (argv[argc] != NULL)
+    {
+        argc++;
+    }
+    for (int i=0; (i<extraArgc) && (argc < (MAX_PLUGIN_ARGS - 1)); i++)
+    {
+        argv[argc++] = extraArgv[i];
+    }
+    argv[argc] = NULL;
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        execv(argv[0], argv);
+        perror(argv[0]);
+        _exit(127);
+    }
+    return pid;
+}
+
+static long getRssKB(pid_t pid)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/status", (int)pid);
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return -1;
+    }
+    long rssKB = -1;
+    char line[128];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        if (sscanf(line, "VmRSS: %ld", &rssKB) == 1)
+        {
+            break;
+        }
+    }
+    fclose(file);
+    return rssKB;
+}
+
+static long getOpenFds(pid_t pid)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/fd", (int)pid);
+    DIR* dirp = opendir(path);
+    if (dirp == NULL)
+    {
+        return -1;
+    }
+    long fds = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dirp)) != NULL)
+    {
+        if (entry->d_name[0] != '.')
+        {
+            fds++;
+        }
+    }
+    closedir(dirp);
+    return fds;
+}
+
+/** \returns the CPU time of the process in clock ticks or -1 */
+static long long getCpuTicks(pid_t pid)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return -1;
+    }
+    char line[1024];
+    long long ticks = -1;
+    if (fgets(line, sizeof(line), file) != NULL)
+    {
+        /* the name of the process may contain spaces, the fields after it
+           start at the state */
+        char* fields = strrchr(line, ')');
+        unsigned long long utime, stime;
+        if ((fields != NULL)
+            && (sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) == 2))
+        {
+            ticks = (long long)(utime + stime);
+        }
+    }
+    fclose(file);
+    return ticks;
+}
+
+/** Fits a line through the samples after the warm-up and extrapolates it
+    over their time span.
+    \returns the growth of the value selected by the offset */
+static double getGrowth(size_t valueOffset)
+{
+    size_t first = (mSampleCount * WARMUP_PERCENT) / 100;
+    size_t count = mSampleCount - first;
+    if (count < 2)
+    {
+        return 0.0;
+    }
+    double meanT = 0.0, meanV = 0.0;
+    for (size_t i=first; i<mSampleCount; i++)
+    {
+        meanT += mSamples[i].seconds;
+        meanV += *(const double*)((const uint8_t*)&mSamples[i] + valueOffset);
+    }
+    meanT /= (double)count;
+    meanV /= (double)count;
+    double covariance = 0.0, variance = 0.0;
+    for (size_t i=first; i<mSampleCount; i++)
+    {
+        double dt = mSamples[i].seconds - meanT;
+        covariance += dt * (*(const double*)((const uint8_t*)&mSamples[i] + valueOffset) - meanV);
+        variance += dt * dt;
+    }
+    if (variance <= 0.0)
+    {
+        return 0.0;
+    }
+    return (covariance / variance) * (mSamples[mSampleCount - 1].seconds - mSamples[first].seconds);
+}
+
+static int checkTrend(const char* name,
+                      size_t valueOffset,
+                      double maxGrowth)
+{
+    double growth = getGrowth(valueOffset);
+    /* a growth below one unit is noise, e.g. of a single fd */
+    bool failed = (growth > maxGrowth) && (growth >= 1.0);
+    printf("%-10s growth %10.1f, allowed %10.1f %s\n", name, growth, maxGrowth, failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
+
+/** Reads the pcap stream and samples the resources until the end of the
+    run, a stall or the exit of the plugin.
+    \returns 0: if the run completed, -1 otherwise */
+static int soak(int fifoFd,
+                pid_t plugin)
+{
+    static uint8_t buffer[READ_BUFFER_SIZE];
+    size_t length = 0;
+    bool headerRead = false;
+    long long nanosPerUnit = 1000;
+    const long long clockTicks = sysconf(_SC_CLK_TCK);
+
+    long long startNs = getRealtimeNanos();
+    long long nextSampleNs = startNs + (long long)mConfig.intervalS * 1000000000LL;
+    long long endNs = startNs + (long long)mConfig.durationS * 1000000000LL;
+    long long lastRecordNs = startNs;
+    long long lastCpuTicks = getCpuTicks(plugin);
+    long long lastSampleNs = startNs;
+    double maxLagMS = 0.0;
+    unsigned long frames = 0;
+
+    printf("%9s %9s %5s %6s %9s %9s\n", "time s", "RSS kB", "fds", "CPU %", "frames/s", "lag ms");
+    while (true)
+    {
+        long long nowNs = getRealtimeNanos();
+        if (nowNs >= nextSampleNs)
+        {
+            long long cpuTicks = getCpuTicks(plugin);
+            double intervalS = (double)(nowNs - lastSampleNs) / 1e9;
+            SampleType* sample = &mSamples[mSampleCount];
+            sample->seconds = (double)(nowNs - startNs) / 1e9;
+            sample->rssKB = (double)getRssKB(plugin);
+            sample->fds = (double)getOpenFds(plugin);
+            sample->cpuPercent = 100.0 * (double)(cpuTicks - lastCpuTicks) / (double)clockTicks / intervalS;
+            sample->maxLagMS = maxLagMS;
+            sample->frames = frames;
+            printf("%9.1f %9.0f %5.0f %6.1f %9.0f %9.2f\n", sample->seconds, sample->rssKB, sample->fds,
+                   sample->cpuPercent, (double)frames / intervalS, maxLagMS);
+            fflush(stdout);
+            if (mSampleCount < (MAX_SAMPLES - 1))
+            {
+                mSampleCount++;
+            }
+            lastCpuTicks = cpuTicks;
+            lastSampleNs = nowNs;
+            maxLagMS = 0.0;
+            frames = 0;
+            nextSampleNs += (long long)mConfig.intervalS * 1000000000LL;
+        }
+        if (nowNs >= endNs)
+        {
+            return 0;
+        }
+        if ((nowNs - lastRecordNs) > (long long)mConfig.stallS * 1000000000LL)
+        {
+            printf("stalled: no record for %lu s\n", mConfig.stallS);
+            return -1;
+        }
+        if (waitpid(plugin, NULL, WNOHANG) == plugin)
+        {
+            printf("the plugin exited\n");
+            return -1;
+        }
+
+        struct pollfd pfd = { .fd = fifoFd, .events = POLLIN };
+        long long timeoutMS = (nextSampleNs - nowNs) / 1000000LL + 1;
+        if (poll(&pfd, 1, (int)((timeoutMS < 1000) ? timeoutMS : 1000)) <= 0)
+        {
+            continue;
+        }
+        ssize_t received = read(fifoFd, &buffer[length], sizeof(buffer) - length);
+        if (received <= 0)
+        {
+            printf("the plugin closed the FIFO\n");
+            return -1;
+        }
+        nowNs = getRealtimeNanos();
+        length += (size_t)received;
+
+        size_t pos = 0;
+        if ((headerRead == false) && (length >= PCAP_HEADER_SIZE))
+        {
+            nanosPerUnit = (readLittleEndian32(buffer) == 0xa1b23c4d) ? 1 : 1000;
+            pos = PCAP_HEADER_SIZE;
+            headerRead = true;
+        }
+        while ((headerRead == true) && ((length - pos) >= PCAP_RECORD_HEADER_SIZE))
+        {
+            uint32_t capturedLength = readLittleEndian32(&buffer[pos + 8]);
+            if ((length - pos) < (PCAP_RECORD_HEADER_SIZE + capturedLength))
+            {
+                break;
+            }
+            long long timestampNs = (long long)readLittleEndian32(&buffer[pos]) * 1000000000LL
+                                  + (long long)readLittleEndian32(&buffer[pos + 4]) * nanosPerUnit;
+            double lagMS = (double)(nowNs - timestampNs) / 1e6;
+            maxLagMS = (lagMS > maxLagMS) ? lagMS : maxLagMS;
+            frames++;
+            lastRecordNs = nowNs;
+            pos += PCAP_RECORD_HEADER_SIZE + capturedLength;
+        }
+        memmove(buffer, &buffer[pos], length - pos);
+        length -= pos;
+    }
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int main(int argc, char* argv[])
+{
+    /* the options end at "--", the rest is passed to the plugin */
+    int optionCount = argc;
+    for (int i=1; i<argc; i++)
+    {
+        if (strcmp(argv[i], "--") == 0)
+        {
+            optionCount = i;
+            break;
+        }
+    }
+    int extraArgc = (optionCount < argc) ? (argc - optionCount - 1) : 0;
+    char** extraArgv = &argv[(optionCount < argc) ? (optionCount + 1) : argc];
+    parseArgs(optionCount, argv);
+
+    char tempDir[] = "/tmp/capturesoak.XXXXXX";
+    if (mkdtemp(tempDir) == NULL)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    char fifoPath[sizeof(tempDir) + 16];
+    snprintf(fifoPath, sizeof(fifoPath), "%s/capture.fifo", tempDir);
+    signal(SIGPIPE, SIG_IGN);
+    if (mkfifo(fifoPath, 0600) != 0)
+    {
+        perror(fifoPath);
+        rmdir(tempDir);
+        return 1;
+    }
+
+    int failed = 1;
+    char portPath[128];
+    pid_t simulator = startSimulator(portPath, sizeof(portPath));
+    if (simulator > 0)
+    {
+        pid_t plugin = startPlugin(portPath, fifoPath, extraArgc, extraArgv);
+        int fifoFd = (plugin > 0) ? open(fifoPath, O_RDONLY) : -1;
+        if (fifoFd >= 0)
+        {
+            failed = (soak(fifoFd, plugin) == 0) ? 0 : 1;
+            kill(plugin, SIGTERM);
+            waitpid(plugin, NULL, 0);
+            close(fifoFd);
+        }
+        else if (plugin > 0)
+        {
+            perror(fifoPath);
+            kill(plugin, SIGTERM);
+            waitpid(plugin, NULL, 0);
+        }
+        kill(simulator, SIGTERM);
+        waitpid(simulator, NULL, 0);
+    }
+    unlink(fifoPath);
+    rmdir(tempDir);
+
+    if (failed == 0)
+    {
+        failed += checkTrend("RSS kB", offsetof(SampleType, rssKB), (double)mConfig.maxRssGrowthKB);
+        failed += checkTrend("fds", offsetof(SampleType, fds), (double)mConfig.maxFdGrowth);
+        failed += checkTrend("lag ms", offsetof(SampleType, maxLagMS), (double)mConfig.maxLagGrowthMS);
+    }
+    printf("soak test %s\n", (failed == 0) ? "passed" : "failed");
+    return (failed == 0) ? 0 : 1;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
@@ -0,0 +1,142 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \brief Unit tests of the timestampunwrapper module. Every test passes the
+ *        lower 32 bits of known 64 bit timestamps together with the host time
+ *        of their reception and compares the extended timestamps.
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <stdint.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "timestampunwrapper.h"
+#include "testcheck.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+#define WRAP_MICROS             (1ULL << 32)
+#define ONE_HOUR_MICROS         (3600000000ULL)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * V A R I A B L E S   A N D   C O N S T A N T S   S E C T I O N * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   V A R I A B L E   D E F I N I T I O N S * * * * * * * * * * * */
+static TSUW_UnwrapperType mUnwrapper;
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+/** Passes the lower bits of extendedMicros, received latencyMillis after the
+ * device took it. The host clock started at hostStartMillis together with
+ * the device clock. */
+static uint64_t receive(uint64_t extendedMicros,
+                        uint32_t hostStartMillis,
+                        uint32_t latencyMillis)
+{
+    uint32_t hostMillis = hostStartMillis + (uint32_t)(extendedMicros / 1000ULL) + latencyMillis;
+    return TSUW_Unwrap(&mUnwrapper, (uint32_t)extendedMicros, hostMillis);
+}
+
+static int testSteadyFrames(void)
+{
+    TSUW_Init(&mUnwrapper, 0, 0);
+    for (uint64_t micros=1000; micros<3*WRAP_MICROS; micros+=1000000)
+    {
+        CHECK(receive(micros, 0, 2) == micros);
+    }
+    return 0;
+}
+
+static int testWrapsWhileQuiet(void)
+{
+    TSUW_Init(&mUnwrapper, 5000, 0);
+    CHECK(receive(10000, 0, 0) == 10000);
+    /* no frame for more than three wrap periods */
+    CHECK(receive(3*WRAP_MICROS + 20000, 0, 1) == 3*WRAP_MICROS + 20000);
+    /* the lower bits are the same after exactly one wrap period */
+    CHECK(receive(4*WRAP_MICROS + 20000, 0, 1) == 4*WRAP_MICROS + 20000);
+    return 0;
+}
+
+static int testQueuedFrames(void)
+{
+    TSUW_Init(&mUnwrapper, (uint32_t)(WRAP_MICROS - 1000000), 0);
+    /* the frames around the wrap are decoded ten minutes late at once */
+    uint32_t hostMillis = 1000 + 10*60*1000;
+    CHECK(TSUW_Unwrap(&mUnwrapper, (uint32_t)(WRAP_MICROS - 1000), hostMillis) == WRAP_MICROS - 1000);
+    CHECK(TSUW_Unwrap(&mUnwrapper, 500, hostMillis) == WRAP_MICROS + 500);
+    CHECK(TSUW_Unwrap(&mUnwrapper, 900000, hostMillis) == WRAP_MICROS + 900000);
+    /* and the queue is empty afterwards */
+    CHECK(TSUW_Unwrap(&mUnwrapper, (uint32_t)ONE_HOUR_MICROS, 1000 + 3600000) == WRAP_MICROS + ONE_HOUR_MICROS);
+    return 0;
+}
+
+static int testHostClockWraps(void)
+{
+    /* the monotonic millis of the host wrap after 49.7 days */
+    uint32_t hostStartMillis = UINT32_MAX - 1000;
+    TSUW_Init(&mUnwrapper, 0, hostStartMillis);
+    CHECK(receive(500000, hostStartMillis, 0) == 500000);
+    CHECK(receive(WRAP_MICROS + 7000, hostStartMillis, 0) == WRAP_MICROS + 7000);
+    return 0;
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int main(void)
+{
+    static const TEST_FunctionType TESTS[] = {
+        testSteadyFrames,
+        testWrapsWhileQuiet,
+        testQueuedFrames,
+        testHostClockWraps
+    };
+    return TEST_RUN_ALL(TESTS);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
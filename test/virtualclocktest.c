@@ -0,0 +1,162 @@
+/* L I C E N S E * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2025 michael0710
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * M O D U L E   I N F O R M A T I O N * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+/**
+ * \file
+ * \brief Unit tests of the timeouts on the virtual clock of the system
+ *        utilities. The waits of hours and the overflows of the millisecond
+ *        counter pass in a fraction of a second of real time.
+ */
+/* ************************************************************************* */
+
+/* ***************************************************************************
+ * I N C L U D E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* S Y S T E M   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * * */
+#include <limits.h>
+#include <stdbool.h>
+
+/* P R O J E C T   I N C L U D E S * * * * * * * * * * * * * * * * * * * * * */
+#include "capturinoconn.h"
+#include "eventloop.h"
+#include "systemutils.h"
+#include "testcheck.h"
+
+/* ***************************************************************************
+ * D E F I N E   S E C T I O N * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   C O N F I G   D E F I N I T I O N S * * * * * * * * * * * * * */
+#define ONE_HOUR_MILLIS         (3600000UL)
+/** CCON_Wait() sleeps in steps of 10 ms */
+#define WAIT_STEP_MILLIS        (10UL)
+
+/* L O C A L   M A C R O   D E F I N I T I O N S * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * F U N C T I O N S   S E C T I O N * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */
+
+/* L O C A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * * */
+static unsigned long getMillis(void)
+{
+    unsigned long millis;
+    SYSU_GetCurrentMillis(&millis);
+    return millis;
+}
+
+static int testSleepAdvancesClock(void)
+{
+    SYSU_SetVirtualMillis(1000);
+    CHECK(getMillis() == 1000);
+    SYSU_Sleep(5000);
+    CHECK(getMillis() == 6000);
+    SYSU_AdvanceVirtualMillis(ONE_HOUR_MILLIS);
+    CHECK(getMillis() == 6000 + ONE_HOUR_MILLIS);
+    return 0;
+}
+
+/** Waits for timeMS starting at startMillis and checks the elapsed time. */
+static int checkWait(unsigned long startMillis,
+                     unsigned long timeMS)
+{
+    volatile bool terminateFlag = false;
+    SYSU_SetVirtualMillis(startMillis);
+    CHECK(CCON_Wait(timeMS, &terminateFlag) == 0);
+    unsigned long elapsedMillis = getMillis() - startMillis;
+    CHECK(elapsedMillis >= timeMS);
+    CHECK(elapsedMillis <= timeMS + WAIT_STEP_MILLIS);
+    return 0;
+}
+
+static int testWaitHours(void)
+{
+    CHECK(checkWait(0, 4 * ONE_HOUR_MILLIS) == 0);
+    return 0;
+}
+
+static int testWaitAcrossOverflow(void)
+{
+    /* the deadline lies right after the overflow */
+    CHECK(checkWait(ULONG_MAX - 1000UL, 5000) == 0);
+    /* the first sleep steps over both the overflow and the deadline */
+    CHECK(checkWait(ULONG_MAX - 2UL, 5) == 0);
+    CHECK(checkWait(ULONG_MAX, 0) == 0);
+    return 0;
+}
+
+static int testWaitTerminated(void)
+{
+    volatile bool terminateFlag = true;
+    SYSU_SetVirtualMillis(0);
+    CHECK(CCON_Wait(ONE_HOUR_MILLIS, &terminateFlag) == 0);
+    CHECK(getMillis() == 0);
+    return 0;
+}
+
+static int testEventLoopTimeout(void)
+{
+    EventLoopHandleType eventLoop;
+    CHECK(EVLP_Open(&eventLoop) == 0);
+    SYSU_SetVirtualMillis(0);
+
+    EVLP_WaitResultType result = EVLP_READABLE;
+    CHECK(EVLP_Wait(eventLoop, 5000, &result) == 0);
+    CHECK(result == EVLP_TIMEOUT);
+    CHECK(getMillis() == 5000);
+
+    /* a pending wakeup returns before the timeout */
+    CHECK(EVLP_Wakeup(eventLoop) == 0);
+    CHECK(EVLP_Wait(eventLoop, 5000, &result) == 0);
+    CHECK(result == EVLP_WAKEUP);
+    CHECK(getMillis() == 5000);
+
+    CHECK(EVLP_Close(eventLoop) == 0);
+    return 0;
+}
+
+/* G L O B A L   F U N C T I O N   D E F I N I T I O N S * * * * * * * * * * */
+int main(void)
+{
+    static const TEST_FunctionType TESTS[] = {
+        testSleepAdvancesClock,
+        testWaitHours,
+        testWaitAcrossOverflow,
+        testWaitTerminated,
+        testEventLoopTimeout
+    };
+    return TEST_RUN_ALL(TESTS);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* ***************************************************************************
+ * E N D   O F   F I L E * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *************************************************************************** */